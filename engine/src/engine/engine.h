@@ -1,23 +1,62 @@
 #pragma once
 
+#include <atomic>
+#include <filesystem>
+
 #include "engine/indexing/inverted_index.h"
+#include "engine/indexing/posting_cache.h"
+#include "engine/indexing/segmented_index.h"
 #include "linguistics/preprocessor.h"
 #include "storage/doc_storage.h"
 #include "storage/document.h"
+#include "storage/forward_index.h"
 #include "storage/index_storage.h"
+#include "utils/lru_cache.h"
+#include "utils/thread_pool.h"
 
 struct SearchResult {
   storage::Document doc;
   std::string snippet;
 };
 
+// Searches are safe to run from concurrent threads, also alongside Update,
+// DeleteDocument and UpdateDocument. BuildIndex and LoadIndex are not.
 class Engine {
  public:
+  using ResultCache = utils::LruCache<std::string, std::vector<SearchResult>>;
+
+  // Documents and queries are split into terms by `preprocessor`. Built
+  // indexes and segments are encoded with `codec`. Results of the
+  // last `cache_capacity` distinct queries are cached until the index
+  // changes, hot posting lists are kept decoded within
+  // `posting_cache_budget` bytes.
   Engine(std::unique_ptr<storage::DocStorage>&& storage,
-         std::unique_ptr<storage::IndexStorage>&& index);
+         std::unique_ptr<storage::IndexStorage>&& index,
+         std::unique_ptr<storage::ForwardIndex>&& forward_index,
+         linguistics::Preprocessor&& preprocessor,
+         const std::filesystem::path& segments_dir,
+         indexing::CodecType codec = indexing::CodecType::kVByte,
+         size_t cache_capacity = 4096, size_t posting_cache_budget = 64 << 20);
 
-  void BuildIndex();
+  // Documents are preprocessed by `threads` workers into partial indexes,
+  // which are merged at the end. With a nonzero `memory_budget` in bytes the
+  // partial indexes are flushed to disk as sorted runs whenever they grow
+  // past it, and the runs are merged into the index file. With a nonempty
+  // `doc_file` the documents are also written into a local document file,
+  // see storage::FileDocStorage.
+  void BuildIndex(size_t threads = 1, size_t memory_budget = 0,
+                  const std::filesystem::path& doc_file = {});
   void LoadIndex();
+  // Indexes documents added to the storage after the last indexed one into
+  // a new segment, returns their count. Safe to call concurrently with
+  // searches.
+  size_t Update();
+  // Drops the document from the results, returns false if it isn't indexed.
+  // The deletion is saved by the next Update.
+  bool DeleteDocument(indexing::DocID doc_id);
+  // Reindexes a changed document, e.g. a re-crawled page. It's searchable
+  // after the next Update.
+  void UpdateDocument(const storage::Document& doc);
 
   std::vector<SearchResult> SearchBoolean(const std::string& query,
                                           size_t limit = SIZE_MAX) const;
@@ -25,20 +64,64 @@ class Engine {
   std::vector<SearchResult> SearchRanked(const std::string& query,
                                          size_t limit = SIZE_MAX) const;
 
+  std::string ExplainBoolean(const std::string& query) const;
+
+  ResultCache::Stats GetCacheStats() const;
+  indexing::PostingCache::Stats GetPostingCacheStats() const;
+
  private:
+  // The base index followed by the segments of the snapshot
+  std::vector<const indexing::InvertedIndex*> GetSegments(
+      const indexing::SegmentedIndex::Snapshot& snapshot) const;
+
   std::vector<storage::Document> GetDocsFromIDs(
       const std::vector<indexing::DocID>& doc_ids) const;
 
+  // Cached results of the query, computed by `search` on a miss
+  template <typename Search>
+  std::vector<SearchResult> SearchCached(const std::string& key,
+                                         Search&& search) const;
+
+  // Documents with their snippets, in the order of `doc_ids`. Chunks of the
+  // results are fetched and snippeted in parallel.
+  std::vector<SearchResult> FetchResults(
+      const std::vector<const indexing::InvertedIndex*>& segments,
+      const std::vector<indexing::DocID>& doc_ids,
+      const std::vector<std::string>& query_terms) const;
+
   std::vector<SearchResult> BuildSnippets(
+      const std::vector<const indexing::InvertedIndex*>& segments,
       const std::vector<storage::Document>& docs,
       const std::vector<std::string>& query_terms,
       size_t window_size = 16) const;
 
+  // Shared by concurrent searches and updates
   std::unique_ptr<storage::DocStorage> doc_storage_;
   std::unique_ptr<storage::IndexStorage> index_storage_;
+  // Term byte ranges of the indexed documents, snippets are cut by them
+  std::unique_ptr<storage::ForwardIndex> forward_index_;
+  const indexing::CodecType codec_;
 
   indexing::InvertedIndex index_;
+  // Documents were deleted from index_ since its deletions were saved
+  std::atomic<bool> deletions_dirty_ = false;
+  // Documents indexed after the last full build
+  indexing::SegmentedIndex segments_;
   linguistics::Preprocessor preprocessor_;
+
+  mutable ResultCache result_cache_;
+  mutable indexing::PostingCache posting_cache_;
+  // Documents were updated since the last Update
+  std::atomic<bool> updates_pending_ = false;
+
+  // Fetches documents and builds snippets of concurrent searches, destroyed
+  // first as its tasks use the rest
+  mutable utils::ThreadPool fetch_pool_;
 };
 
-Engine CreateEngine();
+// Documents are read from the local document file `doc_file` when it's set,
+// from MongoDB otherwise
+Engine CreateEngine(indexing::CodecType codec = indexing::CodecType::kVByte,
+                    size_t cache_capacity = 4096,
+                    size_t posting_cache_budget = 64 << 20,
+                    const std::filesystem::path& doc_file = {});
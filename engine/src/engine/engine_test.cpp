@@ -0,0 +1,138 @@
+#include "engine/engine.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <mutex>
+
+#include "linguistics/lemmatization/mock_lemmatizer.h"
+#include "linguistics/tokenization/tokenizer_impl.h"
+#include "storage/file_index_storage.h"
+
+namespace {
+
+// Documents kept in memory, more can be added between updates
+class MemoryDocStorage : public storage::DocStorage {
+ public:
+  void Add(const storage::Document& doc) {
+    std::lock_guard lock(mutex_);
+    docs_[doc.id] = doc;
+  }
+
+  void Remove(int32_t doc_id) {
+    std::lock_guard lock(mutex_);
+    docs_.erase(doc_id);
+  }
+
+  std::unique_ptr<Cursor> GetCursor() const override {
+    return GetCursorAfter(-1);
+  }
+
+  std::unique_ptr<Cursor> GetCursorAfter(int32_t doc_id) const override {
+    std::lock_guard lock(mutex_);
+    std::vector<storage::Document> docs;
+    for (auto it = docs_.upper_bound(doc_id); it != docs_.end(); ++it) {
+      docs.push_back(it->second);
+    }
+    return std::make_unique<VectorCursor>(std::move(docs));
+  }
+
+  storage::Document GetDocByID(int32_t doc_id) const override {
+    std::lock_guard lock(mutex_);
+    return docs_.at(doc_id);
+  }
+
+  std::vector<storage::Document> GetDocsByIDs(
+      const std::vector<int32_t>& doc_ids) const override {
+    std::lock_guard lock(mutex_);
+    std::vector<storage::Document> result;
+    for (const auto doc_id : doc_ids) {
+      if (const auto it = docs_.find(doc_id); it != docs_.end()) {
+        result.push_back(it->second);
+      }
+    }
+    return result;
+  }
+
+ private:
+  class VectorCursor : public Cursor {
+   public:
+    explicit VectorCursor(std::vector<storage::Document>&& docs)
+        : docs_(std::move(docs)) {}
+
+    std::optional<storage::Document> Next() override {
+      if (next_ == docs_.size()) {
+        return std::nullopt;
+      }
+      return docs_[next_++];
+    }
+
+   private:
+    std::vector<storage::Document> docs_;
+    size_t next_ = 0;
+  };
+
+  mutable std::mutex mutex_;
+  std::map<int32_t, storage::Document> docs_;
+};
+
+}  // namespace
+
+class EngineTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir = std::filesystem::temp_directory_path() / "engine_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    auto storage = std::make_unique<MemoryDocStorage>();
+    docs = storage.get();
+    engine = std::make_unique<Engine>(
+        std::move(storage),
+        std::make_unique<storage::FileIndexStorage>(dir / "index.bin"),
+        std::make_unique<storage::ForwardIndex>(dir / "forward.bin"),
+        linguistics::Preprocessor(
+            std::make_unique<linguistics::TokenizerImpl>(),
+            std::make_unique<linguistics::MockLemmatizer>()),
+        dir / "segments");
+  }
+
+  void TearDown() override {
+    engine.reset();
+    std::filesystem::remove_all(dir);
+  }
+
+  std::filesystem::path dir;
+  MemoryDocStorage* docs;
+  std::unique_ptr<Engine> engine;
+};
+
+TEST_F(EngineTest, SearchAfterUpdate) {
+  docs->Add({0, "https://a", "alpha beta"});
+  docs->Add({1, "https://b", "alpha"});
+  engine->BuildIndex();
+
+  // The new segment lacks "beta"
+  docs->Add({2, "https://c", "alpha gamma"});
+  EXPECT_EQ(engine->Update(), 1);
+
+  const auto results = engine->SearchRanked("alpha beta");
+  ASSERT_FALSE(results.empty());
+  EXPECT_EQ(results.front().doc.id, 0);
+  const auto boolean = engine->SearchBoolean("alpha");
+  EXPECT_EQ(boolean.size(), 3);
+}
+
+TEST_F(EngineTest, SkipsDocumentsMissingFromStorage) {
+  docs->Add({0, "https://a", "alpha"});
+  docs->Add({1, "https://b", "alpha"});
+  docs->Add({2, "https://c", "alpha"});
+  engine->BuildIndex();
+
+  // Removed from the storage while still indexed
+  docs->Remove(1);
+  const auto results = engine->SearchBoolean("alpha");
+  ASSERT_EQ(results.size(), 2);
+  EXPECT_EQ(results[0].doc.id, 0);
+  EXPECT_EQ(results[1].doc.id, 2);
+}
@@ -0,0 +1,191 @@
+#include "engine/indexing/bit_packing.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define INDEXING_X86 1
+#endif
+
+namespace {
+
+using indexing::kBitPackingFrame;
+
+constexpr size_t kLanes = 4;
+constexpr size_t kRows = kBitPackingFrame / kLanes;
+
+uint32_t Mask(uint32_t bits) {
+  return bits == 32 ? UINT32_MAX : (1u << bits) - 1;
+}
+
+uint32_t LoadWord(const uint8_t* in, size_t idx) {
+  uint32_t word;
+  std::memcpy(&word, in + idx * sizeof(word), sizeof(word));
+  return word;
+}
+
+void UnpackScalar(const uint8_t* in, uint32_t bits, uint32_t* values) {
+  const uint32_t mask = Mask(bits);
+  for (size_t row = 0; row < kRows; ++row) {
+    const size_t word = row * bits / 32;
+    const uint32_t shift = row * bits % 32;
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      uint64_t value = LoadWord(in, word * kLanes + lane) >> shift;
+      if (shift + bits > 32) {
+        value |= static_cast<uint64_t>(
+                     LoadWord(in, (word + 1) * kLanes + lane))
+                 << (32 - shift);
+      }
+      values[row * kLanes + lane] = static_cast<uint32_t>(value) & mask;
+    }
+  }
+}
+
+#ifdef INDEXING_X86
+
+__attribute__((target("sse2"))) void UnpackSse2(const uint8_t* in,
+                                                uint32_t bits,
+                                                uint32_t* values) {
+  const auto* words = reinterpret_cast<const __m128i*>(in);
+  const __m128i mask = _mm_set1_epi32(static_cast<int>(Mask(bits)));
+  __m128i current = _mm_loadu_si128(words);
+  uint32_t shift = 0;
+  for (size_t row = 0; row < kRows; ++row) {
+    __m128i value = _mm_srl_epi32(current, _mm_cvtsi32_si128(shift));
+    shift += bits;
+    if (shift >= 32 && row + 1 < kRows) {
+      // The row ends in, or right before, the next word
+      shift -= 32;
+      current = _mm_loadu_si128(++words);
+      if (shift > 0) {
+        value = _mm_or_si128(
+            value, _mm_sll_epi32(current, _mm_cvtsi32_si128(bits - shift)));
+      }
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(values + row * kLanes),
+                     _mm_and_si128(value, mask));
+  }
+}
+
+// Two rows per step: the words holding them are loaded into the halves of
+// one register and shifted per lane. Shifts by 32 and more give zero, which
+// drops the carry of the rows that don't cross a word.
+__attribute__((target("avx2"))) void UnpackAvx2(const uint8_t* in,
+                                                uint32_t bits,
+                                                uint32_t* values) {
+  const auto* words = reinterpret_cast<const __m128i*>(in);
+  const __m256i mask = _mm256_set1_epi32(static_cast<int>(Mask(bits)));
+  for (size_t row = 0; row < kRows; row += 2) {
+    const uint32_t low_bit = row * bits;
+    const uint32_t high_bit = low_bit + bits;
+    const uint32_t low_shift = low_bit % 32;
+    const uint32_t high_shift = high_bit % 32;
+    const size_t low_word = low_bit / 32;
+    const size_t high_word = high_bit / 32;
+    const bool low_carry = low_shift + bits > 32;
+    const bool high_carry = high_shift + bits > 32;
+
+    const __m256i current =
+        _mm256_set_m128i(_mm_loadu_si128(words + high_word),
+                         _mm_loadu_si128(words + low_word));
+    const __m256i next = _mm256_set_m128i(
+        _mm_loadu_si128(words + high_word + (high_carry ? 1 : 0)),
+        _mm_loadu_si128(words + low_word + (low_carry ? 1 : 0)));
+    const __m256i right = _mm256_set_epi32(
+        high_shift, high_shift, high_shift, high_shift, low_shift, low_shift,
+        low_shift, low_shift);
+    const uint32_t low_left = low_carry ? 32 - low_shift : 32;
+    const uint32_t high_left = high_carry ? 32 - high_shift : 32;
+    const __m256i left =
+        _mm256_set_epi32(high_left, high_left, high_left, high_left, low_left,
+                         low_left, low_left, low_left);
+
+    const __m256i value = _mm256_or_si256(_mm256_srlv_epi32(current, right),
+                                          _mm256_sllv_epi32(next, left));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(values + row * kLanes),
+                        _mm256_and_si256(value, mask));
+  }
+}
+
+#endif
+
+}  // namespace
+
+namespace indexing {
+
+SimdKernel DetectSimdKernel() {
+#ifdef INDEXING_X86
+  static const SimdKernel kernel = [] {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+      return SimdKernel::kAvx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+      return SimdKernel::kSse2;
+    }
+    return SimdKernel::kScalar;
+  }();
+  return kernel;
+#else
+  return SimdKernel::kScalar;
+#endif
+}
+
+uint32_t BitWidth(const uint32_t* values) {
+  uint32_t acc = 0;
+  for (size_t i = 0; i < kBitPackingFrame; ++i) {
+    acc |= values[i];
+  }
+  return std::bit_width(acc);
+}
+
+void BitPack(const uint32_t* values, uint32_t bits, uint8_t* out) {
+  if (bits == 0) {
+    return;
+  }
+  std::memset(out, 0, BitPackedSize(bits));
+  for (size_t row = 0; row < kRows; ++row) {
+    const size_t word = row * bits / 32;
+    const uint32_t shift = row * bits % 32;
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      const uint64_t value = static_cast<uint64_t>(
+                                 values[row * kLanes + lane] & Mask(bits))
+                             << shift;
+      const size_t low = word * kLanes + lane;
+      const uint32_t low_word = LoadWord(out, low) |
+                                static_cast<uint32_t>(value);
+      std::memcpy(out + low * sizeof(uint32_t), &low_word, sizeof(low_word));
+      if (shift + bits > 32) {
+        const size_t high = (word + 1) * kLanes + lane;
+        const uint32_t high_word =
+            LoadWord(out, high) | static_cast<uint32_t>(value >> 32);
+        std::memcpy(out + high * sizeof(uint32_t), &high_word,
+                    sizeof(high_word));
+      }
+    }
+  }
+}
+
+void BitUnpack(const uint8_t* in, uint32_t bits, uint32_t* values,
+               SimdKernel kernel /* = DetectSimdKernel() */) {
+  if (bits == 0) {
+    std::fill_n(values, kBitPackingFrame, 0);
+    return;
+  }
+  switch (kernel) {
+#ifdef INDEXING_X86
+    case SimdKernel::kAvx2:
+      UnpackAvx2(in, bits, values);
+      return;
+    case SimdKernel::kSse2:
+      UnpackSse2(in, bits, values);
+      return;
+#endif
+    default:
+      UnpackScalar(in, bits, values);
+  }
+}
+
+}  // namespace indexing
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace indexing {
+
+// Values packed together at a common bit width. A frame is laid out in four
+// 32-bit lanes: value i goes to lane i % 4, so a row of four values is
+// unpacked by one SSE instruction sequence.
+inline constexpr size_t kBitPackingFrame = 128;
+
+// Implementations of BitUnpack, all producing the same output
+enum class SimdKernel {
+  kScalar,
+  kSse2,
+  kAvx2,
+};
+
+// Fastest kernel supported by the CPU, detected once
+SimdKernel DetectSimdKernel();
+
+// Bits needed for the largest of kBitPackingFrame values
+uint32_t BitWidth(const uint32_t* values);
+// Bytes taken by a frame packed to `bits`
+constexpr size_t BitPackedSize(uint32_t bits) {
+  return kBitPackingFrame * bits / 8;
+}
+
+// Packs kBitPackingFrame values to BitPackedSize(bits) bytes
+void BitPack(const uint32_t* values, uint32_t bits, uint8_t* out);
+// Unpacks kBitPackingFrame values, `in` needs no alignment
+void BitUnpack(const uint8_t* in, uint32_t bits, uint32_t* values,
+               SimdKernel kernel = DetectSimdKernel());
+
+}  // namespace indexing
@@ -0,0 +1,390 @@
+#include "engine/indexing/bitmap_container.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+#include "engine/indexing/codec.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define INDEXING_X86 1
+#endif
+
+namespace {
+
+using indexing::kBitmapWordBits;
+
+enum class WordOp {
+  kAnd,
+  kOr,
+  kAndNot,
+};
+
+[[noreturn]] void ThrowCorrupted() {
+  throw std::runtime_error("BitmapContainer: corrupted input");
+}
+
+uint64_t LoadWord(const uint8_t* in, size_t idx) {
+  uint64_t word;
+  std::memcpy(&word, in + idx * sizeof(word), sizeof(word));
+  return word;
+}
+
+// Bits [from, to) of a word, `to` up to kBitmapWordBits
+uint64_t RangeMask(size_t from, size_t to) {
+  const uint64_t high =
+      to == kBitmapWordBits ? ~uint64_t{0} : (uint64_t{1} << to) - 1;
+  return high & (~uint64_t{0} << from);
+}
+
+// Sets bits [from, to) of `words`, growing it as needed
+void SetRange(size_t from, size_t to, std::vector<uint64_t>& words) {
+  if (from >= to) {
+    return;
+  }
+  if (words.size() * kBitmapWordBits < to) {
+    words.resize((to + kBitmapWordBits - 1) / kBitmapWordBits);
+  }
+  for (size_t word = from / kBitmapWordBits; word * kBitmapWordBits < to;
+       ++word) {
+    const size_t begin = std::max(from, word * kBitmapWordBits);
+    const size_t end = std::min(to, (word + 1) * kBitmapWordBits);
+    words[word] |= RangeMask(begin - word * kBitmapWordBits,
+                             end - word * kBitmapWordBits);
+  }
+}
+
+template <WordOp op>
+uint64_t Apply(uint64_t a, uint64_t b) {
+  if constexpr (op == WordOp::kAnd) {
+    return a & b;
+  } else if constexpr (op == WordOp::kOr) {
+    return a | b;
+  } else {
+    return a & ~b;
+  }
+}
+
+template <WordOp op>
+void ApplyScalar(const uint64_t* a, const uint64_t* b, uint64_t* out,
+                 size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    out[i] = Apply<op>(a[i], b[i]);
+  }
+}
+
+#ifdef INDEXING_X86
+
+template <WordOp op>
+__attribute__((target("sse2"))) void ApplySse2(const uint64_t* a,
+                                               const uint64_t* b,
+                                               uint64_t* out, size_t size) {
+  constexpr size_t kStep = sizeof(__m128i) / sizeof(uint64_t);
+  size_t i = 0;
+  for (; i + kStep <= size; i += kStep) {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    __m128i value;
+    if constexpr (op == WordOp::kAnd) {
+      value = _mm_and_si128(x, y);
+    } else if constexpr (op == WordOp::kOr) {
+      value = _mm_or_si128(x, y);
+    } else {
+      value = _mm_andnot_si128(y, x);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), value);
+  }
+  ApplyScalar<op>(a + i, b + i, out + i, size - i);
+}
+
+template <WordOp op>
+__attribute__((target("avx2"))) void ApplyAvx2(const uint64_t* a,
+                                               const uint64_t* b,
+                                               uint64_t* out, size_t size) {
+  constexpr size_t kStep = sizeof(__m256i) / sizeof(uint64_t);
+  size_t i = 0;
+  for (; i + kStep <= size; i += kStep) {
+    const __m256i x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    const __m256i y =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    __m256i value;
+    if constexpr (op == WordOp::kAnd) {
+      value = _mm256_and_si256(x, y);
+    } else if constexpr (op == WordOp::kOr) {
+      value = _mm256_or_si256(x, y);
+    } else {
+      value = _mm256_andnot_si256(y, x);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), value);
+  }
+  ApplyScalar<op>(a + i, b + i, out + i, size - i);
+}
+
+#endif
+
+template <WordOp op>
+void ApplyWords(std::span<const uint64_t> a, std::span<const uint64_t> b,
+                std::span<uint64_t> out, indexing::SimdKernel kernel) {
+  if (a.size() != b.size() || a.size() != out.size()) {
+    throw std::invalid_argument("BitmapContainer: bitmaps differ in size");
+  }
+  switch (kernel) {
+#ifdef INDEXING_X86
+    case indexing::SimdKernel::kAvx2:
+      ApplyAvx2<op>(a.data(), b.data(), out.data(), out.size());
+      return;
+    case indexing::SimdKernel::kSse2:
+      ApplySse2<op>(a.data(), b.data(), out.data(), out.size());
+      return;
+#endif
+    default:
+      ApplyScalar<op>(a.data(), b.data(), out.data(), out.size());
+  }
+}
+
+}  // namespace
+
+namespace indexing {
+
+void ContainerEncode(std::span<const DocID> docs, std::vector<uint8_t>& out) {
+  const auto& vbyte = GetCodec(CodecType::kVByte);
+  if (docs.empty()) {
+    out.push_back(static_cast<uint8_t>(ContainerType::kRuns));
+    vbyte.Encode(std::vector<uint32_t>{0}, out);
+    return;
+  }
+
+  std::vector<uint32_t> runs;
+  runs.push_back(0);
+  DocID run_start = docs[0];
+  DocID last = docs[0];
+  DocID run_end = docs[0];
+  for (size_t i = 1; i <= docs.size(); ++i) {
+    if (i < docs.size() && docs[i] == last + 1) {
+      last = docs[i];
+      continue;
+    }
+    runs.push_back(run_start - run_end);
+    runs.push_back(last - run_start);
+    run_end = last + 1;
+    if (i < docs.size()) {
+      run_start = last = docs[i];
+    }
+  }
+  runs[0] = static_cast<uint32_t>(runs.size() / 2);
+
+  std::vector<uint8_t> encoded_runs;
+  vbyte.Encode(runs, encoded_runs);
+  const size_t first_word = docs.front() / kBitmapWordBits;
+  const size_t words_count = docs.back() / kBitmapWordBits - first_word + 1;
+  if (encoded_runs.size() <= words_count * sizeof(uint64_t)) {
+    out.push_back(static_cast<uint8_t>(ContainerType::kRuns));
+    out.insert(out.end(), encoded_runs.begin(), encoded_runs.end());
+    return;
+  }
+
+  std::vector<uint64_t> words(words_count);
+  for (const auto doc_id : docs) {
+    const size_t bit = doc_id - first_word * kBitmapWordBits;
+    words[bit / kBitmapWordBits] |= uint64_t{1} << (bit % kBitmapWordBits);
+  }
+  out.push_back(static_cast<uint8_t>(ContainerType::kBitmap));
+  const auto count = static_cast<uint32_t>(words_count);
+  vbyte.Encode({&count, 1}, out);
+  const size_t offset = out.size();
+  out.resize(offset + words.size() * sizeof(uint64_t));
+  std::memcpy(out.data() + offset, words.data(),
+              words.size() * sizeof(uint64_t));
+}
+
+ContainerReader::ContainerReader(std::span<const uint8_t> in, DocID first,
+                                 size_t count)
+    : count_(count), first_(first) {
+  if (in.empty() || in[0] > static_cast<uint8_t>(ContainerType::kRuns)) {
+    ThrowCorrupted();
+  }
+  type_ = static_cast<ContainerType>(in[0]);
+  uint32_t size = 0;
+  const size_t idx =
+      1 + GetCodec(CodecType::kVByte).Decode(in.subspan(1), {&size, 1});
+  data_ = in.data() + idx;
+  data_size_ = in.size() - idx;
+
+  if (type_ == ContainerType::kBitmap) {
+    first_word_ = first / kBitmapWordBits;
+    words_count_ = size;
+    if (data_size_ / sizeof(uint64_t) < words_count_) {
+      ThrowCorrupted();
+    }
+    if (count_ > 0) {
+      SeekOne(first - first_word_ * kBitmapWordBits);
+    }
+    return;
+  }
+  if (count_ > 0 && size == 0) {
+    ThrowCorrupted();
+  }
+  run_end_ = first;
+  if (count_ > 0) {
+    LoadRun();
+    current_ = run_start_;
+  }
+}
+
+size_t ContainerReader::size() const { return count_; }
+
+size_t ContainerReader::position() const { return position_; }
+
+DocID ContainerReader::value() const {
+  if (type_ == ContainerType::kBitmap) {
+    return static_cast<DocID>(first_word_ * kBitmapWordBits + bit_);
+  }
+  return current_;
+}
+
+void ContainerReader::Next() {
+  if (++position_ >= count_) {
+    return;
+  }
+  if (type_ == ContainerType::kBitmap) {
+    SeekOne(bit_ + 1);
+  } else if (current_ + 1 < run_end_) {
+    ++current_;
+  } else {
+    LoadRun();
+    current_ = run_start_;
+  }
+}
+
+void ContainerReader::NextGEQ(DocID target) {
+  if (position_ >= count_ || value() >= target) {
+    return;
+  }
+
+  if (type_ == ContainerType::kBitmap) {
+    // Documents skipped over are counted a word at a time
+    const size_t bit = target - first_word_ * kBitmapWordBits;
+    if (bit >= words_count_ * kBitmapWordBits) {
+      position_ = count_;
+      return;
+    }
+    position_ += CountBits(bit_, bit);
+    if (position_ >= count_) {
+      position_ = count_;
+      return;
+    }
+    SeekOne(bit);
+    return;
+  }
+
+  while (run_end_ <= target) {
+    position_ += run_end_ - current_;
+    if (position_ >= count_) {
+      position_ = count_;
+      return;
+    }
+    LoadRun();
+    current_ = run_start_;
+  }
+  if (current_ < target) {
+    position_ += target - current_;
+    current_ = target;
+  }
+}
+
+void ContainerReader::FillWords(size_t first_word,
+                                std::vector<uint64_t>& words) const {
+  const size_t begin = first_word * kBitmapWordBits;
+  if (type_ == ContainerType::kBitmap) {
+    const size_t from = std::max(first_word_, first_word);
+    const size_t to = first_word_ + words_count_;
+    if (from >= to) {
+      return;
+    }
+    if (words.size() < to - first_word) {
+      words.resize(to - first_word);
+    }
+    for (size_t word = from; word < to; ++word) {
+      words[word - first_word] |= Word(word - first_word_);
+    }
+    return;
+  }
+
+  // Runs are read anew, the cursor is left where it is
+  ContainerReader runs = *this;
+  runs.next_run_ = 0;
+  runs.run_end_ = first_;
+  for (size_t position = 0; position < count_;) {
+    runs.LoadRun();
+    position += runs.run_end_ - runs.run_start_;
+    const size_t from = std::max<size_t>(runs.run_start_, begin);
+    SetRange(from - begin, std::max<size_t>(runs.run_end_, from) - begin,
+             words);
+  }
+}
+
+uint64_t ContainerReader::Word(size_t idx) const {
+  return LoadWord(data_, idx);
+}
+
+size_t ContainerReader::CountBits(size_t from, size_t to) const {
+  size_t count = 0;
+  for (size_t word = from / kBitmapWordBits; word * kBitmapWordBits < to;
+       ++word) {
+    const size_t begin = std::max(from, word * kBitmapWordBits);
+    const size_t end = std::min(to, (word + 1) * kBitmapWordBits);
+    count += std::popcount(Word(word) &
+                           RangeMask(begin - word * kBitmapWordBits,
+                                     end - word * kBitmapWordBits));
+  }
+  return count;
+}
+
+void ContainerReader::SeekOne(size_t bit) {
+  size_t word_idx = bit / kBitmapWordBits;
+  if (word_idx >= words_count_) {
+    ThrowCorrupted();
+  }
+  uint64_t word = Word(word_idx) & (~uint64_t{0} << (bit % kBitmapWordBits));
+  while (word == 0) {
+    if (++word_idx >= words_count_) {
+      ThrowCorrupted();
+    }
+    word = Word(word_idx);
+  }
+  bit_ = word_idx * kBitmapWordBits + std::countr_zero(word);
+}
+
+void ContainerReader::LoadRun() {
+  if (next_run_ > data_size_) {
+    ThrowCorrupted();
+  }
+  uint32_t run[2];
+  next_run_ += GetCodec(CodecType::kVByte)
+                   .Decode({data_ + next_run_, data_size_ - next_run_}, run);
+  run_start_ = run_end_ + run[0];
+  run_end_ = run_start_ + run[1] + 1;
+}
+
+void AndWords(std::span<const uint64_t> a, std::span<const uint64_t> b,
+              std::span<uint64_t> out,
+              SimdKernel kernel /* = DetectSimdKernel() */) {
+  ApplyWords<WordOp::kAnd>(a, b, out, kernel);
+}
+
+void OrWords(std::span<const uint64_t> a, std::span<const uint64_t> b,
+             std::span<uint64_t> out,
+             SimdKernel kernel /* = DetectSimdKernel() */) {
+  ApplyWords<WordOp::kOr>(a, b, out, kernel);
+}
+
+void AndNotWords(std::span<const uint64_t> a, std::span<const uint64_t> b,
+                 std::span<uint64_t> out,
+                 SimdKernel kernel /* = DetectSimdKernel() */) {
+  ApplyWords<WordOp::kAndNot>(a, b, out, kernel);
+}
+
+}  // namespace indexing
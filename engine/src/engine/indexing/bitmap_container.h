@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "engine/indexing/bit_packing.h"
+#include "engine/indexing/types.h"
+
+namespace indexing {
+
+// A partition of dense documents stored as a bitmap or as runs of
+// consecutive documents, whichever is smaller, as Roaring containers do.
+// Bitmap words are aligned to absolute doc ids, word i holding documents
+// from i * 64, so bitmaps of different lists line up for word-wise AND and
+// OR.
+//
+// Layout: ContainerType byte, then for a bitmap the VByte word count and
+// the 64-bit words from the word of the first document; for runs the VByte
+// run count and per run the VByte gap from the end of the previous run
+// (from the first document for the first run) and the length minus one.
+enum class ContainerType : uint8_t {
+  kBitmap = 0,
+  kRuns = 1,
+};
+
+inline constexpr size_t kBitmapWordBits = 64;
+
+// Appends the smallest container of increasing `docs`
+void ContainerEncode(std::span<const DocID> docs, std::vector<uint8_t>& out);
+
+// Forward cursor over an encoded container, starts at its first document
+class ContainerReader {
+ public:
+  ContainerReader() = default;
+  // `first` is the first of `count` documents. Throws if `in` ends before
+  // the container does.
+  ContainerReader(std::span<const uint8_t> in, DocID first, size_t count);
+
+  size_t size() const;
+  // Index of the current document, size() past the last one
+  size_t position() const;
+  DocID value() const;
+
+  void Next();
+  // Moves to the first document >= target, never backwards
+  void NextGEQ(DocID target);
+
+  // Sets the bits of all the documents of the container in `words`, which
+  // start at word `first_word` and are grown as needed. Documents before
+  // `first_word` are dropped.
+  void FillWords(size_t first_word, std::vector<uint64_t>& words) const;
+
+ private:
+  uint64_t Word(size_t idx) const;
+  // Set bits of the bitmap in [from, to)
+  size_t CountBits(size_t from, size_t to) const;
+  // Moves the bitmap to the first set bit at or after `bit`
+  void SeekOne(size_t bit);
+  void LoadRun();
+
+  ContainerType type_ = ContainerType::kBitmap;
+  const uint8_t* data_ = nullptr;
+  size_t data_size_ = 0;
+  size_t count_ = 0;
+  size_t position_ = 0;
+
+  // Bitmap: first word and the bit of the current document from it
+  size_t first_word_ = 0;
+  size_t words_count_ = 0;
+  size_t bit_ = 0;
+
+  // Runs: the current run, past its end the previous one, and the offset
+  // of the next one in `data_`
+  DocID first_ = 0;
+  size_t next_run_ = 0;
+  DocID run_start_ = 0;
+  DocID run_end_ = 0;
+  DocID current_ = 0;
+};
+
+// Word-wise operations over bitmaps of equal size, `out` may alias `a`
+void AndWords(std::span<const uint64_t> a, std::span<const uint64_t> b,
+              std::span<uint64_t> out, SimdKernel kernel = DetectSimdKernel());
+void OrWords(std::span<const uint64_t> a, std::span<const uint64_t> b,
+             std::span<uint64_t> out, SimdKernel kernel = DetectSimdKernel());
+void AndNotWords(std::span<const uint64_t> a, std::span<const uint64_t> b,
+                 std::span<uint64_t> out,
+                 SimdKernel kernel = DetectSimdKernel());
+
+}  // namespace indexing
@@ -0,0 +1,167 @@
+#include "engine/indexing/bitmap_container.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+
+using namespace indexing;
+
+namespace {
+
+// Runs of consecutive documents separated by gaps
+std::vector<DocID> RandomDocs(size_t size, uint32_t max_run, uint32_t max_gap,
+                              std::mt19937& rng) {
+  std::vector<DocID> docs;
+  DocID doc_id = rng() % 1000;
+  while (docs.size() < size) {
+    for (uint32_t run = 1 + rng() % max_run; run > 0 && docs.size() < size;
+         --run) {
+      docs.push_back(doc_id++);
+    }
+    doc_id += 1 + rng() % max_gap;
+  }
+  return docs;
+}
+
+}  // namespace
+
+TEST(BitmapContainerTest, RoundTrip) {
+  std::mt19937 rng(42);
+  for (const size_t size : {1, 2, 63, 64, 65, 1000}) {
+    for (const uint32_t max_run : {1, 4, 200}) {
+      for (const uint32_t max_gap : {1, 3, 100}) {
+        const auto docs = RandomDocs(size, max_run, max_gap, rng);
+        std::vector<uint8_t> encoded;
+        ContainerEncode(docs, encoded);
+
+        std::vector<DocID> decoded;
+        for (ContainerReader reader(encoded, docs.front(), size);
+             reader.position() < reader.size(); reader.Next()) {
+          decoded.push_back(reader.value());
+        }
+        EXPECT_EQ(decoded, docs);
+      }
+    }
+  }
+}
+
+TEST(BitmapContainerTest, PicksSmallest) {
+  std::vector<DocID> dense;
+  std::vector<DocID> runs;
+  for (DocID doc_id = 100; doc_id < 1100; ++doc_id) {
+    if (doc_id % 3 != 0) {
+      dense.push_back(doc_id);
+    }
+    runs.push_back(doc_id);
+  }
+
+  std::vector<uint8_t> encoded;
+  ContainerEncode(dense, encoded);
+  EXPECT_EQ(encoded[0], static_cast<uint8_t>(ContainerType::kBitmap));
+  EXPECT_LT(encoded.size(), dense.size() / 4);
+
+  encoded.clear();
+  ContainerEncode(runs, encoded);
+  EXPECT_EQ(encoded[0], static_cast<uint8_t>(ContainerType::kRuns));
+  EXPECT_LT(encoded.size(), 8);
+}
+
+TEST(BitmapContainerTest, NextGEQ) {
+  std::mt19937 rng(7);
+  for (const uint32_t max_run : {1, 3, 50}) {
+    const auto docs = RandomDocs(2000, max_run, 1 + max_run / 2, rng);
+    std::vector<uint8_t> encoded;
+    ContainerEncode(docs, encoded);
+
+    ContainerReader reader(encoded, docs.front(), docs.size());
+    for (DocID target = 0; target <= docs.back() + 1;
+         target += 1 + rng() % (3 * max_run)) {
+      reader.NextGEQ(target);
+      const auto itr = std::lower_bound(docs.begin(), docs.end(), target);
+      ASSERT_EQ(reader.position(), itr - docs.begin());
+      if (itr == docs.end()) {
+        break;
+      }
+      EXPECT_EQ(reader.value(), *itr);
+    }
+  }
+}
+
+TEST(BitmapContainerTest, FillWords) {
+  std::mt19937 rng(3);
+  for (const uint32_t max_run : {1, 100}) {
+    const auto docs = RandomDocs(500, max_run, 3, rng);
+    std::vector<uint8_t> encoded;
+    ContainerEncode(docs, encoded);
+
+    // Words start past the first documents, which are dropped
+    const size_t first_word = docs[100] / kBitmapWordBits;
+    std::vector<uint64_t> words;
+    ContainerReader(encoded, docs.front(), docs.size())
+        .FillWords(first_word, words);
+
+    std::vector<DocID> expected;
+    for (const auto doc_id : docs) {
+      if (doc_id >= first_word * kBitmapWordBits) {
+        expected.push_back(doc_id);
+      }
+    }
+    std::vector<DocID> actual;
+    for (size_t i = 0; i < words.size(); ++i) {
+      for (size_t bit = 0; bit < kBitmapWordBits; ++bit) {
+        if (words[i] >> bit & 1) {
+          actual.push_back((first_word + i) * kBitmapWordBits + bit);
+        }
+      }
+    }
+    EXPECT_EQ(actual, expected);
+  }
+}
+
+TEST(BitmapContainerTest, WordOpsMatchScalar) {
+  std::mt19937_64 rng(11);
+  for (const size_t size : {0, 1, 3, 4, 17}) {
+    std::vector<uint64_t> a(size);
+    std::vector<uint64_t> b(size);
+    for (size_t i = 0; i < size; ++i) {
+      a[i] = rng();
+      b[i] = rng();
+    }
+    for (const auto kernel :
+         {SimdKernel::kScalar, SimdKernel::kSse2, SimdKernel::kAvx2}) {
+      if (kernel > DetectSimdKernel()) {
+        continue;
+      }
+      std::vector<uint64_t> out(size);
+      AndWords(a, b, out, kernel);
+      for (size_t i = 0; i < size; ++i) {
+        EXPECT_EQ(out[i], a[i] & b[i]);
+      }
+      OrWords(a, b, out, kernel);
+      for (size_t i = 0; i < size; ++i) {
+        EXPECT_EQ(out[i], a[i] | b[i]);
+      }
+      // In place
+      out = a;
+      AndNotWords(out, b, out, kernel);
+      for (size_t i = 0; i < size; ++i) {
+        EXPECT_EQ(out[i], a[i] & ~b[i]);
+      }
+    }
+  }
+}
+
+TEST(BitmapContainerTest, TruncatedInput) {
+  std::vector<DocID> docs;
+  for (DocID doc_id = 0; doc_id < 300; doc_id += 2) {
+    docs.push_back(doc_id);
+  }
+  std::vector<uint8_t> encoded;
+  ContainerEncode(docs, encoded);
+  ASSERT_EQ(encoded[0], static_cast<uint8_t>(ContainerType::kBitmap));
+  encoded.pop_back();
+  EXPECT_THROW(ContainerReader(encoded, docs.front(), docs.size()),
+               std::runtime_error);
+}
@@ -0,0 +1,126 @@
+#include "engine/indexing/codec.h"
+
+#include <stdexcept>
+
+#include "engine/indexing/bit_packing.h"
+
+namespace {
+
+constexpr size_t kMaxVByteSize = 5;
+
+[[noreturn]] void ThrowCorrupted() {
+  throw std::runtime_error("Codec: corrupted input");
+}
+
+class VByteCodec : public indexing::Codec {
+ public:
+  void Encode(std::span<const uint32_t> values,
+              std::vector<uint8_t>& out) const override {
+    for (auto value : values) {
+      while (value >= 128) {
+        out.push_back(value & 0x7f);
+        value >>= 7;
+      }
+      out.push_back(value | 0x80);
+    }
+  }
+
+  size_t Decode(std::span<const uint8_t> in,
+                std::span<uint32_t> values) const override {
+    size_t idx = 0;
+    size_t i = 0;
+    // No bounds checks while even the longest values fit
+    for (; i < values.size() &&
+           in.size() - idx >= (values.size() - i) * kMaxVByteSize;
+         ++i) {
+      values[i] = DecodeOne(in.data(), idx);
+    }
+    for (; i < values.size(); ++i) {
+      uint32_t value = 0;
+      for (int shift = 0;; shift += 7) {
+        if (idx >= in.size()) {
+          ThrowCorrupted();
+        }
+        const uint8_t byte = in[idx++];
+        value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+        if (byte & 0x80) {
+          break;
+        }
+      }
+      values[i] = value;
+    }
+    return idx;
+  }
+
+ private:
+  static uint32_t DecodeOne(const uint8_t* in, size_t& idx) {
+    uint32_t value = 0;
+    for (int shift = 0;; shift += 7) {
+      const uint8_t byte = in[idx++];
+      value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) || shift == 28) {
+        return value;
+      }
+    }
+  }
+};
+
+// Full frames are bit-packed behind a byte with their width, the tail
+// shorter than a frame is left to VByte.
+class BitPackingCodec : public indexing::Codec {
+ public:
+  void Encode(std::span<const uint32_t> values,
+              std::vector<uint8_t>& out) const override {
+    size_t i = 0;
+    for (; i + indexing::kBitPackingFrame <= values.size();
+         i += indexing::kBitPackingFrame) {
+      const uint32_t bits = indexing::BitWidth(values.data() + i);
+      const size_t offset = out.size();
+      out.resize(offset + 1 + indexing::BitPackedSize(bits));
+      out[offset] = static_cast<uint8_t>(bits);
+      indexing::BitPack(values.data() + i, bits, out.data() + offset + 1);
+    }
+    vbyte_.Encode(values.subspan(i), out);
+  }
+
+  size_t Decode(std::span<const uint8_t> in,
+                std::span<uint32_t> values) const override {
+    static const auto kernel = indexing::DetectSimdKernel();
+    size_t idx = 0;
+    size_t i = 0;
+    for (; i + indexing::kBitPackingFrame <= values.size();
+         i += indexing::kBitPackingFrame) {
+      if (idx >= in.size()) {
+        ThrowCorrupted();
+      }
+      const uint32_t bits = in[idx++];
+      if (bits > 32 || in.size() - idx < indexing::BitPackedSize(bits)) {
+        ThrowCorrupted();
+      }
+      indexing::BitUnpack(in.data() + idx, bits, values.data() + i, kernel);
+      idx += indexing::BitPackedSize(bits);
+    }
+    return idx + vbyte_.Decode(in.subspan(idx), values.subspan(i));
+  }
+
+ private:
+  VByteCodec vbyte_;
+};
+
+}  // namespace
+
+namespace indexing {
+
+const Codec& GetCodec(CodecType type) {
+  static const VByteCodec vbyte;
+  static const BitPackingCodec bit_packing;
+  switch (type) {
+    case CodecType::kVByte:
+      return vbyte;
+    case CodecType::kBitPacking:
+      return bit_packing;
+  }
+  throw std::runtime_error("GetCodec: unknown codec");
+}
+
+}  // namespace indexing
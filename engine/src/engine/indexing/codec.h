@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace indexing {
+
+// Encodings of the integer streams of a posting list, persisted in the
+// index file
+enum class CodecType : uint32_t {
+  // Byte-aligned varints, one posting at a time
+  kVByte = 0,
+  // Blocks between skips packed in frames of a common bit width, unpacked
+  // with SIMD
+  kBitPacking = 1,
+};
+
+// Layouts of the doc stream of a posting list, picked per list and persisted
+// in the index file. Tfs and positions always follow the list codec.
+enum class DocEncoding : uint32_t {
+  // Doc gaps encoded with the list codec
+  kGaps = 0,
+  // Elias-Fano partitions over the skip blocks
+  kEliasFano = 1,
+  // Bitmap or run containers over the skip blocks, for dense lists
+  kBitmap = 2,
+};
+
+// Encodes arrays of integers as a whole, so decoding runs over a complete
+// array instead of checking the input for every value.
+class Codec {
+ public:
+  virtual ~Codec() = default;
+
+  virtual void Encode(std::span<const uint32_t> values,
+                      std::vector<uint8_t>& out) const = 0;
+  // Fills `values`, returns the number of bytes read. Throws if `in` ends
+  // before the last value.
+  virtual size_t Decode(std::span<const uint8_t> in,
+                        std::span<uint32_t> values) const = 0;
+};
+
+const Codec& GetCodec(CodecType type);
+
+}  // namespace indexing
@@ -0,0 +1,80 @@
+#include "engine/indexing/codec.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "engine/indexing/bit_packing.h"
+
+using namespace indexing;
+
+namespace {
+
+std::vector<uint32_t> RandomValues(size_t size, uint32_t bits,
+                                   std::mt19937& rng) {
+  std::vector<uint32_t> values(size);
+  for (auto& value : values) {
+    value = bits == 0 ? 0 : rng() >> (32 - bits);
+  }
+  return values;
+}
+
+}  // namespace
+
+TEST(CodecTest, RoundTrip) {
+  std::mt19937 rng(42);
+  for (const auto type : {CodecType::kVByte, CodecType::kBitPacking}) {
+    const auto& codec = GetCodec(type);
+    for (const size_t size : {0, 1, 127, 128, 129, 1000}) {
+      for (const uint32_t bits : {0, 1, 7, 13, 31, 32}) {
+        const auto values = RandomValues(size, bits, rng);
+        std::vector<uint8_t> encoded{0xff};
+        codec.Encode(values, encoded);
+
+        std::vector<uint32_t> decoded(size);
+        const auto read =
+            codec.Decode(std::span(encoded).subspan(1), decoded);
+        EXPECT_EQ(read, encoded.size() - 1);
+        EXPECT_EQ(decoded, values);
+      }
+    }
+  }
+}
+
+TEST(CodecTest, TruncatedInput) {
+  std::mt19937 rng(7);
+  for (const auto type : {CodecType::kVByte, CodecType::kBitPacking}) {
+    const auto& codec = GetCodec(type);
+    const auto values = RandomValues(300, 20, rng);
+    std::vector<uint8_t> encoded;
+    codec.Encode(values, encoded);
+    encoded.pop_back();
+
+    std::vector<uint32_t> decoded(values.size());
+    EXPECT_THROW(codec.Decode(encoded, decoded), std::runtime_error);
+  }
+}
+
+TEST(CodecTest, SimdKernelsMatchScalar) {
+  std::vector<SimdKernel> kernels{SimdKernel::kScalar};
+  if (DetectSimdKernel() != SimdKernel::kScalar) {
+    kernels.push_back(SimdKernel::kSse2);
+  }
+  if (DetectSimdKernel() == SimdKernel::kAvx2) {
+    kernels.push_back(SimdKernel::kAvx2);
+  }
+
+  std::mt19937 rng(1);
+  for (uint32_t bits = 0; bits <= 32; ++bits) {
+    const auto values = RandomValues(kBitPackingFrame, bits, rng);
+    ASSERT_LE(BitWidth(values.data()), bits);
+    std::vector<uint8_t> packed(BitPackedSize(bits));
+    BitPack(values.data(), bits, packed.data());
+
+    for (const auto kernel : kernels) {
+      std::vector<uint32_t> unpacked(kBitPackingFrame);
+      BitUnpack(packed.data(), bits, unpacked.data(), kernel);
+      EXPECT_EQ(unpacked, values) << "bits " << bits;
+    }
+  }
+}
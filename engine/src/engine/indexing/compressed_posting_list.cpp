@@ -1,7 +1,13 @@
 #include "engine/indexing/compressed_posting_list.h"
 
+#include <algorithm>
+#include <bit>
 #include <cmath>
+#include <stdexcept>
 
+#include "engine/indexing/deleted_docs.h"
+#include "engine/indexing/intersection.h"
+#include "engine/indexing/posting_cache.h"
 #include "engine/indexing/posting_list.h"
 
 namespace {
@@ -14,7 +20,7 @@ void VByteEncode(uint32_t& value, std::vector<uint8_t>& buffer) {
   buffer.push_back(value | 0x80);
 }
 
-uint32_t VByteDecode(size_t& idx, const std::vector<uint8_t>& buffer) {
+uint32_t VByteDecode(size_t& idx, std::span<const uint8_t> buffer) {
   uint32_t value = 0;
   int shift = 0;
   while (idx < buffer.size()) {
@@ -30,6 +36,31 @@ uint32_t VByteDecode(size_t& idx, const std::vector<uint8_t>& buffer) {
   return value;
 }
 
+// Decodes `values` stored at `idx`, returns the index past them
+size_t DecodeArray(const indexing::Codec& codec,
+                   std::span<const uint8_t> data, size_t idx,
+                   std::span<uint32_t> values) {
+  if (idx > data.size()) {
+    throw std::runtime_error("CompressedPostingList: corrupted list");
+  }
+  return idx + codec.Decode(data.subspan(idx), values);
+}
+
+indexing::CompressedPostingList FromWords(size_t first_word,
+                                          std::span<const uint64_t> words) {
+  indexing::CompressedPostingList result;
+  for (size_t i = 0; i < words.size(); ++i) {
+    for (uint64_t word = words[i]; word != 0; word &= word - 1) {
+      result.Add(static_cast<indexing::DocID>(
+                     (first_word + i) * indexing::kBitmapWordBits +
+                     std::countr_zero(word)),
+                 {});
+    }
+  }
+  result.BuildSkips();
+  return result;
+}
+
 }  // namespace
 
 namespace indexing {
@@ -37,32 +68,131 @@ namespace indexing {
 using DocIterator = indexing::CompressedPostingList::DocIterator;
 using CoordIterator = indexing::CompressedPostingList::CoordIterator;
 
+CompressedPostingList CompressedPostingList::MergeDisjoint(
+    const std::vector<const CompressedPostingList*>& lists,
+    const DocLengths& doc_lengths /* = {} */,
+    const std::vector<const DeletedDocs*>& deleted /* = {} */) {
+  std::vector<DocIterator> iters;
+  iters.reserve(lists.size());
+  for (const auto* list : lists) {
+    iters.push_back(list->begin());
+  }
+
+  CompressedPostingList result;
+  std::vector<uint32_t> coords;
+  while (true) {
+    size_t min_idx = iters.size();
+    for (size_t i = 0; i < iters.size(); ++i) {
+      if (!iters[i].IsEnd() &&
+          (min_idx == iters.size() ||
+           iters[i].doc_id() < iters[min_idx].doc_id())) {
+        min_idx = i;
+      }
+    }
+    if (min_idx == iters.size()) {
+      break;
+    }
+
+    auto& itr = iters[min_idx];
+    if (min_idx < deleted.size() && deleted[min_idx] &&
+        deleted[min_idx]->Contains(itr.doc_id())) {
+      ++itr;
+      continue;
+    }
+    coords.clear();
+    for (auto jtr = itr.GetCoordItr(); !jtr.IsEnd(); ++jtr) {
+      coords.push_back(*jtr);
+    }
+    const DocID doc_id = itr.doc_id();
+    result.Add(doc_id, coords, doc_lengths[doc_id]);
+    ++itr;
+  }
+  return result;
+}
+
+CompressedPostingList CompressedPostingList::IntersectAll(
+    const std::vector<const CompressedPostingList*>& lists) {
+  if (lists.empty()) {
+    return {};
+  }
+
+  std::vector<const CompressedPostingList*> order(lists);
+  std::stable_sort(order.begin(), order.end(),
+                   [](const auto* a, const auto* b) {
+                     return a->size() < b->size();
+                   });
+  if (order.size() > 1 &&
+      std::all_of(order.begin(), order.end(), [](const auto* list) {
+        return list->doc_encoding_ == DocEncoding::kBitmap;
+      })) {
+    auto result = order[0]->Intersect(*order[1]);
+    for (size_t i = 2; i < order.size() && result.size() > 0; ++i) {
+      result = result.Intersect(*order[i]);
+    }
+    return result;
+  }
+
+  CompressedPostingList result;
+  std::vector<DocIterator> iters;
+  iters.reserve(order.size());
+  for (const auto* list : order) {
+    iters.push_back(list->begin());
+  }
+
+  auto& driver = iters.front();
+  while (!driver.IsEnd()) {
+    const DocID target = driver.doc_id();
+    size_t i = 1;
+    for (; i < iters.size(); ++i) {
+      auto& itr = iters[i];
+      itr.SkipTo(target);
+      if (itr.IsEnd() || itr.doc_id() != target) {
+        break;
+      }
+    }
+    if (i == iters.size()) {
+      result.Add(target, {});
+      ++driver;
+    } else if (iters[i].IsEnd()) {
+      break;
+    } else {
+      // The driver catches up with the list that got ahead of it
+      driver.SkipTo(iters[i].doc_id());
+    }
+  }
+  result.BuildSkips();
+  return result;
+}
+
 void CompressedPostingList::Add(DocID doc_id,
-                                const std::vector<uint32_t>& coords) {
+                                const std::vector<uint32_t>& coords,
+                                uint32_t doc_length /* = 0 */) {
+  CheckOwned();
+  if (HasBlocks()) {
+    throw std::runtime_error(
+        "CompressedPostingList: can't append to a block-encoded list");
+  }
   uint32_t doc_gap = doc_id - last_doc_id_;
   last_doc_id_ = doc_id;
   VByteEncodeDoc(doc_gap);
-  VByteEncodeDoc(static_cast<uint32_t>(coord_buffer_.size()));
 
   const auto tf = static_cast<uint32_t>(coords.size());
-  VByteEncodeCoord(tf);
+  VByteEncodeFreq(tf);
   uint32_t last_coord = 0;
   for (const auto coord : coords) {
     VByteEncodeCoord(coord - last_coord);
     last_coord = coord;
   }
 
+  max_tf_ = std::max(max_tf_, tf);
+  min_doc_length_ = std::min(min_doc_length_, std::max({doc_length, tf, 1u}));
   ++size_;
 }
 
 PostingList CompressedPostingList::Decompress() const {
   PostingList result;
-  DocID doc_id = 0;
-  for (size_t i = 0; i < doc_buffer_.size();) {
-    doc_id += VByteDecodeDoc(i);
-    size_t j = VByteDecodeDoc(i);
-    const auto tf = VByteDecodeCoord(j);
-    result.list_.push_back(Posting{doc_id, tf});
+  for (auto itr = begin(); !itr.IsEnd(); ++itr) {
+    result.list_.push_back(*itr);
   }
   return result;
 }
@@ -72,7 +202,15 @@ void CompressedPostingList::VByteEncodeDoc(uint32_t value) {
 }
 
 uint32_t CompressedPostingList::VByteDecodeDoc(size_t& idx) const {
-  return VByteDecode(idx, doc_buffer_);
+  return VByteDecode(idx, DocData());
+}
+
+void CompressedPostingList::VByteEncodeFreq(uint32_t value) {
+  VByteEncode(value, freq_buffer_);
+}
+
+uint32_t CompressedPostingList::VByteDecodeFreq(size_t& idx) const {
+  return VByteDecode(idx, FreqData());
 }
 
 void CompressedPostingList::VByteEncodeCoord(uint32_t value) {
@@ -80,38 +218,267 @@ void CompressedPostingList::VByteEncodeCoord(uint32_t value) {
 }
 
 uint32_t CompressedPostingList::VByteDecodeCoord(size_t& idx) const {
-  return VByteDecode(idx, coord_buffer_);
+  return VByteDecode(idx, CoordData());
+}
+
+void CompressedPostingList::VByteSkipCoords(size_t& idx, size_t count) const {
+  const auto data = CoordData();
+  for (; count > 0 && idx < data.size(); ++idx) {
+    if (data[idx] & 0x80) {
+      --count;
+    }
+  }
+}
+
+std::span<const uint8_t> CompressedPostingList::DocData() const {
+  return is_view_ ? doc_view_ : std::span<const uint8_t>(doc_buffer_);
+}
+
+std::span<const uint8_t> CompressedPostingList::FreqData() const {
+  return is_view_ ? freq_view_ : std::span<const uint8_t>(freq_buffer_);
+}
+
+std::span<const uint8_t> CompressedPostingList::CoordData() const {
+  return is_view_ ? coord_view_ : std::span<const uint8_t>(coord_buffer_);
+}
+
+std::span<const CompressedPostingList::Skip> CompressedPostingList::Skips()
+    const {
+  return is_view_ ? skips_view_ : std::span<const Skip>(skips_);
 }
 
-void CompressedPostingList::BuildSkips() {
-  skip_step_ = static_cast<size_t>(std::sqrt(size_));
-  skip_step_ = std::max(skip_step_, 4ul);
+void CompressedPostingList::CheckOwned() const {
+  if (is_view_) {
+    throw std::runtime_error(
+        "CompressedPostingList: can't modify a list loaded from file");
+  }
+}
+
+void CompressedPostingList::BuildSkips(
+    const DocLengths& doc_lengths /* = {} */,
+    size_t skip_step /* = 0 */, CodecType codec /* = CodecType::kVByte */) {
+  CheckOwned();
+  if (HasBlocks()) {
+    // Skips are built over the VByte layout, the blocks are encoded anew
+    CompressedPostingList plain;
+    std::vector<uint32_t> coords;
+    for (auto itr = begin(); !itr.IsEnd(); ++itr) {
+      coords.clear();
+      for (auto jtr = itr.GetCoordItr(); !jtr.IsEnd(); ++jtr) {
+        coords.push_back(*jtr);
+      }
+      plain.Add(itr->doc_id, coords);
+    }
+    plain.max_tf_ = max_tf_;
+    plain.min_doc_length_ = min_doc_length_;
+    *this = std::move(plain);
+  }
+
+  if (skip_step == 0) {
+    skip_step = std::max(static_cast<size_t>(std::sqrt(size_)), 4ul);
+  }
+  skip_step_ = skip_step;
+  skips_.clear();
   DocID doc_id = 0;
-  for (size_t idx = 0, i = 0; idx < size_; ++idx) {
-    size_t prev_i = i;
-    doc_id += VByteDecodeDoc(i);
-    VByteDecodeDoc(i);
+  size_t doc_idx = 0;
+  size_t freq_idx = 0;
+  size_t coord_idx = 0;
+  for (size_t idx = 0; idx < size_; ++idx) {
+    const auto doc_offset = static_cast<uint32_t>(doc_idx);
+    const auto freq_offset = static_cast<uint32_t>(freq_idx);
+    doc_id += VByteDecodeDoc(doc_idx);
+    const auto tf = VByteDecodeFreq(freq_idx);
+    const uint32_t doc_length = doc_lengths[doc_id];
     if (idx % skip_step_ == 0) {
-      skips_.push_back(Skip{doc_id, prev_i});
+      skips_.push_back(Skip{doc_id, doc_offset, freq_offset,
+                            static_cast<uint32_t>(coord_idx), 0,
+                            UINT32_MAX});
+    }
+    VByteSkipCoords(coord_idx, tf);
+    auto& skip = skips_.back();
+    skip.max_tf = std::max(skip.max_tf, tf);
+    skip.min_doc_length =
+        std::min(skip.min_doc_length, std::max({doc_length, tf, 1u}));
+  }
+
+  if (codec != CodecType::kVByte) {
+    EncodeBlocks(codec);
+  }
+  EncodePartitions();
+}
+
+bool CompressedPostingList::HasBlocks() const {
+  return codec_ != CodecType::kVByte || doc_encoding_ != DocEncoding::kGaps;
+}
+
+void CompressedPostingList::EncodePartitions() {
+  if (skips_.empty()) {
+    return;
+  }
+
+  // Elias-Fano partitions hold the documents of a block relative to its
+  // skip, containers hold them as they are
+  std::vector<uint8_t> ef_buffer;
+  std::vector<uint8_t> container_buffer;
+  std::vector<uint32_t> ef_offsets;
+  std::vector<uint32_t> container_offsets;
+  ef_offsets.reserve(skips_.size());
+  container_offsets.reserve(skips_.size());
+  std::vector<DocID> docs;
+  std::vector<uint32_t> values;
+  auto itr = begin();
+  for (const auto& skip : skips_) {
+    docs.clear();
+    values.clear();
+    for (size_t i = 0; i < skip_step_ && !itr.IsEnd(); ++i, ++itr) {
+      docs.push_back(itr.doc_id());
+      values.push_back(itr.doc_id() - skip.doc_id);
     }
+    ef_offsets.push_back(static_cast<uint32_t>(ef_buffer.size()));
+    EliasFanoEncode(values, ef_buffer);
+    container_offsets.push_back(static_cast<uint32_t>(container_buffer.size()));
+    ContainerEncode(docs, container_buffer);
+  }
+
+  const bool bitmap = container_buffer.size() < ef_buffer.size();
+  auto& doc_buffer = bitmap ? container_buffer : ef_buffer;
+  if (doc_buffer.size() >= doc_buffer_.size()) {
+    return;
   }
+  const auto& offsets = bitmap ? container_offsets : ef_offsets;
+  for (size_t i = 0; i < skips_.size(); ++i) {
+    skips_[i].doc_offset = offsets[i];
+  }
+  doc_buffer_ = std::move(doc_buffer);
+  doc_encoding_ = bitmap ? DocEncoding::kBitmap : DocEncoding::kEliasFano;
+}
+
+ContainerReader CompressedPostingList::ReadContainer(size_t block_idx) const {
+  const auto& skip = Skips()[block_idx];
+  const auto data = DocData();
+  if (skip.doc_offset > data.size()) {
+    throw std::runtime_error("CompressedPostingList: corrupted list");
+  }
+  return ContainerReader(data.subspan(skip.doc_offset), skip.doc_id,
+                         std::min(skip_step_, size_ - block_idx * skip_step_));
+}
+
+std::vector<uint64_t> CompressedPostingList::DocWords(
+    size_t first_word) const {
+  std::vector<uint64_t> words;
+  if (doc_encoding_ == DocEncoding::kBitmap) {
+    for (size_t i = 0; i < Skips().size(); ++i) {
+      ReadContainer(i).FillWords(first_word, words);
+    }
+    return words;
+  }
+
+  const size_t first_doc = first_word * kBitmapWordBits;
+  auto itr = begin();
+  if (!itr.IsEnd()) {
+    itr.SkipTo(static_cast<DocID>(first_doc));
+  }
+  for (; !itr.IsEnd(); ++itr) {
+    const size_t bit = itr.doc_id() - first_doc;
+    if (bit / kBitmapWordBits >= words.size()) {
+      words.resize(bit / kBitmapWordBits + 1);
+    }
+    words[bit / kBitmapWordBits] |= uint64_t{1} << (bit % kBitmapWordBits);
+  }
+  return words;
+}
+
+void CompressedPostingList::EncodeBlocks(CodecType codec) {
+  const auto& encoder = GetCodec(codec);
+  std::vector<uint8_t> doc_buffer;
+  std::vector<uint8_t> freq_buffer;
+  std::vector<uint8_t> coord_buffer;
+  std::vector<Skip> skips;
+  skips.reserve(skips_.size());
+
+  // The first document of a block is the one of the skip
+  std::vector<uint32_t> gaps;
+  std::vector<uint32_t> tfs;
+  std::vector<uint32_t> coords;
+  auto itr = begin();
+  for (const auto& skip : skips_) {
+    gaps.clear();
+    tfs.clear();
+    coords.clear();
+    DocID last_doc_id = skip.doc_id;
+    for (size_t i = 0; i < skip_step_ && !itr.IsEnd(); ++i, ++itr) {
+      if (i > 0) {
+        gaps.push_back(itr.doc_id() - last_doc_id);
+      }
+      last_doc_id = itr.doc_id();
+      tfs.push_back(itr->tf);
+      uint32_t last_coord = 0;
+      for (auto jtr = itr.GetCoordItr(); !jtr.IsEnd(); ++jtr) {
+        coords.push_back(*jtr - last_coord);
+        last_coord = *jtr;
+      }
+    }
+
+    skips.push_back(Skip{skip.doc_id, static_cast<uint32_t>(doc_buffer.size()),
+                         static_cast<uint32_t>(freq_buffer.size()),
+                         static_cast<uint32_t>(coord_buffer.size()),
+                         skip.max_tf, skip.min_doc_length});
+    encoder.Encode(gaps, doc_buffer);
+    encoder.Encode(tfs, freq_buffer);
+    encoder.Encode(coords, coord_buffer);
+  }
+
+  skips_ = std::move(skips);
+  doc_buffer_ = std::move(doc_buffer);
+  freq_buffer_ = std::move(freq_buffer);
+  coord_buffer_ = std::move(coord_buffer);
+  codec_ = codec;
 }
 
 CompressedPostingList CompressedPostingList::Intersect(
     const CompressedPostingList& other) const {
+  const bool bitmap = doc_encoding_ == DocEncoding::kBitmap;
+  const bool other_bitmap = other.doc_encoding_ == DocEncoding::kBitmap;
+  if (size_ > 0 && other.size_ > 0 && bitmap && other_bitmap) {
+    const size_t first_word =
+        std::max(begin().doc_id(), other.begin().doc_id()) / kBitmapWordBits;
+    auto words = DocWords(first_word);
+    const auto other_words = other.DocWords(first_word);
+    words.resize(std::min(words.size(), other_words.size()));
+    AndWords(words, std::span(other_words).first(words.size()), words);
+    return FromWords(first_word, words);
+  }
+
   CompressedPostingList result;
+  if (size_ > 0 && other.size_ > 0 && (bitmap || other_bitmap)) {
+    // Documents of the other list are looked up in the bitmap
+    const auto& dense = bitmap ? *this : other;
+    const auto& sparse = bitmap ? other : *this;
+    const size_t first_word = dense.begin().doc_id() / kBitmapWordBits;
+    const auto words = dense.DocWords(first_word);
+    for (auto itr = sparse.begin(); !itr.IsEnd(); ++itr) {
+      const size_t bit = itr.doc_id() - first_word * kBitmapWordBits;
+      if (itr.doc_id() >= first_word * kBitmapWordBits &&
+          bit / kBitmapWordBits < words.size() &&
+          (words[bit / kBitmapWordBits] >> (bit % kBitmapWordBits) & 1)) {
+        result.Add(itr.doc_id(), {});
+      }
+    }
+    result.BuildSkips();
+    return result;
+  }
 
   auto itr = begin();
   auto jtr = other.begin();
   while (itr != end() && jtr != other.end()) {
-    if (itr->doc_id == jtr->doc_id) {
-      result.Add(itr->doc_id, {});
+    if (itr.doc_id() == jtr.doc_id()) {
+      result.Add(itr.doc_id(), {});
       ++itr;
       ++jtr;
-    } else if (itr->doc_id < jtr->doc_id) {
-      itr.SkipTo(jtr->doc_id);
+    } else if (itr.doc_id() < jtr.doc_id()) {
+      itr.SkipTo(jtr.doc_id());
     } else {
-      jtr.SkipTo(itr->doc_id);
+      jtr.SkipTo(itr.doc_id());
     }
   }
 
@@ -121,26 +488,41 @@ CompressedPostingList CompressedPostingList::Intersect(
 
 CompressedPostingList CompressedPostingList::Merge(
     const CompressedPostingList& other) const {
+  if (size_ > 0 && other.size_ > 0 &&
+      (doc_encoding_ == DocEncoding::kBitmap ||
+       other.doc_encoding_ == DocEncoding::kBitmap)) {
+    // A sorted list is set into a bitmap of its own first
+    const size_t first_word =
+        std::min(begin().doc_id(), other.begin().doc_id()) / kBitmapWordBits;
+    auto words = DocWords(first_word);
+    auto other_words = other.DocWords(first_word);
+    const size_t size = std::max(words.size(), other_words.size());
+    words.resize(size);
+    other_words.resize(size);
+    OrWords(words, other_words, words);
+    return FromWords(first_word, words);
+  }
+
   CompressedPostingList result;
 
   auto itr = begin();
   auto jtr = other.begin();
   while (itr != end() || jtr != other.end()) {
     if (itr == end()) {
-      result.Add(jtr->doc_id, {});
+      result.Add(jtr.doc_id(), {});
       ++jtr;
     } else if (jtr == other.end()) {
-      result.Add(itr->doc_id, {});
+      result.Add(itr.doc_id(), {});
       ++itr;
-    } else if (itr->doc_id == jtr->doc_id) {
-      result.Add(itr->doc_id, {});
+    } else if (itr.doc_id() == jtr.doc_id()) {
+      result.Add(itr.doc_id(), {});
       ++itr;
       ++jtr;
-    } else if (itr->doc_id < jtr->doc_id) {
-      result.Add(itr->doc_id, {});
+    } else if (itr.doc_id() < jtr.doc_id()) {
+      result.Add(itr.doc_id(), {});
       ++itr;
     } else {
-      result.Add(jtr->doc_id, {});
+      result.Add(jtr.doc_id(), {});
       ++jtr;
     }
   }
@@ -149,6 +531,35 @@ CompressedPostingList CompressedPostingList::Merge(
   return result;
 }
 
+CompressedPostingList CompressedPostingList::Substract(
+    const CompressedPostingList& other) const {
+  if (size_ > 0 && other.size_ > 0 &&
+      (doc_encoding_ == DocEncoding::kBitmap ||
+       other.doc_encoding_ == DocEncoding::kBitmap)) {
+    const size_t first_word = begin().doc_id() / kBitmapWordBits;
+    auto words = DocWords(first_word);
+    auto other_words = other.DocWords(first_word);
+    other_words.resize(words.size());
+    AndNotWords(words, other_words, words);
+    return FromWords(first_word, words);
+  }
+
+  CompressedPostingList result;
+
+  auto jtr = other.begin();
+  for (auto itr = begin(); itr != end(); ++itr) {
+    if (!jtr.IsEnd()) {
+      jtr.SkipTo(itr.doc_id());
+    }
+    if (jtr.IsEnd() || jtr.doc_id() != itr.doc_id()) {
+      result.Add(itr.doc_id(), {});
+    }
+  }
+
+  result.BuildSkips();
+  return result;
+}
+
 CompressedPostingList CompressedPostingList::operator&(
     const CompressedPostingList& other) const {
   return Intersect(other);
@@ -159,44 +570,142 @@ CompressedPostingList CompressedPostingList::operator|(
   return Merge(other);
 }
 
+CompressedPostingList CompressedPostingList::operator-(
+    const CompressedPostingList& other) const {
+  return Substract(other);
+}
+
 size_t CompressedPostingList::size() const { return size_; }
 
+size_t CompressedPostingList::skip_step() const { return skip_step_; }
+
+CodecType CompressedPostingList::codec() const { return codec_; }
+
+DocEncoding CompressedPostingList::doc_encoding() const {
+  return doc_encoding_;
+}
+
+size_t CompressedPostingList::MemoryUsage() const {
+  return doc_buffer_.capacity() + freq_buffer_.capacity() +
+         coord_buffer_.capacity() + skips_.capacity() * sizeof(Skip);
+}
+
+size_t CompressedPostingList::DocDataSize() const { return DocData().size(); }
+
+uint32_t CompressedPostingList::max_tf() const { return max_tf_; }
+
+uint32_t CompressedPostingList::min_doc_length() const {
+  return min_doc_length_;
+}
+
 DocIterator CompressedPostingList::begin() const { return DocIterator(this); }
 
 DocIterator CompressedPostingList::end() const { return DocIterator(); }
 
 DocIterator::DocIterator(const CompressedPostingList* list /* = nullptr */)
     : list_(list) {
-  if (list_ && list->size() > 0) {
+  if (list_ && list->size() > 0 && list->HasBlocks()) {
+    LoadBlock(0);
+  } else if (list_ && list->size() > 0) {
     current_.doc_id = list_->VByteDecodeDoc(byte_idx_);
-    coord_idx_ = list_->VByteDecodeDoc(byte_idx_);
-    current_.tf = list_->VByteDecodeCoord(coord_idx_);
   } else {
     list_ = nullptr;
   }
 }
 
-DocIterator::reference DocIterator::operator*() const { return current_; }
+DocIterator::DocIterator(const CompressedPostingList* list,
+                         const DecodedPostings* decoded)
+    : list_(list), decoded_(decoded) {
+  if (decoded_->docs.empty()) {
+    list_ = nullptr;
+    return;
+  }
+  current_ = {decoded_->docs[0], decoded_->tfs[0]};
+  tf_decoded_ = true;
+}
 
-DocIterator::pointer DocIterator::operator->() const { return &current_; }
+DocIterator::reference DocIterator::operator*() const {
+  DecodeTf();
+  return current_;
+}
+
+DocIterator::pointer DocIterator::operator->() const {
+  DecodeTf();
+  return &current_;
+}
+
+DocID DocIterator::doc_id() const { return current_.doc_id; }
 
 CoordIterator DocIterator::GetCoordItr() const {
-  return CoordIterator(list_, current_.tf, coord_idx_);
+  if (decoded_) {
+    throw std::logic_error("DocIterator: no positions in decoded postings");
+  }
+  DecodeTf();
+  if (list_->codec_ == CodecType::kVByte) {
+    list_->VByteSkipCoords(coord_idx_, tf_sum_ - current_.tf);
+    coord_pos_ = pos_;
+    tf_sum_ = current_.tf;
+    return CoordIterator(list_, current_.tf, coord_idx_);
+  }
+  if (block_coords_.empty()) {
+    size_t count = 0;
+    for (const auto tf : block_tfs_) {
+      count += tf;
+    }
+    block_coords_.resize(count);
+    DecodeArray(GetCodec(list_->codec_), list_->CoordData(),
+                list_->Skips()[skip_idx_ - 1].coord_offset, block_coords_);
+  }
+  for (; coord_pos_ < block_pos_; ++coord_pos_) {
+    coord_idx_ += block_tfs_[coord_pos_];
+  }
+  return CoordIterator(list_, current_.tf, block_coords_.data() + coord_idx_);
 }
 
 DocIterator& DocIterator::operator++() {
-  if (byte_idx_ >= list_->doc_buffer_.size()) {
+  if (decoded_) {
+    if (++pos_ == decoded_->docs.size()) {
+      list_ = nullptr;
+      current_ = {0, 0};
+    } else {
+      current_ = {decoded_->docs[pos_], decoded_->tfs[pos_]};
+    }
+    return *this;
+  }
+  tf_decoded_ = false;
+  if (list_->HasBlocks()) {
+    if (++block_pos_ >= block_size_) {
+      if (skip_idx_ < list_->Skips().size()) {
+        LoadBlock(skip_idx_);
+      } else {
+        list_ = nullptr;
+        current_ = {0, 0};
+      }
+    } else if (list_->doc_encoding_ == DocEncoding::kEliasFano) {
+      block_ef_.Next();
+      current_.doc_id = block_base_ + block_ef_.value();
+      ++pos_;
+    } else if (list_->doc_encoding_ == DocEncoding::kBitmap) {
+      block_container_.Next();
+      current_.doc_id = block_container_.value();
+      ++pos_;
+    } else {
+      current_.doc_id = block_docs_[block_pos_];
+      ++pos_;
+    }
+    return *this;
+  }
+  if (pos_ + 1 >= list_->size_) {
     list_ = nullptr;
     current_ = {0, 0};
     return *this;
   }
-  if (skip_idx_ < list_->skips_.size() &&
-      current_.doc_id == list_->skips_[skip_idx_].doc_id) {
+  const auto skips = list_->Skips();
+  if (skip_idx_ < skips.size() && current_.doc_id == skips[skip_idx_].doc_id) {
     ++skip_idx_;
   }
   current_.doc_id += list_->VByteDecodeDoc(byte_idx_);
-  coord_idx_ = list_->VByteDecodeDoc(byte_idx_);
-  current_.tf = list_->VByteDecodeCoord(coord_idx_);
+  ++pos_;
   return *this;
 }
 
@@ -210,7 +719,10 @@ bool DocIterator::operator==(const DocIterator& other) const {
   if (IsEnd() && other.IsEnd()) {
     return true;
   }
-  return list_ == other.list_ && byte_idx_ == other.byte_idx_;
+  if (list_ != other.list_ || IsEnd() || other.IsEnd()) {
+    return false;
+  }
+  return pos_ == other.pos_;
 }
 
 bool DocIterator::operator!=(const DocIterator& other) const {
@@ -218,46 +730,234 @@ bool DocIterator::operator!=(const DocIterator& other) const {
 }
 
 void DocIterator::SkipTo(DocID target) {
-  if ((skip_idx_ < list_->skips_.size() &&
-       list_->skips_[skip_idx_].doc_id > target) ||
-      (skip_idx_ >= list_->skips_.size())) {
-    while (!IsEnd() && current_.doc_id < target) {
+  if (IsEnd()) {
+    return;
+  }
+  if (decoded_) {
+    if (current_.doc_id >= target) {
+      return;
+    }
+    pos_ = LowerBound(decoded_->docs, pos_, target);
+    if (pos_ == decoded_->docs.size()) {
+      list_ = nullptr;
+      current_ = {0, 0};
+    } else {
+      current_ = {decoded_->docs[pos_], decoded_->tfs[pos_]};
+    }
+    return;
+  }
+  if (list_->HasBlocks()) {
+    if (current_.doc_id >= target) {
+      return;
+    }
+    const size_t block_idx = FindBlock(target);
+    if (block_idx + 1 != skip_idx_) {
+      LoadBlock(block_idx);
+    }
+    const auto doc_encoding = list_->doc_encoding_;
+    size_t pos = 0;
+    if (doc_encoding == DocEncoding::kEliasFano) {
+      block_ef_.NextGEQ(target - block_base_);
+      pos = block_ef_.position();
+    } else if (doc_encoding == DocEncoding::kBitmap) {
+      block_container_.NextGEQ(target);
+      pos = block_container_.position();
+    } else {
+      pos = LowerBound(block_docs_, block_pos_, target);
+    }
+    if (pos == block_size_) {
+      // The next block starts past the target
+      block_pos_ = block_size_ - 1;
       ++(*this);
+      return;
+    }
+    pos_ += pos - block_pos_;
+    block_pos_ = pos;
+    if (doc_encoding == DocEncoding::kEliasFano) {
+      current_.doc_id = block_base_ + block_ef_.value();
+    } else if (doc_encoding == DocEncoding::kBitmap) {
+      current_.doc_id = block_container_.value();
+    } else {
+      current_.doc_id = block_docs_[block_pos_];
     }
+    tf_decoded_ = false;
     return;
   }
 
-  while (skip_idx_ < list_->skips_.size() &&
-         list_->skips_[skip_idx_].doc_id <= target) {
-    skip_idx_++;
+  const auto skips = list_->Skips();
+  if ((skip_idx_ < skips.size() && skips[skip_idx_].doc_id > target) ||
+      (skip_idx_ >= skips.size())) {
+    while (!IsEnd() && current_.doc_id < target) {
+      ++(*this);
+    }
+    return;
   }
 
+  const auto reached = [target](const Skip& skip) {
+    return skip.doc_id <= target;
+  };
+  skip_idx_ =
+      GallopPartitionPoint(skips.begin() + skip_idx_, skips.end(), reached) -
+      skips.begin();
+
   if (skip_idx_ == 0) {
     return;
   }
 
   skip_idx_--;
-  const auto skip = list_->skips_[skip_idx_];
+  const auto skip = skips[skip_idx_];
 
-  byte_idx_ = skip.offset;
+  byte_idx_ = skip.doc_offset;
   current_.doc_id = skip.doc_id;
   list_->VByteDecodeDoc(byte_idx_);
-  coord_idx_ = list_->VByteDecodeDoc(byte_idx_);
-  current_.tf = list_->VByteDecodeCoord(coord_idx_);
+  pos_ = skip_idx_ * list_->skip_step_;
+  tf_decoded_ = false;
+  freq_idx_ = skip.freq_offset;
+  freq_pos_ = pos_;
+  coord_idx_ = skip.coord_offset;
+  coord_pos_ = pos_;
+  tf_sum_ = 0;
 
   while (!IsEnd() && current_.doc_id < target) {
     ++(*this);
   }
 }
 
+CompressedPostingList::BlockMax DocIterator::GetBlockMax(DocID target) const {
+  return GetBlock(FindBlock(target));
+}
+
+void DocIterator::SkipToBlock(
+    DocID target, const std::function<bool(const BlockMax&)>& can_beat) {
+  if (IsEnd()) {
+    return;
+  }
+  target = std::max(target, current_.doc_id);
+
+  const auto skips = list_->Skips();
+  size_t block_idx = FindBlock(target);
+  while (block_idx < std::max(skips.size(), 1ul) &&
+         !can_beat(GetBlock(block_idx))) {
+    ++block_idx;
+  }
+  if (block_idx >= std::max(skips.size(), 1ul)) {
+    list_ = nullptr;
+    current_ = {0, 0};
+    return;
+  }
+  if (block_idx < skips.size()) {
+    target = std::max(target, skips[block_idx].doc_id);
+  }
+  SkipTo(target);
+}
+
+size_t DocIterator::FindBlock(DocID target) const {
+  const auto skips = list_->Skips();
+  const auto from = skips.begin() + (skip_idx_ > 0 ? skip_idx_ - 1 : 0);
+  auto itr = GallopPartitionPoint(
+      from, skips.end(),
+      [target](const Skip& skip) { return skip.doc_id <= target; });
+  return itr == skips.begin() ? 0 : itr - skips.begin() - 1;
+}
+
+CompressedPostingList::BlockMax DocIterator::GetBlock(size_t block_idx) const {
+  const auto skips = list_->Skips();
+  if (skips.empty()) {
+    return {UINT32_MAX, list_->max_tf_, list_->min_doc_length_};
+  }
+  const auto& skip = skips[block_idx];
+  const DocID last_doc_id = block_idx + 1 < skips.size()
+                                ? skips[block_idx + 1].doc_id - 1
+                                : UINT32_MAX;
+  return {last_doc_id, skip.max_tf, skip.min_doc_length};
+}
+
 bool DocIterator::IsEnd() const { return list_ == nullptr; }
 
+void DocIterator::LoadBlock(size_t block_idx) {
+  const auto& skip = list_->Skips()[block_idx];
+  block_size_ =
+      std::min(list_->skip_step_, list_->size_ - block_idx * list_->skip_step_);
+
+  const auto data = list_->DocData();
+  if (list_->doc_encoding_ == DocEncoding::kEliasFano) {
+    if (skip.doc_offset > data.size()) {
+      throw std::runtime_error("CompressedPostingList: corrupted list");
+    }
+    block_ef_ = EliasFanoReader(data.subspan(skip.doc_offset), block_size_);
+    block_base_ = skip.doc_id;
+  } else if (list_->doc_encoding_ == DocEncoding::kBitmap) {
+    block_container_ = list_->ReadContainer(block_idx);
+  } else {
+    block_docs_.resize(block_size_);
+    block_docs_[0] = skip.doc_id;
+    DecodeArray(GetCodec(list_->codec_), data, skip.doc_offset,
+                std::span<uint32_t>(block_docs_).subspan(1));
+    for (size_t i = 1; i < block_size_; ++i) {
+      block_docs_[i] += block_docs_[i - 1];
+    }
+  }
+
+  skip_idx_ = block_idx + 1;
+  block_pos_ = 0;
+  pos_ = block_idx * list_->skip_step_;
+  if (list_->codec_ == CodecType::kVByte) {
+    // Only the docs are blocked, tfs and coords are read from the skip on
+    freq_idx_ = skip.freq_offset;
+    freq_pos_ = pos_;
+    coord_idx_ = skip.coord_offset;
+    coord_pos_ = pos_;
+    tf_sum_ = 0;
+  } else {
+    block_tfs_.clear();
+    block_coords_.clear();
+    coord_pos_ = 0;
+    coord_idx_ = 0;
+  }
+  tf_decoded_ = false;
+  current_ = {skip.doc_id, 0};
+}
+
+void DocIterator::DecodeTf() const {
+  if (tf_decoded_) {
+    return;
+  }
+  if (list_->codec_ != CodecType::kVByte) {
+    if (block_tfs_.empty()) {
+      block_tfs_.resize(block_size_);
+      DecodeArray(GetCodec(list_->codec_), list_->FreqData(),
+                  list_->Skips()[skip_idx_ - 1].freq_offset, block_tfs_);
+    }
+    current_.tf = block_tfs_[block_pos_];
+  } else {
+    for (; freq_pos_ <= pos_; ++freq_pos_) {
+      current_.tf = list_->VByteDecodeFreq(freq_idx_);
+      tf_sum_ += current_.tf;
+    }
+  }
+  tf_decoded_ = true;
+}
+
 CoordIterator::CoordIterator(const CompressedPostingList* list, uint32_t size,
                              size_t idx)
     : list_(list), tf_(size), byte_idx_(idx) {
+  if (tf_ == 0) {
+    list_ = nullptr;
+    return;
+  }
   current_ = list_->VByteDecodeCoord(byte_idx_);
 }
 
+CoordIterator::CoordIterator(const CompressedPostingList* list, uint32_t size,
+                             const uint32_t* deltas)
+    : list_(list), deltas_(deltas), tf_(size) {
+  if (tf_ == 0) {
+    list_ = nullptr;
+    return;
+  }
+  current_ = deltas_[0];
+}
+
 CoordIterator::reference CoordIterator::operator*() const { return current_; }
 
 CoordIterator& CoordIterator::operator++() {
@@ -267,7 +967,8 @@ CoordIterator& CoordIterator::operator++() {
     return *this;
   }
 
-  current_ += list_->VByteDecodeCoord(byte_idx_);
+  current_ +=
+      deltas_ ? deltas_[pos_idx_] : list_->VByteDecodeCoord(byte_idx_);
   return *this;
 }
 
@@ -1,20 +1,37 @@
 #pragma once
 
+#include <functional>
 #include <iterator>
+#include <span>
 #include <vector>
 
+#include "engine/indexing/bitmap_container.h"
+#include "engine/indexing/codec.h"
+#include "engine/indexing/doc_lengths.h"
+#include "engine/indexing/elias_fano.h"
 #include "engine/indexing/types.h"
 
 namespace storage {
-class FileIndexStorage;
+class IndexReader;
+class IndexWriter;
 }
 
 namespace indexing {
 
+class DeletedDocs;
 class PostingList;
+struct DecodedPostings;
 
 class CompressedPostingList {
  public:
+  // Score-independent bounds of a skip block, used to skip blocks that
+  // cannot contribute enough to a ranked result.
+  struct BlockMax {
+    DocID last_doc_id;
+    uint32_t max_tf;
+    uint32_t min_doc_length;
+  };
+
   class CoordIterator {
    public:
     using iterator_category = std::input_iterator_tag;
@@ -24,6 +41,9 @@ class CompressedPostingList {
     using reference = const uint32_t&;
 
     CoordIterator(const CompressedPostingList* list, uint32_t size, size_t idx);
+    // Over position deltas decoded from a block
+    CoordIterator(const CompressedPostingList* list, uint32_t size,
+                  const uint32_t* deltas);
 
     reference operator*() const;
 
@@ -34,6 +54,7 @@ class CompressedPostingList {
 
    private:
     const CompressedPostingList* list_ = nullptr;
+    const uint32_t* deltas_ = nullptr;
     uint32_t tf_ = 0;
     size_t byte_idx_ = 0;
     uint32_t pos_idx_ = 0;
@@ -49,9 +70,16 @@ class CompressedPostingList {
     using reference = const Posting&;
 
     explicit DocIterator(const CompressedPostingList* list = nullptr);
+    // Reads the docs and tfs from `decoded`, the decoded postings of `list`,
+    // which has to outlive the iterator. Blocks are still those of `list`,
+    // positions can't be read.
+    DocIterator(const CompressedPostingList* list,
+                const DecodedPostings* decoded);
 
+    // The tf is decoded on access, doc-only traversal should use doc_id()
     reference operator*() const;
     pointer operator->() const;
+    DocID doc_id() const;
 
     CoordIterator GetCoordItr() const;
 
@@ -63,54 +91,169 @@ class CompressedPostingList {
 
     void SkipTo(DocID target);
 
+    // Bounds of the block holding `target`, the iterator is not moved.
+    BlockMax GetBlockMax(DocID target) const;
+    // Skips whole blocks starting from the one holding `target` until
+    // `can_beat` accepts one, then moves to the first posting >= target in it.
+    void SkipToBlock(DocID target,
+                     const std::function<bool(const BlockMax&)>& can_beat);
+
     bool IsEnd() const;
 
    private:
+    size_t FindBlock(DocID target) const;
+    BlockMax GetBlock(size_t block_idx) const;
+    // Moves to the first posting of a block
+    void LoadBlock(size_t block_idx);
+    void DecodeTf() const;
+
     const CompressedPostingList* list_ = nullptr;
+    const DecodedPostings* decoded_ = nullptr;
     size_t byte_idx_ = 0;
-    size_t coord_idx_ = 0;
     size_t skip_idx_ = 0;
-    Posting current_;
+    // Index of the current posting in the list
+    size_t pos_ = 0;
+    mutable Posting current_;
+    mutable bool tf_decoded_ = false;
+
+    // The freq and coord streams are read behind the doc stream only when
+    // needed. freq_idx_ is where the tf of posting freq_pos_ starts,
+    // coord_idx_ is where the coords of posting coord_pos_ start and
+    // tf_sum_ counts the coords of postings coord_pos_ to freq_pos_. For
+    // block-encoded lists coord_pos_ and coord_idx_ are within the block.
+    mutable size_t freq_idx_ = 0;
+    mutable size_t freq_pos_ = 0;
+    mutable size_t coord_idx_ = 0;
+    mutable size_t coord_pos_ = 0;
+    mutable size_t tf_sum_ = 0;
+
+    // Current block of a block-encoded list, its tfs and position deltas
+    // are decoded on first use. Elias-Fano and container docs are read in
+    // place.
+    std::vector<DocID> block_docs_;
+    EliasFanoReader block_ef_;
+    ContainerReader block_container_;
+    DocID block_base_ = 0;
+    size_t block_size_ = 0;
+    size_t block_pos_ = 0;
+    mutable std::vector<uint32_t> block_tfs_;
+    mutable std::vector<uint32_t> block_coords_;
   };
 
-  void Add(DocID doc_id, const std::vector<uint32_t>& coords);
+  // Merges lists over disjoint sets of documents, coordinates are kept.
+  // Documents of `deleted[i]`, if given, are dropped from `lists[i]`.
+  static CompressedPostingList MergeDisjoint(
+      const std::vector<const CompressedPostingList*>& lists,
+      const DocLengths& doc_lengths = {},
+      const std::vector<const DeletedDocs*>& deleted = {});
+  // Documents common to all the lists. The shortest list drives and the
+  // others are skipped to its documents, galloping through their skips.
+  static CompressedPostingList IntersectAll(
+      const std::vector<const CompressedPostingList*>& lists);
+
+  void Add(DocID doc_id, const std::vector<uint32_t>& coords,
+           uint32_t doc_length = 0);
 
   PostingList Decompress() const;
 
-  void BuildSkips();
+  // A skip is placed every `skip_step` postings, 0 means sqrt(size). With a
+  // codec other than VByte the postings between skips are re-encoded as
+  // blocks, which can't be appended to. The doc stream is switched to
+  // Elias-Fano or bitmap partitions over the same blocks when that is
+  // smaller.
+  void BuildSkips(const DocLengths& doc_lengths = {},
+                  size_t skip_step = 0, CodecType codec = CodecType::kVByte);
 
   size_t size() const;
-
+  size_t skip_step() const;
+  CodecType codec() const;
+  DocEncoding doc_encoding() const;
+  // Bytes held by the owned buffers
+  size_t MemoryUsage() const;
+  // Bytes read by a doc-only traversal of the whole list
+  size_t DocDataSize() const;
+  uint32_t max_tf() const;
+  uint32_t min_doc_length() const;
+
+  // Lists with bitmap doc streams are combined a word at a time
   CompressedPostingList Intersect(const CompressedPostingList& other) const;
   CompressedPostingList Merge(const CompressedPostingList& other) const;
+  CompressedPostingList Substract(const CompressedPostingList& other) const;
 
   CompressedPostingList operator&(const CompressedPostingList& other) const;
   CompressedPostingList operator|(const CompressedPostingList& other) const;
+  CompressedPostingList operator-(const CompressedPostingList& other) const;
 
   DocIterator begin() const;
   DocIterator end() const;
 
  private:
-  friend class storage::FileIndexStorage;
+  friend class storage::IndexReader;
+  friend class storage::IndexWriter;
 
+  // Persisted as is, keep it free of padding. The offsets point into each
+  // stream at the first posting of the block.
   struct Skip {
     DocID doc_id;
-    size_t offset;
+    uint32_t doc_offset;
+    uint32_t freq_offset;
+    uint32_t coord_offset;
+    uint32_t max_tf;
+    uint32_t min_doc_length;
   };
+  static_assert(sizeof(Skip) == 24);
+
+  // Buffers of either owned data or the mapped file the list is a view of
+  std::span<const uint8_t> DocData() const;
+  std::span<const uint8_t> FreqData() const;
+  std::span<const uint8_t> CoordData() const;
+  std::span<const Skip> Skips() const;
+
+  void CheckOwned() const;
+  // Whether the postings are read by blocks between skips
+  bool HasBlocks() const;
+  // Rewrites the VByte postings as blocks starting at the skips
+  void EncodeBlocks(CodecType codec);
+  // Rewrites the doc stream as Elias-Fano or container partitions, the
+  // smallest of them if it is smaller than the gaps
+  void EncodePartitions();
+  ContainerReader ReadContainer(size_t block_idx) const;
+  // Bitmap of the documents from word `first_word` up to the last one
+  std::vector<uint64_t> DocWords(size_t first_word) const;
 
   void VByteEncodeDoc(uint32_t value);
   uint32_t VByteDecodeDoc(size_t& idx) const;
+  void VByteEncodeFreq(uint32_t value);
+  uint32_t VByteDecodeFreq(size_t& idx) const;
   void VByteEncodeCoord(uint32_t value);
   uint32_t VByteDecodeCoord(size_t& idx) const;
+  // Moves `idx` past `count` coords
+  void VByteSkipCoords(size_t& idx, size_t count) const;
 
   std::vector<Skip> skips_;
-  size_t skip_step_;
+  size_t skip_step_ = 0;
+  CodecType codec_ = CodecType::kVByte;
+  DocEncoding doc_encoding_ = DocEncoding::kGaps;
 
+  // Doc gaps, tfs and coord deltas are kept in separate streams, so the
+  // doc stream alone is read while tfs and positions aren't needed
   std::vector<uint8_t> doc_buffer_;
+  std::vector<uint8_t> freq_buffer_;
   std::vector<uint8_t> coord_buffer_;
 
+  // Non-owning view into a loaded index, kept alive by the index
+  bool is_view_ = false;
+  std::span<const uint8_t> doc_view_;
+  std::span<const uint8_t> freq_view_;
+  std::span<const uint8_t> coord_view_;
+  std::span<const Skip> skips_view_;
+
   size_t size_ = 0;
   uint32_t last_doc_id_ = 0;
+
+  // Upper bounds for ranked retrieval
+  uint32_t max_tf_ = 0;
+  uint32_t min_doc_length_ = UINT32_MAX;
 };
 
 }  // namespace indexing
@@ -2,6 +2,11 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <random>
+
+#include "engine/indexing/posting_list.h"
+
 using namespace indexing;
 
 TEST(CompressedPostingListTest, ReadItr) {
@@ -78,6 +83,23 @@ TEST(CompressedPostingListTest, SkipToItr) {
   }
 }
 
+TEST(CompressedPostingListTest, SkipToOnEmptyList) {
+  const CompressedPostingList empty;
+  auto itr = empty.begin();
+  ASSERT_TRUE(itr.IsEnd());
+  itr.SkipTo(5);
+  EXPECT_TRUE(itr.IsEnd());
+
+  // Past the last document
+  CompressedPostingList list;
+  list.Add(1, {0});
+  auto jtr = list.begin();
+  jtr.SkipTo(2);
+  ASSERT_TRUE(jtr.IsEnd());
+  jtr.SkipTo(3);
+  EXPECT_TRUE(jtr.IsEnd());
+}
+
 TEST(CompressedPostingListTest, Intersect) {
   CompressedPostingList list1;
   list1.Add(1, {0});
@@ -115,3 +137,372 @@ TEST(CompressedPostingListTest, Merge) {
     EXPECT_EQ(doc_id, expected_doc_ids[i++]);
   }
 }
+
+TEST(CompressedPostingListTest, BlockMax) {
+  CompressedPostingList list;
+  DocLengths doc_lengths(0, std::vector<uint32_t>(64, 10));
+  // skip step == 8, the only frequent posting is in the third block
+  for (indexing::DocID i = 0; i < 64; ++i) {
+    if (i == 20) {
+      list.Add(i, {0, 1, 2});
+    } else {
+      list.Add(i, {0});
+    }
+  }
+  doc_lengths.Set(42, 2);
+  list.BuildSkips(doc_lengths);
+
+  auto itr = list.begin();
+  auto block = itr.GetBlockMax(20);
+  EXPECT_EQ(block.last_doc_id, 23);
+  EXPECT_EQ(block.max_tf, 3);
+  EXPECT_EQ(block.min_doc_length, 10);
+  EXPECT_EQ(itr->doc_id, 0);
+
+  block = itr.GetBlockMax(42);
+  EXPECT_EQ(block.max_tf, 1);
+  EXPECT_EQ(block.min_doc_length, 2);
+
+  itr.SkipToBlock(5, [](const auto& block) { return block.max_tf > 1; });
+  EXPECT_EQ(itr->doc_id, 16);
+  itr.SkipToBlock(21,
+                  [](const auto& block) { return block.min_doc_length < 5; });
+  EXPECT_EQ(itr->doc_id, 40);
+  itr.SkipToBlock(41, [](const auto& block) { return block.max_tf > 1; });
+  EXPECT_TRUE(itr.IsEnd());
+}
+
+TEST(CompressedPostingListTest, Substract) {
+  CompressedPostingList list1;
+  for (indexing::DocID i = 0; i < 10; ++i) {
+    list1.Add(i, {0});
+  }
+  CompressedPostingList list2;
+  for (indexing::DocID i = 1; i < 100; i += 3) {
+    list2.Add(i, {0});
+  }
+  list2.BuildSkips();
+
+  const auto substracted = list1 - list2;
+  const std::vector<indexing::DocID> expected_doc_ids = {0, 2, 3, 5, 6, 8, 9};
+  EXPECT_EQ(substracted.size(), expected_doc_ids.size());
+  int i = 0;
+  for (auto [doc_id, _] : substracted) {
+    EXPECT_EQ(doc_id, expected_doc_ids[i++]);
+  }
+}
+
+TEST(CompressedPostingListTest, BitPacking) {
+  CompressedPostingList plain;
+  DocLengths doc_lengths;
+  DocID doc_id = 0;
+  for (uint32_t i = 0; i < 3000; ++i) {
+    doc_id += 1 + i % 17 * (i % 5);
+    std::vector<uint32_t> coords;
+    for (uint32_t coord = i % 3; coord < 40; coord += 1 + i % 11) {
+      coords.push_back(coord);
+    }
+    doc_lengths.Set(doc_id, 40);
+    plain.Add(doc_id, coords, 40);
+  }
+  auto packed = plain;
+  plain.BuildSkips(doc_lengths, 300);
+  packed.BuildSkips(doc_lengths, 300, CodecType::kBitPacking);
+  EXPECT_EQ(packed.codec(), CodecType::kBitPacking);
+  EXPECT_EQ(packed.size(), plain.size());
+  EXPECT_LT(packed.MemoryUsage(), plain.MemoryUsage());
+  EXPECT_THROW(packed.Add(doc_id + 1, {0}), std::runtime_error);
+
+  auto jtr = packed.begin();
+  for (auto itr = plain.begin(); itr != plain.end(); ++itr, ++jtr) {
+    ASSERT_NE(jtr, packed.end());
+    ASSERT_EQ(*jtr, *itr);
+    auto coord_itr = itr.GetCoordItr();
+    auto coord_jtr = jtr.GetCoordItr();
+    for (; !coord_itr.IsEnd(); ++coord_itr, ++coord_jtr) {
+      ASSERT_FALSE(coord_jtr.IsEnd());
+      EXPECT_EQ(*coord_jtr, *coord_itr);
+    }
+    EXPECT_TRUE(coord_jtr.IsEnd());
+  }
+  EXPECT_EQ(jtr, packed.end());
+
+  auto itr = plain.begin();
+  jtr = packed.begin();
+  for (DocID target = 0; !itr.IsEnd(); target += 97) {
+    EXPECT_EQ(jtr.GetBlockMax(target).max_tf,
+              itr.GetBlockMax(target).max_tf);
+    itr.SkipTo(target);
+    jtr.SkipTo(target);
+    ASSERT_EQ(jtr.IsEnd(), itr.IsEnd());
+    if (!itr.IsEnd()) {
+      EXPECT_EQ(*jtr, *itr);
+      EXPECT_EQ(*jtr.GetCoordItr(), *itr.GetCoordItr());
+    }
+  }
+
+  // Blocks are decoded back when the skips are rebuilt
+  packed.BuildSkips(doc_lengths, 0, CodecType::kVByte);
+  EXPECT_EQ(packed.Decompress().postings(), plain.Decompress().postings());
+  EXPECT_EQ(packed.max_tf(), plain.max_tf());
+}
+
+TEST(CompressedPostingListTest, SparseCoordAccess) {
+  std::vector<std::vector<uint32_t>> expected;
+  for (uint32_t i = 0; i < 500; ++i) {
+    std::vector<uint32_t> coords;
+    for (uint32_t coord = i % 4; coord < 30; coord += 1 + i % 7) {
+      coords.push_back(coord);
+    }
+    expected.push_back(coords);
+  }
+  for (const auto codec : {CodecType::kVByte, CodecType::kBitPacking}) {
+    CompressedPostingList list;
+    for (DocID i = 0; i < expected.size(); ++i) {
+      list.Add(i * 2, expected[i]);
+    }
+    list.BuildSkips({}, 16, codec);
+
+    // Tfs and coords are read for some postings only, the streams have to
+    // catch up with the doc stream
+    auto itr = list.begin();
+    for (DocID target = 0; !itr.IsEnd(); target += 37) {
+      itr.SkipTo(target);
+      for (size_t i = 0; i < 5 && !itr.IsEnd(); ++i, ++itr) {
+        const auto& coords = expected[itr.doc_id() / 2];
+        if (itr.doc_id() % 3 == 0) {
+          EXPECT_EQ(itr->tf, coords.size());
+        }
+        if (itr.doc_id() % 4 == 0) {
+          std::vector<uint32_t> actual;
+          for (auto jtr = itr.GetCoordItr(); !jtr.IsEnd(); ++jtr) {
+            actual.push_back(*jtr);
+          }
+          EXPECT_EQ(actual, coords);
+        }
+      }
+    }
+  }
+}
+
+TEST(CompressedPostingListTest, DocStreamSize) {
+  CompressedPostingList list;
+  // Bytes the doc stream took with the coord offsets interleaved
+  size_t interleaved_size = 0;
+  size_t coords_size = 0;
+  const auto vbyte_size = [](uint32_t value) {
+    return value < (1u << 7) ? 1 : value < (1u << 14) ? 2 : 3;
+  };
+  DocID doc_id = 0;
+  for (uint32_t i = 0; i < 10000; ++i) {
+    const uint32_t gap = 1 + i % 5;
+    doc_id += gap;
+    std::vector<uint32_t> coords;
+    for (uint32_t coord = 0; coord < 1 + i % 8; ++coord) {
+      coords.push_back(coord * 10);
+    }
+    list.Add(doc_id, coords);
+    interleaved_size +=
+        vbyte_size(gap) + vbyte_size(static_cast<uint32_t>(coords_size));
+    coords_size += 1 + coords.size();
+  }
+  // Boolean traversal reads a byte per posting instead of four, even less
+  // once the doc stream is Elias-Fano
+  EXPECT_EQ(list.DocDataSize(), list.size());
+  EXPECT_LT(list.DocDataSize() * 3, interleaved_size);
+  list.BuildSkips();
+  EXPECT_LE(list.DocDataSize(), list.size());
+
+  size_t count = 0;
+  for (auto itr = list.begin(); !itr.IsEnd(); ++itr) {
+    ++count;
+  }
+  EXPECT_EQ(count, list.size());
+}
+
+TEST(CompressedPostingListTest, EliasFano) {
+  std::vector<DocID> doc_ids;
+  std::vector<std::vector<uint32_t>> coords;
+  DocID doc_id = 0;
+  for (uint32_t i = 0; i < 5000; ++i) {
+    // Rare long gaps widen the bit-packed frames, not Elias-Fano
+    doc_id += i % 100 == 0 ? 5000 : 1 + i % 4;
+    doc_ids.push_back(doc_id);
+    coords.push_back({i % 5, 10 + i % 3});
+  }
+
+  for (const auto codec : {CodecType::kVByte, CodecType::kBitPacking}) {
+    CompressedPostingList list;
+    for (size_t i = 0; i < doc_ids.size(); ++i) {
+      list.Add(doc_ids[i], coords[i]);
+    }
+    const auto gaps_size = list.DocDataSize();
+    list.BuildSkips({}, 0, codec);
+    EXPECT_EQ(list.doc_encoding(), DocEncoding::kEliasFano);
+    EXPECT_EQ(list.codec(), codec);
+    EXPECT_LT(list.DocDataSize(), gaps_size);
+    EXPECT_THROW(list.Add(doc_id + 1, {0}), std::runtime_error);
+
+    size_t i = 0;
+    for (auto itr = list.begin(); !itr.IsEnd(); ++itr, ++i) {
+      ASSERT_LT(i, doc_ids.size());
+      EXPECT_EQ(itr.doc_id(), doc_ids[i]);
+      if (i % 7 == 0) {
+        std::vector<uint32_t> actual;
+        for (auto jtr = itr.GetCoordItr(); !jtr.IsEnd(); ++jtr) {
+          actual.push_back(*jtr);
+        }
+        EXPECT_EQ(actual, coords[i]);
+      }
+    }
+    EXPECT_EQ(i, doc_ids.size());
+
+    auto itr = list.begin();
+    for (DocID target = 0; target <= doc_id + 1; target += 1 + target % 613) {
+      itr.SkipTo(target);
+      const auto expected =
+          std::lower_bound(doc_ids.begin(), doc_ids.end(), target);
+      ASSERT_EQ(itr.IsEnd(), expected == doc_ids.end());
+      if (itr.IsEnd()) {
+        break;
+      }
+      EXPECT_EQ(itr.doc_id(), *expected);
+      EXPECT_EQ(itr->tf, coords[expected - doc_ids.begin()].size());
+    }
+
+    // Rebuilding the skips goes through the plain layout
+    list.BuildSkips({}, 16);
+    EXPECT_EQ(list.Decompress().postings().size(), doc_ids.size());
+  }
+
+  // Partitions of a short sparse list are larger than its gaps
+  CompressedPostingList sparse;
+  for (DocID id = 0; id < 10000; id += 1000) {
+    sparse.Add(id, {0});
+  }
+  sparse.BuildSkips();
+  EXPECT_EQ(sparse.doc_encoding(), DocEncoding::kGaps);
+}
+
+TEST(CompressedPostingListTest, Bitmap) {
+  // Two dense lists and a sparse one, with a run of every document
+  std::vector<DocID> halves;
+  std::vector<DocID> thirds;
+  std::vector<DocID> sparse;
+  for (DocID doc_id = 0; doc_id < 20000; ++doc_id) {
+    if (doc_id % 2 == 0 || (doc_id >= 5000 && doc_id < 6000)) {
+      halves.push_back(doc_id);
+    }
+    if (doc_id % 3 != 0) {
+      thirds.push_back(doc_id);
+    }
+    if (doc_id % 97 == 0) {
+      sparse.push_back(doc_id);
+    }
+  }
+  const auto build = [](const std::vector<DocID>& doc_ids) {
+    CompressedPostingList list;
+    for (const auto doc_id : doc_ids) {
+      list.Add(doc_id, {doc_id % 5, 10});
+    }
+    list.BuildSkips();
+    return list;
+  };
+  const auto to_vector = [](const CompressedPostingList& list) {
+    std::vector<DocID> doc_ids;
+    for (auto itr = list.begin(); !itr.IsEnd(); ++itr) {
+      doc_ids.push_back(itr.doc_id());
+    }
+    return doc_ids;
+  };
+
+  const auto halves_list = build(halves);
+  const auto thirds_list = build(thirds);
+  const auto sparse_list = build(sparse);
+  EXPECT_EQ(halves_list.doc_encoding(), DocEncoding::kBitmap);
+  EXPECT_EQ(thirds_list.doc_encoding(), DocEncoding::kBitmap);
+  EXPECT_NE(sparse_list.doc_encoding(), DocEncoding::kBitmap);
+  // Less than the three bits a posting of Elias-Fano
+  EXPECT_LT(halves_list.DocDataSize() * 8, halves.size() * 3);
+  EXPECT_EQ(to_vector(halves_list), halves);
+
+  auto itr = halves_list.begin();
+  for (DocID target = 0; target <= 20000; target += 1 + target % 331) {
+    itr.SkipTo(target);
+    const auto expected = std::lower_bound(halves.begin(), halves.end(),
+                                           target);
+    ASSERT_EQ(itr.IsEnd(), expected == halves.end());
+    if (itr.IsEnd()) {
+      break;
+    }
+    EXPECT_EQ(itr.doc_id(), *expected);
+    EXPECT_EQ(itr->tf, 2);
+    EXPECT_EQ(*itr.GetCoordItr(), *expected % 5);
+  }
+
+  for (const auto* other : {&thirds, &sparse}) {
+    const auto other_list = build(*other);
+    std::vector<DocID> expected;
+    std::set_intersection(halves.begin(), halves.end(), other->begin(),
+                          other->end(), std::back_inserter(expected));
+    EXPECT_EQ(to_vector(halves_list & other_list), expected);
+    EXPECT_EQ(to_vector(other_list & halves_list), expected);
+
+    expected.clear();
+    std::set_union(halves.begin(), halves.end(), other->begin(), other->end(),
+                   std::back_inserter(expected));
+    EXPECT_EQ(to_vector(halves_list | other_list), expected);
+
+    expected.clear();
+    std::set_difference(halves.begin(), halves.end(), other->begin(),
+                        other->end(), std::back_inserter(expected));
+    EXPECT_EQ(to_vector(halves_list - other_list), expected);
+
+    expected.clear();
+    std::set_difference(other->begin(), other->end(), halves.begin(),
+                        halves.end(), std::back_inserter(expected));
+    EXPECT_EQ(to_vector(other_list - halves_list), expected);
+  }
+}
+
+TEST(CompressedPostingListTest, IntersectAll) {
+  std::mt19937 rng(9);
+  std::vector<std::vector<DocID>> doc_ids(4);
+  for (DocID doc_id = 0; doc_id < 50000; ++doc_id) {
+    for (size_t i = 0; i < doc_ids.size(); ++i) {
+      // From every other document down to a thousand of them, every 97th
+      // is common to all
+      if (doc_id % 97 == 0 || rng() % (2 << (i * 2)) == 0) {
+        doc_ids[i].push_back(doc_id);
+      }
+    }
+  }
+
+  for (const auto codec : {CodecType::kVByte, CodecType::kBitPacking}) {
+    std::vector<CompressedPostingList> lists(doc_ids.size());
+    for (size_t i = 0; i < doc_ids.size(); ++i) {
+      for (const auto doc_id : doc_ids[i]) {
+        lists[i].Add(doc_id, {0});
+      }
+      lists[i].BuildSkips({}, 0, codec);
+    }
+
+    // Longest first, so the shortest has to be picked as the driver
+    std::vector<const CompressedPostingList*> ptrs;
+    auto expected = lists[0];
+    for (size_t i = 0; i < lists.size(); ++i) {
+      ptrs.push_back(&lists[i]);
+      if (i > 0) {
+        expected = expected & lists[i];
+      }
+      EXPECT_EQ(CompressedPostingList::IntersectAll(ptrs).Decompress().docs(),
+                expected.Decompress().docs());
+    }
+    EXPECT_GT(expected.size(), 0);
+  }
+
+  EXPECT_EQ(CompressedPostingList::IntersectAll({}).size(), 0);
+  CompressedPostingList empty;
+  std::vector<const CompressedPostingList*> with_empty{&empty};
+  EXPECT_EQ(CompressedPostingList::IntersectAll(with_empty).size(), 0);
+}
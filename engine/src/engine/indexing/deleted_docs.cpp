@@ -0,0 +1,122 @@
+#include "engine/indexing/deleted_docs.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace indexing {
+
+DeletedDocs::DeletedDocs(DeletedDocs&& other) noexcept
+    : words_(std::move(other.words_)),
+      capacity_(other.capacity_),
+      first_doc_id_(other.first_doc_id_),
+      size_(other.size_),
+      count_(other.count_.load()) {
+  other.capacity_ = 0;
+  other.first_doc_id_ = 0;
+  other.size_ = 0;
+  other.count_ = 0;
+}
+
+DeletedDocs& DeletedDocs::operator=(DeletedDocs&& other) noexcept {
+  words_ = std::move(other.words_);
+  capacity_ = other.capacity_;
+  first_doc_id_ = other.first_doc_id_;
+  size_ = other.size_;
+  count_ = other.count_.load();
+  other.capacity_ = 0;
+  other.first_doc_id_ = 0;
+  other.size_ = 0;
+  other.count_ = 0;
+  return *this;
+}
+
+DocID DeletedDocs::first_doc_id() const { return first_doc_id_; }
+
+DocID DeletedDocs::end_doc_id() const { return first_doc_id_ + size_; }
+
+size_t DeletedDocs::count() const { return count_; }
+
+void DeletedDocs::Resize(DocID first_doc_id, DocID end_doc_id) {
+  if (first_doc_id >= end_doc_id) {
+    return;
+  }
+  if (size_ == 0) {
+    first_doc_id_ = first_doc_id;
+  } else if (first_doc_id < first_doc_id_) {
+    // Documents are mostly added in id order, so the rare moves of the
+    // start rebuild the bits
+    const auto words = GetWords();
+    const DocID old_first = first_doc_id_;
+    const size_t old_size = size_;
+    const DocID old_end = this->end_doc_id();
+    words_.reset();
+    capacity_ = 0;
+    size_ = 0;
+    Resize(first_doc_id, std::max(end_doc_id, old_end));
+    for (size_t i = 0; i < old_size; ++i) {
+      if (words[i / kWordBits] & (1ull << (i % kWordBits))) {
+        const size_t pos = old_first + i - first_doc_id_;
+        words_[pos / kWordBits] |= 1ull << (pos % kWordBits);
+      }
+    }
+    return;
+  }
+
+  const size_t docs_count = std::max<size_t>(end_doc_id, this->end_doc_id()) -
+                            first_doc_id_;
+  const size_t words_count = (docs_count + kWordBits - 1) / kWordBits;
+  if (words_count > capacity_) {
+    const size_t capacity = std::max(words_count, capacity_ * 2);
+    auto words = std::make_unique<std::atomic<uint64_t>[]>(capacity);
+    for (size_t i = 0; i < capacity; ++i) {
+      words[i] = i < capacity_ ? words_[i].load() : 0;
+    }
+    words_ = std::move(words);
+    capacity_ = capacity;
+  }
+  size_ = docs_count;
+}
+
+bool DeletedDocs::Insert(DocID doc_id) {
+  if (doc_id < first_doc_id_ || doc_id - first_doc_id_ >= size_) {
+    return false;
+  }
+  doc_id -= first_doc_id_;
+  const uint64_t bit = 1ull << (doc_id % kWordBits);
+  const auto prev = words_[doc_id / kWordBits].fetch_or(bit);
+  if (prev & bit) {
+    return false;
+  }
+  ++count_;
+  return true;
+}
+
+bool DeletedDocs::Contains(DocID doc_id) const {
+  if (doc_id < first_doc_id_ || doc_id - first_doc_id_ >= size_ ||
+      count_.load(std::memory_order_relaxed) == 0) {
+    return false;
+  }
+  doc_id -= first_doc_id_;
+  const uint64_t bit = 1ull << (doc_id % kWordBits);
+  return words_[doc_id / kWordBits].load(std::memory_order_relaxed) & bit;
+}
+
+std::vector<uint64_t> DeletedDocs::GetWords() const {
+  std::vector<uint64_t> words((size_ + kWordBits - 1) / kWordBits);
+  for (size_t i = 0; i < words.size(); ++i) {
+    words[i] = words_[i];
+  }
+  return words;
+}
+
+void DeletedDocs::SetWords(const std::vector<uint64_t>& words) {
+  const size_t words_count = (size_ + kWordBits - 1) / kWordBits;
+  size_t count = 0;
+  for (size_t i = 0; i < words_count; ++i) {
+    words_[i] = i < words.size() ? words[i] : 0;
+    count += std::popcount(words_[i].load());
+  }
+  count_ = count;
+}
+
+}  // namespace indexing
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "engine/indexing/types.h"
+
+namespace indexing {
+
+// Tombstones of deleted documents of an id range. Insert and Contains may
+// run concurrently, Resize may not run concurrently with either.
+class DeletedDocs {
+ public:
+  DeletedDocs() = default;
+  DeletedDocs(DeletedDocs&& other) noexcept;
+  DeletedDocs& operator=(DeletedDocs&& other) noexcept;
+
+  // First and one past the last document that can be marked
+  DocID first_doc_id() const;
+  DocID end_doc_id() const;
+  // Number of deleted documents
+  size_t count() const;
+
+  // Extends the range to [first_doc_id, end_doc_id). Grows geometrically at
+  // the end, so resizing per added document is cheap.
+  void Resize(DocID first_doc_id, DocID end_doc_id);
+  // Returns false if the document is out of range or already deleted
+  bool Insert(DocID doc_id);
+  bool Contains(DocID doc_id) const;
+
+  // Bits of the range from first_doc_id()
+  std::vector<uint64_t> GetWords() const;
+  void SetWords(const std::vector<uint64_t>& words);
+
+ private:
+  static constexpr size_t kWordBits = 64;
+
+  std::unique_ptr<std::atomic<uint64_t>[]> words_;
+  size_t capacity_ = 0;
+  DocID first_doc_id_ = 0;
+  size_t size_ = 0;
+  std::atomic<size_t> count_ = 0;
+};
+
+}  // namespace indexing
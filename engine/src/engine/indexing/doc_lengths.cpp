@@ -0,0 +1,41 @@
+#include "engine/indexing/doc_lengths.h"
+
+namespace indexing {
+
+DocLengths::DocLengths(DocID first_doc_id, std::vector<uint32_t> lengths)
+    : first_doc_id_(first_doc_id), lengths_(std::move(lengths)) {}
+
+uint32_t DocLengths::operator[](DocID doc_id) const {
+  if (doc_id < first_doc_id_ || doc_id - first_doc_id_ >= lengths_.size()) {
+    return 0;
+  }
+  return lengths_[doc_id - first_doc_id_];
+}
+
+void DocLengths::Set(DocID doc_id, uint32_t length) {
+  if (lengths_.empty()) {
+    first_doc_id_ = doc_id;
+  } else if (doc_id < first_doc_id_) {
+    // Documents are mostly added in id order, so this is rare
+    lengths_.insert(lengths_.begin(), first_doc_id_ - doc_id, 0);
+    first_doc_id_ = doc_id;
+  }
+  if (doc_id - first_doc_id_ >= lengths_.size()) {
+    lengths_.resize(doc_id - first_doc_id_ + 1, 0);
+  }
+  lengths_[doc_id - first_doc_id_] = length;
+}
+
+DocID DocLengths::first_doc_id() const { return first_doc_id_; }
+
+DocID DocLengths::end_doc_id() const {
+  return lengths_.empty() ? 0 : first_doc_id_ + lengths_.size();
+}
+
+const std::vector<uint32_t>& DocLengths::values() const { return lengths_; }
+
+size_t DocLengths::MemoryUsage() const {
+  return lengths_.capacity() * sizeof(uint32_t);
+}
+
+}  // namespace indexing
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine/indexing/types.h"
+
+namespace indexing {
+
+// Lengths of the documents of an index by id. Only the range between its
+// smallest and largest ids is stored, so an index of recent documents
+// doesn't pay for the ids before them.
+class DocLengths {
+ public:
+  DocLengths() = default;
+  DocLengths(DocID first_doc_id, std::vector<uint32_t> lengths);
+
+  // 0 for documents outside the range
+  uint32_t operator[](DocID doc_id) const;
+  // Extends the range to the document
+  void Set(DocID doc_id, uint32_t length);
+
+  DocID first_doc_id() const;
+  // One past the largest id of the range, 0 if it is empty
+  DocID end_doc_id() const;
+  // Lengths of the range from first_doc_id()
+  const std::vector<uint32_t>& values() const;
+  size_t MemoryUsage() const;
+
+ private:
+  DocID first_doc_id_ = 0;
+  std::vector<uint32_t> lengths_;
+};
+
+}  // namespace indexing
@@ -0,0 +1,196 @@
+#include "engine/indexing/elias_fano.h"
+
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+#include "engine/indexing/codec.h"
+
+namespace {
+
+constexpr size_t kWordBits = 64;
+
+[[noreturn]] void ThrowCorrupted() {
+  throw std::runtime_error("EliasFano: corrupted input");
+}
+
+uint32_t LowBits(size_t count, uint32_t max_value) {
+  const uint64_t ratio = count == 0 ? 0 : max_value / count;
+  return ratio == 0 ? 0 : std::bit_width(ratio) - 1;
+}
+
+size_t HighBits(size_t count, uint32_t max_value, uint32_t low_bits) {
+  return count + (max_value >> low_bits) + 1;
+}
+
+size_t Words(size_t bits) { return (bits + kWordBits - 1) / kWordBits; }
+
+size_t VByteSize(uint32_t value) {
+  size_t size = 1;
+  for (; value >= 128; value >>= 7) {
+    ++size;
+  }
+  return size;
+}
+
+uint64_t LoadWord(const uint8_t* in, size_t idx) {
+  uint64_t word;
+  std::memcpy(&word, in + idx * sizeof(word), sizeof(word));
+  return word;
+}
+
+void AppendWords(const std::vector<uint64_t>& words,
+                 std::vector<uint8_t>& out) {
+  // No words without low bits, and memcpy takes no null pointers
+  if (words.empty()) {
+    return;
+  }
+  const size_t offset = out.size();
+  out.resize(offset + words.size() * sizeof(uint64_t));
+  std::memcpy(out.data() + offset, words.data(),
+              words.size() * sizeof(uint64_t));
+}
+
+}  // namespace
+
+namespace indexing {
+
+size_t EliasFanoSize(size_t count, uint32_t max_value) {
+  const auto low_bits = LowBits(count, max_value);
+  return VByteSize(max_value) +
+         (Words(count * low_bits) +
+          Words(HighBits(count, max_value, low_bits))) *
+             sizeof(uint64_t);
+}
+
+void EliasFanoEncode(std::span<const uint32_t> values,
+                     std::vector<uint8_t>& out) {
+  const uint32_t max_value = values.empty() ? 0 : values.back();
+  GetCodec(CodecType::kVByte).Encode({&max_value, 1}, out);
+
+  const auto low_bits = LowBits(values.size(), max_value);
+  const uint64_t mask = (uint64_t{1} << low_bits) - 1;
+  std::vector<uint64_t> low(Words(values.size() * low_bits));
+  std::vector<uint64_t> high(
+      Words(HighBits(values.size(), max_value, low_bits)));
+  for (size_t i = 0; i < values.size(); ++i) {
+    if (low_bits > 0) {
+      const size_t bit = i * low_bits;
+      const uint64_t value = values[i] & mask;
+      low[bit / kWordBits] |= value << (bit % kWordBits);
+      if (bit % kWordBits + low_bits > kWordBits) {
+        low[bit / kWordBits + 1] |= value >> (kWordBits - bit % kWordBits);
+      }
+    }
+    const size_t bit = (values[i] >> low_bits) + i;
+    high[bit / kWordBits] |= uint64_t{1} << (bit % kWordBits);
+  }
+  AppendWords(low, out);
+  AppendWords(high, out);
+}
+
+EliasFanoReader::EliasFanoReader(std::span<const uint8_t> in, size_t count)
+    : count_(count) {
+  uint32_t max_value = 0;
+  const size_t idx = GetCodec(CodecType::kVByte).Decode(in, {&max_value, 1});
+  low_bits_ = LowBits(count, max_value);
+  const size_t low_words = Words(count * low_bits_);
+  high_words_ = Words(HighBits(count, max_value, low_bits_));
+  if ((in.size() - idx) / sizeof(uint64_t) < low_words + high_words_) {
+    ThrowCorrupted();
+  }
+  low_ = in.data() + idx;
+  high_ = low_ + low_words * sizeof(uint64_t);
+  if (count_ > 0) {
+    SeekOne(0);
+  }
+}
+
+size_t EliasFanoReader::size() const { return count_; }
+
+size_t EliasFanoReader::position() const { return position_; }
+
+uint32_t EliasFanoReader::value() const {
+  return static_cast<uint32_t>((high_pos_ - position_) << low_bits_) |
+         Low(position_);
+}
+
+void EliasFanoReader::Next() {
+  if (++position_ < count_) {
+    SeekOne(high_pos_ + 1);
+  }
+}
+
+void EliasFanoReader::NextGEQ(uint32_t target) {
+  if (position_ >= count_ || value() >= target) {
+    return;
+  }
+
+  // Zeros before a bit of the bitmap give the high part of its value, the
+  // target bucket starts past the zero ending the bucket before it
+  const size_t bucket = target >> low_bits_;
+  const size_t current_bucket = high_pos_ - position_;
+  if (bucket > current_bucket) {
+    size_t zeros = bucket - current_bucket;
+    size_t word_idx = high_pos_ / kWordBits;
+    uint64_t word = ~HighWord(word_idx) & (~uint64_t{0}
+                                           << (high_pos_ % kWordBits));
+    for (size_t count = std::popcount(word); count < zeros;
+         count = std::popcount(word)) {
+      zeros -= count;
+      if (++word_idx >= high_words_) {
+        position_ = count_;
+        return;
+      }
+      word = ~HighWord(word_idx);
+    }
+    for (; zeros > 1; --zeros) {
+      word &= word - 1;
+    }
+    const size_t zero_pos = word_idx * kWordBits + std::countr_zero(word);
+    position_ = zero_pos + 1 - bucket;
+    if (position_ >= count_) {
+      position_ = count_;
+      return;
+    }
+    SeekOne(zero_pos + 1);
+  }
+
+  while (position_ < count_ && value() < target) {
+    Next();
+  }
+}
+
+uint64_t EliasFanoReader::HighWord(size_t idx) const {
+  return LoadWord(high_, idx);
+}
+
+uint32_t EliasFanoReader::Low(size_t idx) const {
+  if (low_bits_ == 0) {
+    return 0;
+  }
+  const size_t bit = idx * low_bits_;
+  const size_t shift = bit % kWordBits;
+  uint64_t value = LoadWord(low_, bit / kWordBits) >> shift;
+  if (shift + low_bits_ > kWordBits) {
+    value |= LoadWord(low_, bit / kWordBits + 1) << (kWordBits - shift);
+  }
+  return static_cast<uint32_t>(value & ((uint64_t{1} << low_bits_) - 1));
+}
+
+void EliasFanoReader::SeekOne(size_t bit) {
+  size_t word_idx = bit / kWordBits;
+  if (word_idx >= high_words_) {
+    ThrowCorrupted();
+  }
+  uint64_t word = HighWord(word_idx) & (~uint64_t{0} << (bit % kWordBits));
+  while (word == 0) {
+    if (++word_idx >= high_words_) {
+      ThrowCorrupted();
+    }
+    word = HighWord(word_idx);
+  }
+  high_pos_ = word_idx * kWordBits + std::countr_zero(word);
+}
+
+}  // namespace indexing
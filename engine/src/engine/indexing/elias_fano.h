@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace indexing {
+
+// Elias-Fano encoding of a non-decreasing sequence. The low bits of every
+// value are packed at a common width and the high bits are kept in unary in
+// a bitmap, about 2 + log(max / count) bits per value. The first value >= a
+// target is found by counting bits a word at a time, without decoding the
+// values before it.
+//
+// Layout: VByte largest value, then the low bits and the bitmap in 64-bit
+// words. The count of values is not stored.
+
+// Bytes taken by `count` values up to `max_value`
+size_t EliasFanoSize(size_t count, uint32_t max_value);
+void EliasFanoEncode(std::span<const uint32_t> values,
+                     std::vector<uint8_t>& out);
+
+// Forward cursor over an encoded sequence, starts at its first value
+class EliasFanoReader {
+ public:
+  EliasFanoReader() = default;
+  // Throws if `in` ends before `count` values
+  EliasFanoReader(std::span<const uint8_t> in, size_t count);
+
+  size_t size() const;
+  // Index of the current value, size() past the last one
+  size_t position() const;
+  uint32_t value() const;
+
+  void Next();
+  // Moves to the first value >= target, never backwards
+  void NextGEQ(uint32_t target);
+
+ private:
+  uint64_t HighWord(size_t idx) const;
+  uint32_t Low(size_t idx) const;
+  // Moves the high bit to the first set bit at or after `bit`
+  void SeekOne(size_t bit);
+
+  const uint8_t* low_ = nullptr;
+  const uint8_t* high_ = nullptr;
+  size_t high_words_ = 0;
+  size_t count_ = 0;
+  uint32_t low_bits_ = 0;
+
+  size_t position_ = 0;
+  // Bit of the current value in the bitmap
+  size_t high_pos_ = 0;
+};
+
+}  // namespace indexing
@@ -0,0 +1,82 @@
+#include "engine/indexing/elias_fano.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+
+using namespace indexing;
+
+namespace {
+
+std::vector<uint32_t> RandomSequence(size_t size, uint32_t max_gap,
+                                     std::mt19937& rng) {
+  std::vector<uint32_t> values(size);
+  uint32_t value = 0;
+  for (size_t i = 0; i < size; ++i) {
+    values[i] = value;
+    value += rng() % (max_gap + 1);
+  }
+  return values;
+}
+
+}  // namespace
+
+TEST(EliasFanoTest, RoundTrip) {
+  std::mt19937 rng(42);
+  for (const size_t size : {1, 2, 63, 64, 65, 1000}) {
+    for (const uint32_t max_gap : {0, 1, 3, 100, 100000}) {
+      const auto values = RandomSequence(size, max_gap, rng);
+      std::vector<uint8_t> encoded;
+      EliasFanoEncode(values, encoded);
+      EXPECT_EQ(encoded.size(), EliasFanoSize(size, values.back()));
+
+      std::vector<uint32_t> decoded;
+      for (EliasFanoReader reader(encoded, size);
+           reader.position() < reader.size(); reader.Next()) {
+        decoded.push_back(reader.value());
+      }
+      EXPECT_EQ(decoded, values);
+    }
+  }
+}
+
+TEST(EliasFanoTest, NextGEQ) {
+  std::mt19937 rng(7);
+  for (const uint32_t max_gap : {1, 5, 1000}) {
+    const auto values = RandomSequence(2000, max_gap, rng);
+    std::vector<uint8_t> encoded;
+    EliasFanoEncode(values, encoded);
+
+    EliasFanoReader reader(encoded, values.size());
+    for (uint32_t target = 0; target <= values.back() + 1;
+         target += 1 + rng() % (3 * max_gap)) {
+      reader.NextGEQ(target);
+      const auto itr = std::lower_bound(values.begin(), values.end(), target);
+      ASSERT_EQ(reader.position(), itr - values.begin());
+      if (itr == values.end()) {
+        break;
+      }
+      EXPECT_EQ(reader.value(), *itr);
+    }
+  }
+}
+
+TEST(EliasFanoTest, DenseSequenceIsSmall) {
+  std::vector<uint32_t> values(10000);
+  for (uint32_t i = 0; i < values.size(); ++i) {
+    values[i] = i * 2;
+  }
+  // Gaps of two take three bits of bitmap per value
+  EXPECT_LT(EliasFanoSize(values.size(), values.back()), values.size() / 2);
+}
+
+TEST(EliasFanoTest, TruncatedInput) {
+  std::mt19937 rng(1);
+  const auto values = RandomSequence(300, 50, rng);
+  std::vector<uint8_t> encoded;
+  EliasFanoEncode(values, encoded);
+  encoded.pop_back();
+  EXPECT_THROW(EliasFanoReader(encoded, values.size()), std::runtime_error);
+}
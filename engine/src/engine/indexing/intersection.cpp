@@ -0,0 +1,108 @@
+#include "engine/indexing/intersection.h"
+
+#include <bit>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define INDEXING_X86 1
+#endif
+
+namespace {
+
+using indexing::DocID;
+
+// Windows this small are compared whole instead of halved further
+constexpr size_t kSimdWindow = 32;
+
+size_t CountLessScalar(const DocID* docs, size_t size, DocID target) {
+  size_t count = 0;
+  for (size_t i = 0; i < size; ++i) {
+    count += docs[i] < target;
+  }
+  return count;
+}
+
+#ifdef INDEXING_X86
+
+// Compares are signed, both sides are shifted by 2^31 to keep the order of
+// unsigned doc ids
+__attribute__((target("sse2"))) size_t CountLessSse2(const DocID* docs,
+                                                     size_t size,
+                                                     DocID target) {
+  const __m128i bias = _mm_set1_epi32(INT32_MIN);
+  const __m128i pivot =
+      _mm_xor_si128(_mm_set1_epi32(static_cast<int>(target)), bias);
+  size_t count = 0;
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    const __m128i values = _mm_xor_si128(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(docs + i)), bias);
+    count += std::popcount(static_cast<uint32_t>(
+        _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(values, pivot)))));
+  }
+  return count + CountLessScalar(docs + i, size - i, target);
+}
+
+__attribute__((target("avx2"))) size_t CountLessAvx2(const DocID* docs,
+                                                     size_t size,
+                                                     DocID target) {
+  const __m256i bias = _mm256_set1_epi32(INT32_MIN);
+  const __m256i pivot =
+      _mm256_xor_si256(_mm256_set1_epi32(static_cast<int>(target)), bias);
+  size_t count = 0;
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    const __m256i values = _mm256_xor_si256(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(docs + i)), bias);
+    count += std::popcount(static_cast<uint32_t>(_mm256_movemask_ps(
+        _mm256_castsi256_ps(_mm256_cmpgt_epi32(pivot, values)))));
+  }
+  return count + CountLessScalar(docs + i, size - i, target);
+}
+
+#endif
+
+size_t CountLess(const DocID* docs, size_t size, DocID target,
+                 indexing::SimdKernel kernel) {
+  switch (kernel) {
+#ifdef INDEXING_X86
+    case indexing::SimdKernel::kAvx2:
+      return CountLessAvx2(docs, size, target);
+    case indexing::SimdKernel::kSse2:
+      return CountLessSse2(docs, size, target);
+#endif
+    default:
+      return CountLessScalar(docs, size, target);
+  }
+}
+
+}  // namespace
+
+namespace indexing {
+
+size_t LowerBound(std::span<const DocID> docs, size_t from, DocID target,
+                  SimdKernel kernel /* = DetectSimdKernel() */) {
+  // The bound is in [low, high]
+  size_t low = from;
+  size_t high = docs.size();
+  for (size_t step = 1; step <= high - low; step *= 2) {
+    const size_t probe = low + step - 1;
+    if (docs[probe] >= target) {
+      high = probe;
+      break;
+    }
+    low = probe + 1;
+  }
+  while (high - low > kSimdWindow) {
+    const size_t middle = low + (high - low) / 2;
+    if (docs[middle] < target) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low + CountLess(docs.data() + low, high - low, target, kernel);
+}
+
+}  // namespace indexing
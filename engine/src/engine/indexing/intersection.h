@@ -0,0 +1,33 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+
+#include "engine/indexing/bit_packing.h"
+#include "engine/indexing/types.h"
+
+namespace indexing {
+
+// Like std::partition_point, but probes at doubling distances from `first`
+// before the binary search, so a point d elements away is found in
+// O(log d).
+template <typename Iterator, typename Pred>
+Iterator GallopPartitionPoint(Iterator first, Iterator last, Pred pred) {
+  for (std::ptrdiff_t step = 1; step <= last - first; step *= 2) {
+    const auto probe = first + (step - 1);
+    if (!pred(*probe)) {
+      return std::partition_point(first, probe, pred);
+    }
+    first = probe + 1;
+  }
+  return std::partition_point(first, last, pred);
+}
+
+// Index of the first of sorted `docs` from `from` on that is not less than
+// `target`. Gallops to a window of the bound and counts the smaller
+// documents of the window with SIMD compares.
+size_t LowerBound(std::span<const DocID> docs, size_t from, DocID target,
+                  SimdKernel kernel = DetectSimdKernel());
+
+}  // namespace indexing
@@ -0,0 +1,85 @@
+// Compares the n-way intersection of posting lists against chaining the
+// pairwise operator&, over lists of very different lengths.
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include "engine/indexing/compressed_posting_list.h"
+
+using namespace indexing;
+
+namespace {
+
+constexpr DocID kDocsCount = 2'000'000;
+constexpr int kRepeats = 5;
+
+CompressedPostingList RandomList(double density, std::mt19937& rng,
+                                 CodecType codec) {
+  std::bernoulli_distribution contains(density);
+  CompressedPostingList list;
+  for (DocID doc_id = 0; doc_id < kDocsCount; ++doc_id) {
+    if (contains(rng)) {
+      list.Add(doc_id, {0});
+    }
+  }
+  list.BuildSkips({}, 0, codec);
+  return list;
+}
+
+template <typename Function>
+double Measure(Function&& function, size_t& result_size) {
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kRepeats; ++i) {
+    result_size = function().size();
+  }
+  const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / kRepeats;
+}
+
+}  // namespace
+
+int main() {
+  std::mt19937 rng(42);
+  for (const auto codec : {CodecType::kVByte, CodecType::kBitPacking}) {
+    std::cout << (codec == CodecType::kVByte ? "VByte" : "BitPacking")
+              << "\n";
+    for (const auto& densities :
+         std::vector<std::vector<double>>{{0.5, 0.3, 0.001},
+                                          {0.6, 0.01, 0.005, 0.4},
+                                          {0.2, 0.2, 0.2}}) {
+      std::vector<CompressedPostingList> lists;
+      std::vector<const CompressedPostingList*> ptrs;
+      lists.reserve(densities.size());
+      for (const auto density : densities) {
+        lists.push_back(RandomList(density, rng, codec));
+        ptrs.push_back(&lists.back());
+      }
+
+      size_t pairwise_size = 0;
+      const double pairwise = Measure(
+          [&] {
+            auto result = lists[0] & lists[1];
+            for (size_t i = 2; i < lists.size(); ++i) {
+              result = result & lists[i];
+            }
+            return result;
+          },
+          pairwise_size);
+      size_t n_way_size = 0;
+      const double n_way = Measure(
+          [&] { return CompressedPostingList::IntersectAll(ptrs); },
+          n_way_size);
+
+      std::cout << "  densities";
+      for (const auto density : densities) {
+        std::cout << " " << density;
+      }
+      std::cout << ": pairwise " << pairwise << " ms, n-way " << n_way
+                << " ms, " << n_way_size << " docs"
+                << (n_way_size == pairwise_size ? "" : " (MISMATCH)") << "\n";
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,51 @@
+#include "engine/indexing/intersection.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+using namespace indexing;
+
+TEST(IntersectionTest, GallopPartitionPoint) {
+  std::vector<int> values(100);
+  for (int i = 0; i < 100; ++i) {
+    values[i] = i * 2;
+  }
+  for (int target = -1; target <= 201; ++target) {
+    for (const size_t from : {0, 1, 10, 99, 100}) {
+      const auto pred = [target](int value) { return value < target; };
+      const auto expected = std::partition_point(values.begin() + from,
+                                                 values.end(), pred);
+      EXPECT_EQ(GallopPartitionPoint(values.begin() + from, values.end(), pred),
+                expected);
+    }
+  }
+}
+
+TEST(IntersectionTest, LowerBound) {
+  std::mt19937 rng(5);
+  // Doc ids past 2^31 check the order of the signed SIMD compares
+  for (const DocID base : {0u, 0x7ffffff0u, 0xfffff000u}) {
+    std::vector<DocID> docs;
+    for (DocID doc_id = base; docs.size() < 1000; doc_id += 1 + rng() % 3) {
+      docs.push_back(doc_id);
+    }
+    for (const auto kernel :
+         {SimdKernel::kScalar, SimdKernel::kSse2, SimdKernel::kAvx2}) {
+      if (kernel > DetectSimdKernel()) {
+        continue;
+      }
+      for (size_t from = 0; from < docs.size(); from += 1 + rng() % 50) {
+        for (DocID target = docs[from] - (from == 0 ? 0 : 1);
+             target <= docs.back() + 1 && target >= base;
+             target += 1 + rng() % 200) {
+          const auto expected =
+              std::lower_bound(docs.begin() + from, docs.end(), target) -
+              docs.begin();
+          ASSERT_EQ(LowerBound(docs, from, target, kernel), expected);
+        }
+      }
+    }
+  }
+}
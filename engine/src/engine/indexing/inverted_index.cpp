@@ -1,19 +1,112 @@
 #include "engine/indexing/inverted_index.h"
 
+#include <algorithm>
+#include <atomic>
 #include <stdexcept>
+#include <thread>
 
 #include "engine/indexing/posting_list.h"
 
+namespace {
+
+uint64_t NextIndexId() {
+  static std::atomic<uint64_t> next_id = 0;
+  return next_id++;
+}
+
+}  // namespace
+
 namespace indexing {
 
-InvertedIndex::InvertedIndex() = default;
+InvertedIndex::InvertedIndex() : id_(NextIndexId()) {}
+
+InvertedIndex InvertedIndex::Merge(std::vector<InvertedIndex>&& parts,
+                                   size_t threads /* = 1 */) {
+  if (parts.size() == 1) {
+    return std::move(parts.front());
+  }
+
+  InvertedIndex result;
+  DocID first_doc_id = UINT32_MAX;
+  DocID end_doc_id = 0;
+  for (const auto& part : parts) {
+    if (part.GetDocsCount() > 0) {
+      first_doc_id = std::min(first_doc_id, part.GetFirstDocID());
+      end_doc_id = std::max<DocID>(end_doc_id, part.GetDocsCount());
+    }
+  }
+  if (first_doc_id < end_doc_id) {
+    result.doc_lengths_ = DocLengths(
+        first_doc_id, std::vector<uint32_t>(end_doc_id - first_doc_id, 0));
+  }
+  for (const auto& part : parts) {
+    for (DocID doc_id = part.GetFirstDocID(); doc_id < part.GetDocsCount();
+         ++doc_id) {
+      const auto length = part.doc_lengths_[doc_id];
+      if (length != 0 && !part.IsDeleted(doc_id)) {
+        result.doc_lengths_.Set(doc_id, length);
+      }
+    }
+  }
+  result.deleted_docs_.Resize(result.GetFirstDocID(), result.GetDocsCount());
+
+  threads = std::max(threads, 1ul);
+  std::vector<utils::HashTable<CompressedPostingList>> shards(threads);
+  const auto merge_shard = [&parts, &result, &shards, threads](size_t shard) {
+    const utils::StringHasher hasher;
+    // Lists of a term and the deletions of their parts
+    struct Group {
+      std::vector<const CompressedPostingList*> lists;
+      std::vector<const DeletedDocs*> deleted;
+    };
+    utils::HashTable<Group> groups;
+    for (const auto& part : parts) {
+      part.ForEachList([&](std::string_view term,
+                           const CompressedPostingList& list) {
+        if (hasher(term) % threads == shard) {
+          auto& group = groups[std::string(term)];
+          group.lists.push_back(&list);
+          group.deleted.push_back(&part.deleted_docs_);
+        }
+      });
+    }
+    shards[shard].reserve(groups.size());
+    for (const auto& [term, group] : groups) {
+      auto list = CompressedPostingList::MergeDisjoint(
+          group.lists, result.doc_lengths_, group.deleted);
+      if (list.size() > 0) {
+        shards[shard][term] = std::move(list);
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t shard = 0; shard < threads; ++shard) {
+    workers.emplace_back(merge_shard, shard);
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  size_t terms_count = 0;
+  for (const auto& shard : shards) {
+    terms_count += shard.size();
+  }
+  result.index_.reserve(terms_count);
+  for (auto& shard : shards) {
+    for (auto& [term, list] : shard) {
+      result.index_.insert({term, std::move(list)});
+    }
+  }
+  return result;
+}
 
 void InvertedIndex::AddDocument(DocID doc_id,
                                 const std::vector<std::string>& terms) {
-  if (doc_lengths_.size() <= doc_id) {
-    doc_lengths_.resize(doc_id + 1, 0);
-  }
-  doc_lengths_[doc_id] = terms.size();
+  CheckOwned();
+  doc_lengths_.Set(doc_id, terms.size());
+  deleted_docs_.Resize(GetFirstDocID(), GetDocsCount());
+  id_ = NextIndexId();
 
   utils::HashTable<std::vector<uint32_t>> term_coords;
   for (uint32_t i = 0; i < terms.size(); ++i) {
@@ -21,20 +114,51 @@ void InvertedIndex::AddDocument(DocID doc_id,
   }
 
   for (auto& [term, coords] : term_coords) {
-    index_[std::move(term)].Add(doc_id, std::move(coords));
+    auto itr = index_.find(term);
+    if (itr == index_.end()) {
+      // Hash table node with the term
+      memory_usage_ += sizeof(*itr) + 2 * sizeof(void*) + term.capacity();
+      itr = index_.insert({std::move(term), CompressedPostingList()}).first;
+    }
+    auto& list = itr->second;
+    memory_usage_ -= list.MemoryUsage();
+    list.Add(doc_id, coords, terms.size());
+    memory_usage_ += list.MemoryUsage();
+  }
+}
+
+void InvertedIndex::BuildSkips(
+    const SkipStepPolicy& skip_step /* = {} */,
+    CodecType codec /* = CodecType::kVByte */) {
+  CheckOwned();
+  for (auto& [term, list] : index_) {
+    list.BuildSkips(doc_lengths_, skip_step ? skip_step(term, list.size()) : 0,
+                    codec);
   }
+  codec_ = codec;
 }
 
-void InvertedIndex::BuildSkips() {
-  for (auto& [_, list] : index_) {
-    list.BuildSkips();
+bool InvertedIndex::Delete(DocID doc_id) {
+  if (doc_lengths_[doc_id] == 0) {
+    return false;
   }
+  return deleted_docs_.Insert(doc_id);
 }
 
+bool InvertedIndex::IsDeleted(DocID doc_id) const {
+  return deleted_docs_.Contains(doc_id);
+}
+
+size_t InvertedIndex::GetDeletedCount() const { return deleted_docs_.count(); }
+
 const CompressedPostingList& InvertedIndex::GetPostings(
     const std::string& term) const {
   static CompressedPostingList empty;
 
+  if (lexicon_) {
+    const auto idx = lexicon_->Find(term);
+    return idx ? lexicon_->GetPostings(*idx) : empty;
+  }
   auto itr = index_.find(term);
   if (itr != index_.end()) {
     return itr->second;
@@ -42,13 +166,46 @@ const CompressedPostingList& InvertedIndex::GetPostings(
   return empty;
 }
 
-size_t InvertedIndex::GetDocsCount() const { return doc_lengths_.size(); }
+size_t InvertedIndex::MemoryUsage() const {
+  return memory_usage_ + doc_lengths_.MemoryUsage();
+}
+
+size_t InvertedIndex::GetDocsCount() const {
+  return doc_lengths_.end_doc_id();
+}
+
+DocID InvertedIndex::GetFirstDocID() const {
+  return doc_lengths_.first_doc_id();
+}
+
+CodecType InvertedIndex::GetCodecType() const { return codec_; }
+
+uint64_t InvertedIndex::id() const { return id_; }
 
 u_int32_t InvertedIndex::GetDocLength(DocID doc_id) const {
-  if (doc_lengths_.size() <= doc_id) {
+  if (doc_lengths_.end_doc_id() <= doc_id) {
     throw std::runtime_error("InvertedIndex: unknown document");
   }
   return doc_lengths_[doc_id];
 }
 
+void InvertedIndex::ForEachList(const ListVisitor& visit) const {
+  if (lexicon_) {
+    for (size_t idx = 0; idx < lexicon_->size(); ++idx) {
+      visit(lexicon_->GetTerm(idx), lexicon_->GetPostings(idx));
+    }
+    return;
+  }
+  for (const auto& [term, list] : index_) {
+    visit(term, list);
+  }
+}
+
+void InvertedIndex::CheckOwned() const {
+  if (lexicon_) {
+    throw std::runtime_error(
+        "InvertedIndex: can't modify an index loaded from file");
+  }
+}
+
 }  // namespace indexing
@@ -1,8 +1,14 @@
 #pragma once
 
+#include <functional>
+#include <memory>
 #include <string>
+#include <string_view>
 
 #include "engine/indexing/compressed_posting_list.h"
+#include "engine/indexing/deleted_docs.h"
+#include "engine/indexing/doc_lengths.h"
+#include "engine/indexing/lexicon.h"
 #include "utils/hash_table.h"
 
 namespace storage {
@@ -13,20 +19,62 @@ namespace indexing {
 
 class InvertedIndex {
  public:
+  // Skip step of a list chosen by its term and size, 0 means the default
+  using SkipStepPolicy =
+      std::function<size_t(const std::string& term, size_t list_size)>;
+
   InvertedIndex();
 
+  // Combines partial indexes built over disjoint sets of documents. Terms
+  // are sharded across `threads` and their lists merged in parallel.
+  static InvertedIndex Merge(std::vector<InvertedIndex>&& parts,
+                             size_t threads = 1);
+
   void AddDocument(DocID doc_id, const std::vector<std::string>& terms);
-  void BuildSkips();
+  // Lists are encoded with `codec` once their skips are built
+  void BuildSkips(const SkipStepPolicy& skip_step = {},
+                  CodecType codec = CodecType::kVByte);
+
+  // Marks the document deleted: queries skip it and its postings are
+  // dropped once the lists are rewritten. Safe to call concurrently with
+  // queries, but not with AddDocument. Returns false if the document is
+  // missing or already deleted.
+  bool Delete(DocID doc_id);
+  bool IsDeleted(DocID doc_id) const;
+  size_t GetDeletedCount() const;
 
   const CompressedPostingList& GetPostings(const std::string& term) const;
+  // One past the largest document id
   size_t GetDocsCount() const;
+  // Smallest document id, the index stores nothing for the ids before it
+  DocID GetFirstDocID() const;
+  // 0 for documents the index doesn't hold
   uint32_t GetDocLength(DocID doc_id) const;
+  CodecType GetCodecType() const;
+  // Identifies the postings of the index in caches, it is never reused and
+  // changes when documents are added
+  uint64_t id() const;
+
+  // Approximate size of the postings built by AddDocument
+  size_t MemoryUsage() const;
 
  private:
   friend class storage::FileIndexStorage;
 
+  using ListVisitor =
+      std::function<void(std::string_view, const CompressedPostingList&)>;
+  void ForEachList(const ListVisitor& visit) const;
+  // Throws for an index loaded from file
+  void CheckOwned() const;
+
   utils::HashTable<CompressedPostingList> index_;
-  std::vector<uint32_t> doc_lengths_;
+  DocLengths doc_lengths_;
+  DeletedDocs deleted_docs_;
+  CodecType codec_ = CodecType::kVByte;
+  size_t memory_usage_ = 0;
+  uint64_t id_;
+  // Terms of an index loaded from file, index_ is empty then
+  std::shared_ptr<const Lexicon> lexicon_;
 };
 
 }  // namespace indexing
@@ -0,0 +1,85 @@
+#include "engine/indexing/inverted_index.h"
+
+#include <gtest/gtest.h>
+
+using indexing::DocID;
+using indexing::InvertedIndex;
+
+namespace {
+
+std::vector<std::string> MakeDocument(DocID doc_id) {
+  std::vector<std::string> terms{"all"};
+  for (DocID i = 2; i <= doc_id % 10; ++i) {
+    if (doc_id % i == 0) {
+      terms.push_back("div" + std::to_string(i));
+    }
+  }
+  terms.push_back("all");
+  return terms;
+}
+
+}  // namespace
+
+TEST(InvertedIndexTest, Merge) {
+  InvertedIndex expected;
+  std::vector<InvertedIndex> parts(3);
+  for (DocID doc_id = 0; doc_id < 300; ++doc_id) {
+    expected.AddDocument(doc_id, MakeDocument(doc_id));
+    // Batches of 16 documents spread over the parts
+    parts[doc_id / 16 % parts.size()].AddDocument(doc_id,
+                                                  MakeDocument(doc_id));
+  }
+
+  const auto merged = InvertedIndex::Merge(std::move(parts), 2);
+  ASSERT_EQ(merged.GetDocsCount(), expected.GetDocsCount());
+  for (DocID doc_id = 0; doc_id < 300; ++doc_id) {
+    EXPECT_EQ(merged.GetDocLength(doc_id), expected.GetDocLength(doc_id));
+  }
+
+  for (const std::string term : {"all", "div2", "div3", "div7", "div9"}) {
+    const auto& expected_list = expected.GetPostings(term);
+    const auto& merged_list = merged.GetPostings(term);
+    ASSERT_EQ(merged_list.size(), expected_list.size());
+    EXPECT_EQ(merged_list.max_tf(), expected_list.max_tf());
+    EXPECT_EQ(merged_list.min_doc_length(), expected_list.min_doc_length());
+
+    auto jtr = merged_list.begin();
+    for (const auto& posting : expected_list) {
+      ASSERT_NE(jtr, merged_list.end());
+      EXPECT_EQ(jtr->doc_id, posting.doc_id);
+      EXPECT_EQ(jtr->tf, posting.tf);
+      ++jtr;
+    }
+  }
+
+  auto itr = merged.GetPostings("all").begin();
+  itr.SkipTo(18);
+  ASSERT_EQ(itr->doc_id, 18);
+  std::vector<uint32_t> coords;
+  for (auto jtr = itr.GetCoordItr(); !jtr.IsEnd(); ++jtr) {
+    coords.push_back(*jtr);
+  }
+  // "all", "div2", "div3", "div6", "all"
+  const std::vector<uint32_t> expected_coords{0, 4};
+  EXPECT_EQ(coords, expected_coords);
+}
+
+TEST(InvertedIndexTest, MergeDropsDeletedDocuments) {
+  std::vector<InvertedIndex> parts(2);
+  for (DocID doc_id = 0; doc_id < 20; ++doc_id) {
+    parts[doc_id % 2].AddDocument(doc_id, MakeDocument(doc_id));
+  }
+  EXPECT_TRUE(parts[0].Delete(4));
+  EXPECT_FALSE(parts[0].Delete(5));
+  EXPECT_TRUE(parts[1].Delete(7));
+  EXPECT_TRUE(parts[1].IsDeleted(7));
+  EXPECT_EQ(parts[1].GetDeletedCount(), 1);
+
+  const auto merged = InvertedIndex::Merge(std::move(parts));
+  EXPECT_EQ(merged.GetDeletedCount(), 0);
+  EXPECT_EQ(merged.GetDocLength(4), 0);
+  EXPECT_EQ(merged.GetDocLength(6), 5);
+  EXPECT_EQ(merged.GetPostings("all").size(), 18);
+  // Only document 7 had the term
+  EXPECT_EQ(merged.GetPostings("div7").size(), 0);
+}
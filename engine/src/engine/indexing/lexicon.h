@@ -0,0 +1,24 @@
+#pragma once
+
+#include <optional>
+#include <string_view>
+
+#include "engine/indexing/compressed_posting_list.h"
+
+namespace indexing {
+
+// Terms of an index loaded from file, looked up where they are stored
+// instead of being copied into a hash table at load. Terms are numbered in
+// sorted order.
+class Lexicon {
+ public:
+  virtual ~Lexicon() = default;
+
+  virtual size_t size() const = 0;
+  virtual std::string_view GetTerm(size_t idx) const = 0;
+  virtual std::optional<size_t> Find(std::string_view term) const = 0;
+  // The list lives as long as the lexicon. Safe to call concurrently.
+  virtual const CompressedPostingList& GetPostings(size_t idx) const = 0;
+};
+
+}  // namespace indexing
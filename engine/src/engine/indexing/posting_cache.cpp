@@ -0,0 +1,89 @@
+#include "engine/indexing/posting_cache.h"
+
+#include "engine/indexing/inverted_index.h"
+#include "utils/hash_table.h"
+
+namespace {
+
+// Access counts are forgotten past this many tracked lists
+constexpr size_t kMaxTrackedLists = 1 << 16;
+
+}  // namespace
+
+namespace indexing {
+
+DecodedPostings DecodedPostings::Decode(const CompressedPostingList& list) {
+  DecodedPostings result;
+  result.docs.reserve(list.size());
+  result.tfs.reserve(list.size());
+  for (auto itr = list.begin(); !itr.IsEnd(); ++itr) {
+    result.docs.push_back(itr.doc_id());
+    result.tfs.push_back(itr->tf);
+  }
+  return result;
+}
+
+size_t DecodedPostings::MemoryUsage() const {
+  return docs.capacity() * sizeof(DocID) + tfs.capacity() * sizeof(uint32_t);
+}
+
+size_t PostingCache::KeyHasher::operator()(const Key& key) const {
+  return utils::StringHasher()(key.term) ^ utils::Mix64(key.index_id);
+}
+
+PostingCache::PostingCache(const PostingCacheOptions& options /* = {} */)
+    : options_(options), cache_(options.byte_budget) {}
+
+std::shared_ptr<const DecodedPostings> PostingCache::Get(
+    const InvertedIndex& index, const std::string& term) {
+  const auto& list = index.GetPostings(term);
+  if (options_.byte_budget == 0 || list.size() < options_.min_list_size) {
+    return nullptr;
+  }
+
+  Key key{index.id(), term};
+  if (auto cached = cache_.Get(key)) {
+    return cached;
+  }
+  const auto generation = cache_.generation();
+  {
+    std::lock_guard lock(mutex_);
+    if (access_counts_.size() >= kMaxTrackedLists) {
+      access_counts_.clear();
+    }
+    if (++access_counts_[key] < options_.admit_after) {
+      return nullptr;
+    }
+    access_counts_.erase(key);
+  }
+
+  // Decoded without the lock, a list decoded by two queries at once
+  // replaces itself
+  auto decoded = std::make_shared<const DecodedPostings>(
+      DecodedPostings::Decode(list));
+  if (cache_.Put(key, decoded, generation, decoded->MemoryUsage())) {
+    std::lock_guard lock(mutex_);
+    ++admissions_;
+  }
+  return decoded;
+}
+
+void PostingCache::Clear() {
+  cache_.Clear();
+  std::lock_guard lock(mutex_);
+  access_counts_.clear();
+}
+
+PostingCache::Stats PostingCache::stats() const {
+  const auto cache_stats = cache_.stats();
+  Stats stats;
+  stats.hits = cache_stats.hits;
+  stats.misses = cache_stats.misses;
+  stats.evictions = cache_stats.evictions;
+  stats.bytes = cache_stats.cost;
+  std::lock_guard lock(mutex_);
+  stats.admissions = admissions_;
+  return stats;
+}
+
+}  // namespace indexing
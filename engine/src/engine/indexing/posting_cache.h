@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "engine/indexing/compressed_posting_list.h"
+#include "utils/lru_cache.h"
+
+namespace indexing {
+
+class InvertedIndex;
+
+// Documents and tfs of a posting list decoded into plain arrays
+struct DecodedPostings {
+  static DecodedPostings Decode(const CompressedPostingList& list);
+
+  size_t MemoryUsage() const;
+
+  std::vector<DocID> docs;
+  std::vector<uint32_t> tfs;
+};
+
+struct PostingCacheOptions {
+  // Bytes of decoded postings kept, the least recently used lists are
+  // evicted past it
+  size_t byte_budget = 64 << 20;
+  // A list is decoded on its `admit_after`-th access
+  uint32_t admit_after = 2;
+  // Shorter lists are cheap to decode and aren't cached
+  size_t min_list_size = 1024;
+};
+
+// Memory-bounded cache of decoded posting lists of hot terms, shared by
+// concurrent queries. A list is admitted to the LRU cache once accessed
+// often enough. Lists are identified by the id of their index, so lists of
+// replaced indexes are never returned and age out.
+class PostingCache {
+ public:
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t admissions = 0;
+    uint64_t evictions = 0;
+    size_t bytes = 0;
+  };
+
+  explicit PostingCache(const PostingCacheOptions& options = {});
+
+  PostingCache(const PostingCache&) = delete;
+  PostingCache& operator=(const PostingCache&) = delete;
+
+  // Decoded postings of the term in the index, null while the list isn't
+  // cached. Counts the access and decodes the list once it is hot.
+  std::shared_ptr<const DecodedPostings> Get(const InvertedIndex& index,
+                                             const std::string& term);
+
+  void Clear();
+  Stats stats() const;
+
+ private:
+  struct Key {
+    uint64_t index_id;
+    std::string term;
+
+    bool operator==(const Key& other) const = default;
+  };
+  struct KeyHasher {
+    size_t operator()(const Key& key) const;
+  };
+
+  const PostingCacheOptions options_;
+  // Costs are the bytes of the decoded lists
+  utils::LruCache<Key, DecodedPostings, KeyHasher> cache_;
+
+  mutable std::mutex mutex_;
+  // Accesses to lists that aren't cached yet
+  std::unordered_map<Key, uint32_t, KeyHasher> access_counts_;
+  uint64_t admissions_ = 0;
+};
+
+}  // namespace indexing
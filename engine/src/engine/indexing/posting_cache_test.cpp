@@ -0,0 +1,122 @@
+#include "engine/indexing/posting_cache.h"
+
+#include <gtest/gtest.h>
+
+#include "engine/indexing/inverted_index.h"
+
+using namespace indexing;
+
+namespace {
+
+// "all" is in every document, "even" in every second one, "rare" in few
+InvertedIndex MakeIndex(DocID docs_count, CodecType codec) {
+  InvertedIndex index;
+  for (DocID doc_id = 0; doc_id < docs_count; ++doc_id) {
+    std::vector<std::string> terms{"all"};
+    for (DocID i = 0; i < doc_id % 3; ++i) {
+      terms.push_back("all");
+    }
+    if (doc_id % 2 == 0) {
+      terms.push_back("even");
+    }
+    if (doc_id % 500 == 0) {
+      terms.push_back("rare");
+    }
+    index.AddDocument(doc_id, terms);
+  }
+  index.BuildSkips({}, codec);
+  return index;
+}
+
+}  // namespace
+
+TEST(PostingCacheTest, AdmitsHotLongLists) {
+  const auto index = MakeIndex(5000, CodecType::kVByte);
+  PostingCache cache({.admit_after = 2, .min_list_size = 100});
+
+  EXPECT_EQ(cache.Get(index, "all"), nullptr);
+  const auto decoded = cache.Get(index, "all");
+  ASSERT_NE(decoded, nullptr);
+  EXPECT_EQ(decoded->docs.size(), 5000);
+  EXPECT_EQ(cache.Get(index, "all"), decoded);
+
+  // Too short to be cached
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(cache.Get(index, "rare"), nullptr);
+  }
+
+  const auto stats = cache.stats();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 2);
+  EXPECT_EQ(stats.admissions, 1);
+  EXPECT_EQ(stats.bytes, decoded->MemoryUsage());
+}
+
+TEST(PostingCacheTest, EvictsPastBudget) {
+  const auto index = MakeIndex(5000, CodecType::kVByte);
+  const size_t all_bytes =
+      DecodedPostings::Decode(index.GetPostings("all")).MemoryUsage();
+  PostingCache cache(
+      {.byte_budget = all_bytes + 100, .admit_after = 1, .min_list_size = 100});
+
+  ASSERT_NE(cache.Get(index, "all"), nullptr);
+  // Kept by the query while evicted from the cache
+  const auto even = cache.Get(index, "even");
+  ASSERT_NE(even, nullptr);
+  EXPECT_EQ(even->docs.size(), 2500);
+
+  const auto stats = cache.stats();
+  EXPECT_EQ(stats.evictions, 1);
+  EXPECT_EQ(stats.bytes, even->MemoryUsage());
+}
+
+TEST(PostingCacheTest, ChangedIndexMisses) {
+  // Without skips, so documents can be added
+  InvertedIndex index;
+  for (DocID doc_id = 0; doc_id < 2000; ++doc_id) {
+    index.AddDocument(doc_id, {"all"});
+  }
+  PostingCache cache({.admit_after = 1, .min_list_size = 100});
+  ASSERT_EQ(cache.Get(index, "all")->docs.size(), 2000);
+
+  index.AddDocument(2000, {"all"});
+  EXPECT_EQ(cache.Get(index, "all")->docs.size(), 2001);
+  EXPECT_EQ(cache.stats().hits, 0);
+}
+
+TEST(PostingCacheTest, DecodedIteratorMatchesList) {
+  for (const auto codec : {CodecType::kVByte, CodecType::kBitPacking}) {
+    const auto index = MakeIndex(5000, codec);
+    PostingCache cache({.admit_after = 1, .min_list_size = 100});
+    for (const std::string term : {"all", "even"}) {
+      const auto& list = index.GetPostings(term);
+      const auto decoded = cache.Get(index, term);
+      ASSERT_NE(decoded, nullptr);
+      CompressedPostingList::DocIterator itr(&list, decoded.get());
+
+      auto expected = list.begin();
+      for (DocID target = 0; target < 5200; target += 37) {
+        itr.SkipTo(target);
+        expected.SkipTo(target);
+        ASSERT_EQ(itr.IsEnd(), expected.IsEnd());
+        if (itr.IsEnd()) {
+          break;
+        }
+        EXPECT_EQ(itr.doc_id(), expected.doc_id());
+        EXPECT_EQ(itr->tf, expected->tf);
+        EXPECT_EQ(itr.GetBlockMax(target).last_doc_id,
+                  expected.GetBlockMax(target).last_doc_id);
+        ++itr;
+        ++expected;
+        ASSERT_EQ(itr.IsEnd(), expected.IsEnd());
+        if (!itr.IsEnd()) {
+          EXPECT_EQ(itr.doc_id(), expected.doc_id());
+          EXPECT_EQ(itr->tf, expected->tf);
+        }
+      }
+      EXPECT_THROW(CompressedPostingList::DocIterator(&list, decoded.get())
+                       .GetCoordItr(),
+                   std::logic_error);
+    }
+  }
+}
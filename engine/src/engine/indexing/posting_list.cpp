@@ -2,6 +2,8 @@
 
 #include <algorithm>
 
+#include "engine/indexing/intersection.h"
+
 namespace indexing {
 
 PostingList::PostingList() = default;
@@ -25,15 +27,20 @@ PostingList::PostingList(std::vector<Posting>&& list)
 PostingList PostingList::Intersect(const PostingList& other) const {
   PostingList result;
 
-  for (size_t i = 0, j = 0; i < list_.size() && j < other.list_.size();) {
-    if (list_[i].doc_id == other.list_[j].doc_id) {
-      result.list_.push_back({list_[i].doc_id, 0});
-      ++i;
-      ++j;
-    } else if (list_[i].doc_id < other.list_[j].doc_id) {
-      ++i;
-    } else {
-      ++j;
+  // The shorter list drives, the longer one is galloped through
+  const bool is_shorter = list_.size() <= other.list_.size();
+  const auto& shorter = is_shorter ? list_ : other.list_;
+  const auto& longer = is_shorter ? other.list_ : list_;
+  auto itr = longer.begin();
+  for (const auto& posting : shorter) {
+    itr = GallopPartitionPoint(itr, longer.end(), [&](const Posting& candidate) {
+      return candidate.doc_id < posting.doc_id;
+    });
+    if (itr == longer.end()) {
+      break;
+    }
+    if (itr->doc_id == posting.doc_id) {
+      result.list_.push_back({posting.doc_id, 0});
     }
   }
   return result;
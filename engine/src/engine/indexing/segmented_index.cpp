@@ -0,0 +1,377 @@
+#include "engine/indexing/segmented_index.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <stdexcept>
+
+#include "storage/file_index_storage.h"
+
+namespace {
+
+constexpr std::string_view kSegmentPrefix = "segment-";
+constexpr std::string_view kSegmentExtension = ".bin";
+
+// Generation of a segment file name, nullopt for other files
+std::optional<size_t> ParseGeneration(const std::filesystem::path& path) {
+  const auto name = path.filename().string();
+  if (!name.starts_with(kSegmentPrefix) ||
+      !name.ends_with(kSegmentExtension) ||
+      name.size() == kSegmentPrefix.size() + kSegmentExtension.size()) {
+    return std::nullopt;
+  }
+  const auto number = name.substr(
+      kSegmentPrefix.size(),
+      name.size() - kSegmentPrefix.size() - kSegmentExtension.size());
+  if (!std::all_of(number.begin(), number.end(), ::isdigit)) {
+    return std::nullopt;
+  }
+  return std::stoul(number);
+}
+
+std::filesystem::path TempPath(const std::filesystem::path& path) {
+  auto tmp = path;
+  tmp += ".tmp";
+  return tmp;
+}
+
+// Carries the deletions made while `sources` were rewritten into `target`.
+// Every document of `target` comes from the only source holding it alive
+// at the start, so it's deleted once no source holds it alive.
+bool CarryDeletions(const std::vector<const indexing::InvertedIndex*>& sources,
+                    indexing::InvertedIndex& target) {
+  bool changed = false;
+  for (indexing::DocID doc_id = target.GetFirstDocID();
+       doc_id < target.GetDocsCount(); ++doc_id) {
+    if (target.GetDocLength(doc_id) == 0) {
+      continue;
+    }
+    const bool live = std::any_of(
+        sources.begin(), sources.end(),
+        [doc_id](const indexing::InvertedIndex* source) {
+          return doc_id < source->GetDocsCount() &&
+                 source->GetDocLength(doc_id) != 0 &&
+                 !source->IsDeleted(doc_id);
+        });
+    if (!live) {
+      changed |= target.Delete(doc_id);
+    }
+  }
+  return changed;
+}
+
+}  // namespace
+
+namespace indexing {
+
+SegmentedIndex::SegmentedIndex(
+    const std::filesystem::path& dir,
+    const SegmentedIndexOptions& options /* = {} */)
+    : dir_(dir), options_(options), retry_delay_(options.merge_retry_delay) {
+  if (options_.merge_factor < 2) {
+    throw std::runtime_error("SegmentedIndex: merge factor must be >= 2");
+  }
+  std::filesystem::create_directories(dir_);
+  snapshot_ = std::make_shared<const std::vector<Segment>>();
+  merger_ = std::thread(&SegmentedIndex::MergeLoop, this);
+}
+
+SegmentedIndex::~SegmentedIndex() {
+  {
+    std::lock_guard lock(segments_mutex_);
+    stop_ = true;
+  }
+  merge_cv_.notify_all();
+  merger_.join();
+}
+
+void SegmentedIndex::Open() {
+  std::map<size_t, std::filesystem::path> paths;
+  for (const auto& entry : std::filesystem::directory_iterator(dir_)) {
+    if (entry.path().extension() == ".tmp") {
+      // Left by an interrupted flush or merge
+      std::filesystem::remove(entry.path());
+    } else if (const auto generation = ParseGeneration(entry.path())) {
+      paths[*generation] = entry.path();
+    }
+  }
+
+  std::vector<SegmentFile> segments;
+  for (const auto& [_, path] : paths) {
+    segments.push_back(OpenSegment(path));
+  }
+
+  std::unique_lock lock(segments_mutex_);
+  merge_cv_.wait(lock, [this] { return !merging_; });
+  segments_ = std::move(segments);
+  next_generation_ = paths.empty() ? 0 : paths.rbegin()->first + 1;
+  Publish();
+  merge_cv_.notify_all();
+}
+
+void SegmentedIndex::Clear() {
+  {
+    std::lock_guard lock(buffer_mutex_);
+    buffer_ = InvertedIndex();
+    buffered_docs_ = 0;
+  }
+
+  std::unique_lock lock(segments_mutex_);
+  merge_cv_.wait(lock, [this] { return !merging_; });
+  for (const auto& segment : segments_) {
+    storage::FileIndexStorage(segment.path).Remove();
+  }
+  segments_.clear();
+  Publish();
+}
+
+void SegmentedIndex::AddDocument(DocID doc_id,
+                                 const std::vector<std::string>& terms) {
+  bool flush = false;
+  {
+    std::unique_lock lock(buffer_mutex_);
+    // Lists only grow at the end, so a replaced document starts a new
+    // buffer
+    while (doc_id < buffer_.GetDocsCount()) {
+      lock.unlock();
+      Flush();
+      lock.lock();
+    }
+    buffer_.AddDocument(doc_id, terms);
+    flush = ++buffered_docs_ >= options_.max_buffered_docs;
+  }
+  if (flush) {
+    Flush();
+  }
+}
+
+bool SegmentedIndex::Delete(DocID doc_id) {
+  bool deleted = false;
+  {
+    std::lock_guard lock(buffer_mutex_);
+    deleted = buffer_.Delete(doc_id);
+  }
+
+  std::lock_guard lock(segments_mutex_);
+  for (const auto& index : flushing_) {
+    deleted |= index->Delete(doc_id);
+  }
+  for (auto& segment : segments_) {
+    if (segment.index->Delete(doc_id)) {
+      segment.dirty = true;
+      deleted = true;
+    }
+  }
+  return deleted;
+}
+
+void SegmentedIndex::Flush() {
+  auto index = std::make_shared<InvertedIndex>();
+  std::filesystem::path path;
+  {
+    std::lock_guard buffer_lock(buffer_mutex_);
+    std::lock_guard lock(segments_mutex_);
+    RetryMerges();
+    if (buffered_docs_ == 0) {
+      SaveDeletions();
+      return;
+    }
+    std::swap(*index, buffer_);
+    buffered_docs_ = 0;
+    flushing_.push_back(index);
+    path = NextSegmentPath();
+  }
+
+  // Searchable since publishing, documents added meanwhile go to the new
+  // buffer
+  index->BuildSkips({}, options_.codec);
+  std::optional<SegmentFile> segment;
+  try {
+    segment = SaveSegment(*index, path);
+  } catch (...) {
+    std::lock_guard lock(segments_mutex_);
+    std::erase(flushing_, index);
+    throw;
+  }
+
+  std::lock_guard lock(segments_mutex_);
+  std::erase(flushing_, index);
+  segment->dirty = CarryDeletions({index.get()}, *segment->index);
+  segments_.push_back(std::move(*segment));
+  Publish();
+  SaveDeletions();
+  merge_cv_.notify_all();
+}
+
+SegmentedIndex::Snapshot SegmentedIndex::GetSnapshot() const {
+  std::lock_guard lock(segments_mutex_);
+  return snapshot_;
+}
+
+size_t SegmentedIndex::GetDocsCount() const {
+  size_t docs_count = 0;
+  for (const auto& segment : *GetSnapshot()) {
+    docs_count = std::max(docs_count, segment->GetDocsCount());
+  }
+  std::lock_guard lock(buffer_mutex_);
+  return std::max(docs_count, buffer_.GetDocsCount());
+}
+
+void SegmentedIndex::WaitForMerges() {
+  std::unique_lock lock(segments_mutex_);
+  merge_cv_.wait(lock, [this] {
+    return stop_ || (!merging_ && (merge_failed_ || PickMerge().empty()));
+  });
+}
+
+SegmentedIndex::SegmentFile SegmentedIndex::SaveSegment(
+    const InvertedIndex& index, const std::filesystem::path& path) const {
+  const auto tmp = TempPath(path);
+  storage::FileIndexStorage(tmp).SaveIndex(index);
+  std::filesystem::rename(tmp, path);
+  return OpenSegment(path);
+}
+
+SegmentedIndex::SegmentFile SegmentedIndex::OpenSegment(
+    const std::filesystem::path& path) const {
+  auto index = std::make_shared<InvertedIndex>(
+      storage::FileIndexStorage(path).LoadIndex());
+  return {std::move(index), path, std::filesystem::file_size(path)};
+}
+
+std::filesystem::path SegmentedIndex::NextSegmentPath() {
+  return dir_ / (std::string(kSegmentPrefix) +
+                 std::to_string(next_generation_++) +
+                 std::string(kSegmentExtension));
+}
+
+void SegmentedIndex::Publish() {
+  auto snapshot = std::make_shared<std::vector<Segment>>();
+  snapshot->reserve(segments_.size());
+  for (const auto& segment : segments_) {
+    snapshot->push_back(segment.index);
+  }
+  snapshot_ = std::move(snapshot);
+}
+
+void SegmentedIndex::SaveDeletions() {
+  for (auto& segment : segments_) {
+    if (segment.dirty) {
+      storage::FileIndexStorage(segment.path).SaveDeletions(*segment.index);
+      segment.dirty = false;
+    }
+  }
+}
+
+std::vector<SegmentedIndex::SegmentFile> SegmentedIndex::PickMerge() const {
+  std::map<size_t, std::vector<SegmentFile>> tiers;
+  for (const auto& segment : segments_) {
+    auto& tier = tiers[GetTier(segment.size)];
+    tier.push_back(segment);
+    if (tier.size() == options_.merge_factor) {
+      return tier;
+    }
+  }
+  return {};
+}
+
+size_t SegmentedIndex::GetTier(uintmax_t size) const {
+  size_t tier = 0;
+  for (auto units = size / options_.min_tier_size;
+       units >= options_.merge_factor; units /= options_.merge_factor) {
+    ++tier;
+  }
+  return tier;
+}
+
+void SegmentedIndex::RetryMerges() {
+  if (merge_failed_) {
+    merge_failed_ = false;
+    retry_at_ = {};
+    merge_cv_.notify_all();
+  }
+}
+
+void SegmentedIndex::MergeLoop() {
+  static constexpr std::chrono::milliseconds kMaxRetryDelay =
+      std::chrono::minutes(1);
+
+  std::unique_lock lock(segments_mutex_);
+  while (true) {
+    merge_cv_.wait(lock, [this] { return stop_ || !PickMerge().empty(); });
+    if (stop_) {
+      return;
+    }
+    if (merge_failed_ && std::chrono::steady_clock::now() < retry_at_) {
+      // Woken early by the deadline, a Flush or the shutdown
+      merge_cv_.wait_until(lock, retry_at_, [this] {
+        return stop_ || !merge_failed_;
+      });
+      continue;
+    }
+
+    const auto sources = PickMerge();
+    const auto path = NextSegmentPath();
+    merging_ = true;
+    lock.unlock();
+
+    // Queries keep using the source segments until the merged one is
+    // published. Deletions saved with the sources are purged, the ones
+    // made meanwhile are carried over.
+    std::optional<SegmentFile> merged;
+    try {
+      std::vector<std::filesystem::path> runs;
+      for (const auto& segment : sources) {
+        runs.push_back(segment.path);
+      }
+      const auto tmp = TempPath(path);
+      storage::FileIndexStorage(tmp).MergeRuns(runs, options_.codec);
+      std::filesystem::rename(tmp, path);
+      merged = OpenSegment(path);
+    } catch (const std::exception& e) {
+      std::cerr << "SegmentedIndex: merge failed: " << e.what() << std::endl;
+      std::filesystem::remove(TempPath(path));
+    }
+
+    lock.lock();
+    merging_ = false;
+    if (!merged) {
+      // The sources stay, e.g. a full disk or too many open files may pass
+      merge_failed_ = true;
+      retry_at_ = std::chrono::steady_clock::now() + retry_delay_;
+      retry_delay_ = std::min(retry_delay_ * 2, kMaxRetryDelay);
+      merge_cv_.notify_all();
+      continue;
+    }
+    merge_failed_ = false;
+    retry_delay_ = options_.merge_retry_delay;
+
+    std::erase_if(segments_, [&sources](const SegmentFile& segment) {
+      return std::any_of(sources.begin(), sources.end(),
+                         [&segment](const SegmentFile& source) {
+                           return source.path == segment.path;
+                         });
+    });
+    std::vector<const InvertedIndex*> source_indexes;
+    for (const auto& segment : sources) {
+      source_indexes.push_back(segment.index.get());
+    }
+    merged->dirty = CarryDeletions(source_indexes, *merged->index);
+    segments_.push_back(std::move(*merged));
+    Publish();
+    for (const auto& segment : sources) {
+      storage::FileIndexStorage(segment.path).Remove();
+    }
+    try {
+      SaveDeletions();
+    } catch (const std::exception& e) {
+      std::cerr << "SegmentedIndex: can't save deletions: " << e.what()
+                << std::endl;
+    }
+    merge_cv_.notify_all();
+  }
+}
+
+}  // namespace indexing
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "engine/indexing/inverted_index.h"
+
+namespace indexing {
+
+struct SegmentedIndexOptions {
+  // Buffered documents are flushed to a new segment past this count
+  size_t max_buffered_docs = 10000;
+  // Segments of one size tier are merged once there are this many of them
+  size_t merge_factor = 8;
+  // Segments below this size share the lowest tier
+  uintmax_t min_tier_size = 1 << 20;
+  // Encoding of the saved segments
+  CodecType codec = CodecType::kVByte;
+  // A failed merge is retried after this delay, doubled with every failure
+  // in a row up to a minute, or on the next Flush
+  std::chrono::milliseconds merge_retry_delay = std::chrono::seconds(1);
+};
+
+// Index made of immutable segments saved in a directory. New documents are
+// buffered in memory and become searchable when the buffer is flushed into
+// a new segment. A background thread merges segments of similar size, so
+// their count stays logarithmic in the number of documents. Deletions only
+// mark the documents in the segments, merges drop them for good.
+class SegmentedIndex {
+ public:
+  using Segment = std::shared_ptr<const InvertedIndex>;
+  // Segments visible to a query, unaffected by later flushes and merges
+  using Snapshot = std::shared_ptr<const std::vector<Segment>>;
+
+  explicit SegmentedIndex(const std::filesystem::path& dir,
+                          const SegmentedIndexOptions& options = {});
+  ~SegmentedIndex();
+
+  SegmentedIndex(const SegmentedIndex&) = delete;
+  SegmentedIndex& operator=(const SegmentedIndex&) = delete;
+
+  // Loads the segments saved in the directory
+  void Open();
+  // Drops all segments and buffered documents
+  void Clear();
+
+  // Re-adding a deleted document replaces it, an update is a Delete
+  // followed by AddDocument
+  void AddDocument(DocID doc_id, const std::vector<std::string>& terms);
+  // Returns false if no segment holds the document
+  bool Delete(DocID doc_id);
+  // Makes buffered documents searchable and saves the deletions
+  void Flush();
+
+  Snapshot GetSnapshot() const;
+  // One past the largest document id added so far
+  size_t GetDocsCount() const;
+
+  // Blocks until no merge is pending or the last one failed
+  void WaitForMerges();
+
+ private:
+  struct SegmentFile {
+    std::shared_ptr<InvertedIndex> index;
+    std::filesystem::path path;
+    uintmax_t size;
+    // Deleted from since the deletions were saved
+    bool dirty = false;
+  };
+
+  SegmentFile SaveSegment(const InvertedIndex& index,
+                          const std::filesystem::path& path) const;
+  SegmentFile OpenSegment(const std::filesystem::path& path) const;
+
+  // Called with segments_mutex_ held
+  std::filesystem::path NextSegmentPath();
+  void Publish();
+  void SaveDeletions();
+  // Lets a failed merge retry without waiting for the delay
+  void RetryMerges();
+  std::vector<SegmentFile> PickMerge() const;
+  size_t GetTier(uintmax_t size) const;
+
+  void MergeLoop();
+
+  const std::filesystem::path dir_;
+  const SegmentedIndexOptions options_;
+
+  mutable std::mutex buffer_mutex_;
+  InvertedIndex buffer_;
+  size_t buffered_docs_ = 0;
+
+  mutable std::mutex segments_mutex_;
+  std::vector<SegmentFile> segments_;
+  // Buffers being saved, they take deletions until published
+  std::vector<std::shared_ptr<InvertedIndex>> flushing_;
+  Snapshot snapshot_;
+  size_t next_generation_ = 0;
+
+  // Signals flushes to the merger and finished merges to the waiters
+  std::condition_variable merge_cv_;
+  bool merging_ = false;
+  // The last merge failed, the next one waits until retry_at_
+  bool merge_failed_ = false;
+  std::chrono::steady_clock::time_point retry_at_;
+  std::chrono::milliseconds retry_delay_;
+  bool stop_ = false;
+  std::thread merger_;
+};
+
+}  // namespace indexing
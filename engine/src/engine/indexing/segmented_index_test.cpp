@@ -0,0 +1,172 @@
+#include "engine/indexing/segmented_index.h"
+
+#include <gtest/gtest.h>
+
+using indexing::DocID;
+using indexing::SegmentedIndex;
+
+class SegmentedIndexTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir = std::filesystem::temp_directory_path() / "segmented_index_test";
+    std::filesystem::remove_all(dir);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(dir); }
+
+  static size_t CountPostings(const SegmentedIndex::Snapshot& snapshot,
+                              const std::string& term) {
+    size_t count = 0;
+    for (const auto& segment : *snapshot) {
+      count += segment->GetPostings(term).size();
+    }
+    return count;
+  }
+
+  // Postings of the documents left alive
+  static size_t CountLive(const SegmentedIndex::Snapshot& snapshot,
+                          const std::string& term) {
+    size_t count = 0;
+    for (const auto& segment : *snapshot) {
+      for (const auto& posting : segment->GetPostings(term)) {
+        count += segment->IsDeleted(posting.doc_id) ? 0 : 1;
+      }
+    }
+    return count;
+  }
+
+  std::filesystem::path dir;
+};
+
+TEST_F(SegmentedIndexTest, FlushMakesDocumentsSearchable) {
+  SegmentedIndex index(dir, {.max_buffered_docs = 100});
+  index.AddDocument(0, {"hello", "world"});
+  index.AddDocument(1, {"hello"});
+  EXPECT_TRUE(index.GetSnapshot()->empty());
+  EXPECT_EQ(index.GetDocsCount(), 2);
+
+  const auto before = index.GetSnapshot();
+  index.Flush();
+  EXPECT_TRUE(before->empty());
+
+  const auto snapshot = index.GetSnapshot();
+  ASSERT_EQ(snapshot->size(), 1);
+  EXPECT_EQ(CountPostings(snapshot, "hello"), 2);
+  EXPECT_EQ(CountPostings(snapshot, "world"), 1);
+}
+
+TEST_F(SegmentedIndexTest, TieredMerge) {
+  {
+    SegmentedIndex index(dir, {.max_buffered_docs = 10, .merge_factor = 4});
+    for (DocID doc_id = 0; doc_id < 100; ++doc_id) {
+      index.AddDocument(doc_id, {"all", "term" + std::to_string(doc_id % 3)});
+    }
+    index.Flush();
+    index.WaitForMerges();
+
+    // All segments are below the smallest tier size and share one tier
+    const auto snapshot = index.GetSnapshot();
+    EXPECT_LT(snapshot->size(), 4);
+    EXPECT_EQ(CountPostings(snapshot, "all"), 100);
+    EXPECT_EQ(CountPostings(snapshot, "term1"), 33);
+  }
+
+  SegmentedIndex reopened(dir, {.max_buffered_docs = 10, .merge_factor = 4});
+  reopened.Open();
+  const auto snapshot = reopened.GetSnapshot();
+  EXPECT_EQ(CountPostings(snapshot, "all"), 100);
+  EXPECT_EQ(reopened.GetDocsCount(), 100);
+
+  reopened.AddDocument(100, {"all"});
+  reopened.Flush();
+  EXPECT_EQ(CountPostings(reopened.GetSnapshot(), "all"), 101);
+
+  reopened.Clear();
+  EXPECT_TRUE(reopened.GetSnapshot()->empty());
+  EXPECT_TRUE(std::filesystem::is_empty(dir));
+}
+
+TEST_F(SegmentedIndexTest, DeleteAndUpdate) {
+  {
+    SegmentedIndex index(dir, {.max_buffered_docs = 100, .merge_factor = 2});
+    for (DocID doc_id = 0; doc_id < 10; ++doc_id) {
+      index.AddDocument(doc_id, {"all", "old"});
+    }
+    // Replaced while still buffered
+    EXPECT_TRUE(index.Delete(9));
+    index.AddDocument(9, {"all", "new"});
+    index.Flush();
+    EXPECT_EQ(CountLive(index.GetSnapshot(), "old"), 9);
+
+    EXPECT_TRUE(index.Delete(3));
+    EXPECT_FALSE(index.Delete(3));
+    EXPECT_FALSE(index.Delete(42));
+    index.AddDocument(3, {"all", "new"});
+    EXPECT_EQ(CountLive(index.GetSnapshot(), "old"), 8);
+    index.Flush();
+    index.WaitForMerges();
+
+    // The merges purged the replaced versions
+    auto snapshot = index.GetSnapshot();
+    ASSERT_EQ(snapshot->size(), 1);
+    EXPECT_EQ(CountPostings(snapshot, "all"), 10);
+    EXPECT_EQ(CountLive(snapshot, "new"), 2);
+
+    EXPECT_TRUE(index.Delete(5));
+    index.Flush();
+    EXPECT_EQ(CountLive(index.GetSnapshot(), "all"), 9);
+  }
+
+  SegmentedIndex reopened(dir, {.max_buffered_docs = 100, .merge_factor = 2});
+  reopened.Open();
+  const auto snapshot = reopened.GetSnapshot();
+  EXPECT_EQ(CountLive(snapshot, "all"), 9);
+  EXPECT_EQ(CountLive(snapshot, "old"), 7);
+  EXPECT_EQ(CountPostings(snapshot, "all"), 10);
+}
+
+TEST_F(SegmentedIndexTest, FailedMergeIsRetried) {
+  SegmentedIndex index(dir, {.max_buffered_docs = 100, .merge_factor = 2});
+  index.AddDocument(0, {"all"});
+  index.Flush();
+
+  // The merge cannot read the first segment while it is moved away
+  const auto path = dir / "segment-0.bin";
+  const auto moved = dir / "moved";
+  std::filesystem::rename(path, moved);
+  index.AddDocument(1, {"all"});
+  index.Flush();
+  index.WaitForMerges();
+  EXPECT_EQ(index.GetSnapshot()->size(), 2);
+  EXPECT_EQ(CountPostings(index.GetSnapshot(), "all"), 2);
+
+  std::filesystem::rename(moved, path);
+  index.Flush();
+  index.WaitForMerges();
+  EXPECT_EQ(index.GetSnapshot()->size(), 1);
+  EXPECT_EQ(CountPostings(index.GetSnapshot(), "all"), 2);
+}
+
+TEST_F(SegmentedIndexTest, SegmentsSpanTheirOwnDocuments) {
+  {
+    SegmentedIndex index(dir, {.max_buffered_docs = 100});
+    for (DocID doc_id = 0; doc_id < 110; ++doc_id) {
+      index.AddDocument(doc_id, {"all"});
+    }
+    index.Flush();
+    EXPECT_TRUE(index.Delete(105));
+    index.Flush();
+
+    const auto snapshot = index.GetSnapshot();
+    ASSERT_EQ(snapshot->size(), 2);
+    EXPECT_EQ((*snapshot)[1]->GetFirstDocID(), 100);
+    EXPECT_EQ((*snapshot)[1]->GetDocsCount(), 110);
+  }
+
+  SegmentedIndex reopened(dir, {.max_buffered_docs = 100});
+  reopened.Open();
+  const auto snapshot = reopened.GetSnapshot();
+  EXPECT_EQ(CountLive(snapshot, "all"), 109);
+  EXPECT_TRUE(reopened.Delete(104));
+  EXPECT_FALSE(reopened.Delete(105));
+}
@@ -1,7 +1,25 @@
 #include "engine/query/ast.h"
 
+#include <charconv>
+#include <sstream>
+
 #include "linguistics/utils.h"
 
+namespace {
+
+std::optional<uint32_t> ParseNumber(std::string_view text) {
+  uint32_t value = 0;
+  const auto [end, error] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  if (text.empty() || error != std::errc() ||
+      end != text.data() + text.size()) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+}  // namespace
+
 namespace query {
 
 NodeType GetTermType(const std::string& term) {
@@ -12,12 +30,84 @@ NodeType GetTermType(const std::string& term) {
   } else if (lower_term == "or" || lower_term == "или" || lower_term == "|" ||
              lower_term == "||") {
     return NodeType::kOr;
-  } else if (lower_term.front() == '"' && lower_term.back() == '"') {
+  } else if (lower_term == "not" || lower_term == "не" || lower_term == "!" ||
+             lower_term == "-") {
+    return NodeType::kNot;
+  } else if (ParsePhraseToken(lower_term)) {
     return NodeType::kPhrase;
   }
   return NodeType::kTerm;
 }
 
+std::optional<PhraseToken> ParsePhraseToken(const std::string& token) {
+  const auto end = token.rfind('"');
+  if (token.size() < 2 || token.front() != '"' || end == 0) {
+    return std::nullopt;
+  }
+  if (end + 1 == token.size()) {
+    return PhraseToken{token.substr(1, end - 1), 0};
+  }
+  const auto slop =
+      token[end + 1] == '~'
+          ? ParseNumber(std::string_view(token).substr(end + 2))
+          : std::nullopt;
+  if (!slop) {
+    return std::nullopt;
+  }
+  return PhraseToken{token.substr(1, end - 1), *slop};
+}
+
+std::optional<uint32_t> ParseNearToken(const std::string& token) {
+  const auto lower_token = linguistics::ToLower(token);
+  for (const std::string prefix : {"near/", "рядом/"}) {
+    if (lower_token.starts_with(prefix)) {
+      return ParseNumber(std::string_view(lower_token).substr(prefix.size()));
+    }
+  }
+  return std::nullopt;
+}
+
+namespace {
+
+void Serialize(const ASTNode& node, std::ostringstream& oss) {
+  switch (node.type) {
+    case NodeType::kTerm:
+      oss << node.terms.front();
+      return;
+    case NodeType::kPhrase:
+      oss << (node.proximity.ordered ? "\"" : "NEAR(");
+      for (size_t i = 0; i < node.terms.size(); ++i) {
+        oss << (i > 0 ? " " : "") << node.terms[i];
+      }
+      oss << (node.proximity.ordered ? "\"~" : ")/") << node.proximity.slop;
+      return;
+    case NodeType::kAnd:
+    case NodeType::kOr:
+      oss << (node.type == NodeType::kAnd ? "AND(" : "OR(");
+      for (size_t i = 0; i < node.children.size(); ++i) {
+        oss << (i > 0 ? " " : "");
+        Serialize(*node.children[i], oss);
+      }
+      oss << ')';
+      return;
+    case NodeType::kNot:
+      oss << "NOT(";
+      Serialize(*node.children.front(), oss);
+      oss << ')';
+      return;
+    default:
+      oss << "EMPTY";
+  }
+}
+
+}  // namespace
+
+std::string Serialize(const ASTNode& node) {
+  std::ostringstream oss;
+  Serialize(node, oss);
+  return oss.str();
+}
+
 std::unique_ptr<ASTNode> ASTNode::MakeTerm(const std::string& term) {
   auto node = std::make_unique<ASTNode>();
   node->type = NodeType::kTerm;
@@ -26,10 +116,11 @@ std::unique_ptr<ASTNode> ASTNode::MakeTerm(const std::string& term) {
 }
 
 std::unique_ptr<ASTNode> ASTNode::MakePhrase(
-    const std::vector<std::string>& phrase) {
+    const std::vector<std::string>& phrase, Proximity proximity /* = {} */) {
   auto node = std::make_unique<ASTNode>();
   node->type = NodeType::kPhrase;
   node->terms = phrase;
+  node->proximity = proximity;
   return node;
 }
 
@@ -37,8 +128,8 @@ std::unique_ptr<ASTNode> ASTNode::MakeAnd(std::unique_ptr<ASTNode> left,
                                           std::unique_ptr<ASTNode> right) {
   auto node = std::make_unique<ASTNode>();
   node->type = NodeType::kAnd;
-  node->left = std::move(left);
-  node->right = std::move(right);
+  node->children.push_back(std::move(left));
+  node->children.push_back(std::move(right));
   return node;
 }
 
@@ -46,8 +137,21 @@ std::unique_ptr<ASTNode> ASTNode::MakeOr(std::unique_ptr<ASTNode> left,
                                          std::unique_ptr<ASTNode> right) {
   auto node = std::make_unique<ASTNode>();
   node->type = NodeType::kOr;
-  node->left = std::move(left);
-  node->right = std::move(right);
+  node->children.push_back(std::move(left));
+  node->children.push_back(std::move(right));
+  return node;
+}
+
+std::unique_ptr<ASTNode> ASTNode::MakeNot(std::unique_ptr<ASTNode> child) {
+  auto node = std::make_unique<ASTNode>();
+  node->type = NodeType::kNot;
+  node->children.push_back(std::move(child));
+  return node;
+}
+
+std::unique_ptr<ASTNode> ASTNode::MakeEmpty() {
+  auto node = std::make_unique<ASTNode>();
+  node->type = NodeType::kEmpty;
   return node;
 }
 
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -11,23 +13,50 @@ enum class NodeType {
   kPhrase,
   kAnd,
   kOr,
+  kNot,
+  kEmpty,
 };
 
 NodeType GetTermType(const std::string& term);
 
+// Positional constraint of a phrase: ordered phrases match their terms in
+// order, unordered ones (NEAR) in any order, in both cases with at most
+// `slop` other words between them.
+struct Proximity {
+  uint32_t slop = 0;
+  bool ordered = true;
+};
+
+// Text between the quotes of a `"..."` or `"..."~slop` token and its slop
+struct PhraseToken {
+  std::string text;
+  uint32_t slop;
+};
+std::optional<PhraseToken> ParsePhraseToken(const std::string& token);
+// Distance of a `NEAR/k` token
+std::optional<uint32_t> ParseNearToken(const std::string& token);
+
 struct ASTNode {
   static std::unique_ptr<ASTNode> MakeTerm(const std::string& term);
   static std::unique_ptr<ASTNode> MakePhrase(
-      const std::vector<std::string>& phrase);
+      const std::vector<std::string>& phrase, Proximity proximity = {});
   static std::unique_ptr<ASTNode> MakeAnd(std::unique_ptr<ASTNode> left,
                                           std::unique_ptr<ASTNode> right);
   static std::unique_ptr<ASTNode> MakeOr(std::unique_ptr<ASTNode> left,
                                          std::unique_ptr<ASTNode> right);
+  static std::unique_ptr<ASTNode> MakeNot(std::unique_ptr<ASTNode> child);
+  static std::unique_ptr<ASTNode> MakeEmpty();
 
   NodeType type;
   std::vector<std::string> terms;
-  std::unique_ptr<ASTNode> left;
-  std::unique_ptr<ASTNode> right;
+  std::vector<std::unique_ptr<ASTNode>> children;
+  // Of kPhrase nodes
+  Proximity proximity;
+  // Estimated number of matching documents, filled in by the planner
+  size_t cost = 0;
 };
 
+// One-line form of the tree, equal for queries that parse the same
+std::string Serialize(const ASTNode& node);
+
 }  // namespace query
@@ -1,15 +1,34 @@
 #include "engine/query/bool_query.h"
 
+#include <algorithm>
 #include <stack>
 #include <stdexcept>
 
 #include "engine/indexing/inverted_index.h"
-#include "engine/indexing/posting_list.h"
-#include "engine/query/phrase_query.h"
+#include "engine/query/planner.h"
+#include "engine/query/query_iterator.h"
 #include "linguistics/preprocessor.h"
 
 namespace {
 
+// Joins the operands of `left NEAR/distance right`, chains with the same
+// distance become one group
+std::unique_ptr<query::ASTNode> MakeNear(std::unique_ptr<query::ASTNode> left,
+                                         std::unique_ptr<query::ASTNode> right,
+                                         uint32_t distance) {
+  const bool left_is_group = left->type == query::NodeType::kPhrase &&
+                             !left->proximity.ordered &&
+                             left->proximity.slop == distance;
+  if ((left->type != query::NodeType::kTerm && !left_is_group) ||
+      right->type != query::NodeType::kTerm) {
+    throw std::runtime_error("BuildAST: NEAR operands must be words");
+  }
+  auto terms = std::move(left->terms);
+  terms.push_back(right->terms.front());
+  return query::ASTNode::MakePhrase(
+      terms, {.slop = distance, .ordered = false});
+}
+
 std::unique_ptr<query::ASTNode> BuildAST(
     std::vector<std::string>& tokens,
     const linguistics::Preprocessor& preprocessor) {
@@ -17,6 +36,15 @@ std::unique_ptr<query::ASTNode> BuildAST(
   std::stack<char> op_stack;
 
   auto apply_op = [&](char op) {
+    if (op == '!') {
+      if (node_stack.empty()) {
+        throw std::runtime_error("BuildAST: missing operand for negation");
+      }
+      auto child = std::move(node_stack.top());
+      node_stack.pop();
+      node_stack.push(query::ASTNode::MakeNot(std::move(child)));
+      return;
+    }
     if (node_stack.size() < 2) {
       throw std::runtime_error("BuildAST: insufficient operands for operator");
     }
@@ -33,8 +61,44 @@ std::unique_ptr<query::ASTNode> BuildAST(
     }
   };
 
+  auto push_and = [&]() {
+    while (!op_stack.empty() &&
+           (op_stack.top() == '&' || op_stack.top() == '!')) {
+      apply_op(op_stack.top());
+      op_stack.pop();
+    }
+    op_stack.push('&');
+  };
+
+  // Operands written next to each other are joined with an implicit AND
+  bool after_operand = false;
+  // NEAR binds tighter than any operator, to the words on both sides
+  bool after_near = false;
+  uint32_t near_distance = 0;
   for (auto& token : tokens) {
+    if (const auto distance = query::ParseNearToken(token)) {
+      if (!after_operand || node_stack.empty()) {
+        throw std::runtime_error("BuildAST: missing operand for NEAR");
+      }
+      after_near = true;
+      near_distance = *distance;
+      after_operand = false;
+      continue;
+    }
     const auto type = query::GetTermType(token);
+    if (after_near && (token == "(" || token == ")" ||
+                          type != query::NodeType::kTerm)) {
+      throw std::runtime_error("BuildAST: NEAR operands must be words");
+    }
+    const bool starts_operand =
+        token == "(" || (token != ")" && (type == query::NodeType::kTerm ||
+                                          type == query::NodeType::kPhrase ||
+                                          type == query::NodeType::kNot));
+    if (starts_operand && after_operand) {
+      push_and();
+    }
+    after_operand = false;
+
     if (token == "(") {
       op_stack.push('(');
     } else if (token == ")") {
@@ -46,18 +110,27 @@ std::unique_ptr<query::ASTNode> BuildAST(
         throw std::runtime_error("BuildAST: ')' without '('");
       }
       op_stack.pop();
+      after_operand = true;
     } else if (type == query::NodeType::kTerm) {
       token = preprocessor.Lemmatize(std::move(token));
-      node_stack.push(query::ASTNode::MakeTerm(token));
+      auto node = query::ASTNode::MakeTerm(token);
+      if (after_near) {
+        auto left = std::move(node_stack.top());
+        node_stack.pop();
+        node = MakeNear(std::move(left), std::move(node), near_distance);
+        after_near = false;
+      }
+      node_stack.push(std::move(node));
+      after_operand = true;
     } else if (type == query::NodeType::kPhrase) {
-      node_stack.push(
-          query::ASTNode::MakePhrase(preprocessor.Preprocess(token)));
+      const auto phrase = query::ParsePhraseToken(token);
+      node_stack.push(query::ASTNode::MakePhrase(
+          preprocessor.Preprocess(phrase->text), {.slop = phrase->slop}));
+      after_operand = true;
+    } else if (type == query::NodeType::kNot) {
+      op_stack.push('!');
     } else if (type == query::NodeType::kAnd) {
-      while (!op_stack.empty() && op_stack.top() == '&') {
-        apply_op(op_stack.top());
-        op_stack.pop();
-      }
-      op_stack.push('&');
+      push_and();
     } else {
       while (!op_stack.empty() && op_stack.top() != '(') {
         apply_op(op_stack.top());
@@ -67,6 +140,9 @@ std::unique_ptr<query::ASTNode> BuildAST(
     }
   }
 
+  if (after_near) {
+    throw std::runtime_error("BuildAST: missing operand for NEAR");
+  }
   while (!op_stack.empty()) {
     if (op_stack.top() == '(') {
       throw std::runtime_error("BuildAST: '(' without ')'");
@@ -84,23 +160,72 @@ std::unique_ptr<query::ASTNode> BuildAST(
 
   return std::move(node_stack.top());
 }
-indexing::CompressedPostingList ExecuteAST(
-    const query::ASTNode& node, const indexing::InvertedIndex& index) {
+
+std::unique_ptr<query::QueryIterator> MakeIterator(
+    const query::ASTNode& node, const indexing::InvertedIndex& index,
+    indexing::PostingCache* cache) {
   switch (node.type) {
     case query::NodeType::kTerm: {
-      return index.GetPostings(node.terms.front());
+      const auto& term = node.terms.front();
+      return std::make_unique<query::TermIterator>(
+          index.GetPostings(term), cache ? cache->Get(index, term) : nullptr);
     }
     case query::NodeType::kPhrase: {
-      return query::ExecutePhraseQuery(node.terms, index);
+      std::vector<const indexing::CompressedPostingList*> lists;
+      for (const auto& term : node.terms) {
+        lists.push_back(&index.GetPostings(term));
+      }
+      return std::make_unique<query::PhraseIterator>(lists, node.proximity);
     }
     case query::NodeType::kAnd: {
-      return ExecuteAST(*node.left, index) & ExecuteAST(*node.right, index);
+      // Negated children are subtracted from the conjunction of the rest
+      std::vector<std::unique_ptr<query::QueryIterator>> include;
+      std::vector<std::unique_ptr<query::QueryIterator>> exclude;
+      for (const auto& child : node.children) {
+        if (child->type == query::NodeType::kNot) {
+          exclude.push_back(
+              MakeIterator(*child->children.front(), index, cache));
+        } else {
+          include.push_back(MakeIterator(*child, index, cache));
+        }
+      }
+
+      std::unique_ptr<query::QueryIterator> result;
+      if (include.empty()) {
+        result = std::make_unique<query::AllDocsIterator>(index);
+      } else if (include.size() == 1) {
+        result = std::move(include.front());
+      } else {
+        result = std::make_unique<query::AndIterator>(std::move(include));
+      }
+      if (exclude.empty()) {
+        return result;
+      }
+      auto excluded =
+          exclude.size() == 1
+              ? std::move(exclude.front())
+              : std::make_unique<query::OrIterator>(std::move(exclude));
+      return std::make_unique<query::AndNotIterator>(std::move(result),
+                                                     std::move(excluded));
     }
     case query::NodeType::kOr: {
-      return ExecuteAST(*node.left, index) | ExecuteAST(*node.right, index);
+      std::vector<std::unique_ptr<query::QueryIterator>> children;
+      for (const auto& child : node.children) {
+        children.push_back(MakeIterator(*child, index, cache));
+      }
+      return std::make_unique<query::OrIterator>(std::move(children));
+    }
+    case query::NodeType::kNot: {
+      auto all = std::make_unique<query::AllDocsIterator>(index);
+      if (node.children.front()->type == query::NodeType::kEmpty) {
+        return all;
+      }
+      return std::make_unique<query::AndNotIterator>(
+          std::move(all),
+          MakeIterator(*node.children.front(), index, cache));
     }
     default: {
-      throw std::runtime_error("ExecuteAST: unknown NodeType");
+      throw std::runtime_error("MakeIterator: unknown NodeType");
     }
   }
 }
@@ -123,6 +248,8 @@ BoolQuery BoolQuery::Parse(const std::string& query,
       in_phrase = !in_phrase;
     } else if (in_phrase) {
       buffer.push_back(c);
+    } else if ((c == '-' || c == '!') && buffer.empty()) {
+      raw_tokens.push_back(std::string(1, c));
     } else if (std::isspace(c)) {
       if (!buffer.empty()) {
         raw_tokens.push_back(buffer);
@@ -141,12 +268,25 @@ BoolQuery BoolQuery::Parse(const std::string& query,
   if (!buffer.empty()) {
     raw_tokens.push_back(buffer);
   }
+  // The slop of `"..."~k` is read as a token of its own
+  for (size_t i = 1; i < raw_tokens.size(); ++i) {
+    if (raw_tokens[i].front() == '~' && raw_tokens[i - 1].size() > 1 &&
+        raw_tokens[i - 1].front() == '"' && raw_tokens[i - 1].back() == '"') {
+      raw_tokens[i - 1] += raw_tokens[i];
+      raw_tokens.erase(raw_tokens.begin() + i);
+    }
+  }
 
   std::vector<std::string> terms;
   for (const auto& token : raw_tokens) {
     const auto type = query::GetTermType(token);
+    if (query::ParseNearToken(token)) {
+      continue;
+    }
     if (type == query::NodeType::kTerm || type == query::NodeType::kPhrase) {
-      const auto prepared_token = preprocessor.Preprocess(token);
+      const auto phrase = query::ParsePhraseToken(token);
+      const auto prepared_token =
+          preprocessor.Preprocess(phrase ? phrase->text : token);
       terms.insert(terms.end(), prepared_token.begin(), prepared_token.end());
     }
   }
@@ -161,12 +301,54 @@ BoolQuery::BoolQuery(std::unique_ptr<query::ASTNode>&& ast,
 
 const std::vector<std::string>& BoolQuery::terms() const { return terms_; }
 
-indexing::CompressedPostingList BoolQuery::Execute(
-    const indexing::InvertedIndex& index) {
+std::vector<indexing::DocID> BoolQuery::Execute(
+    const indexing::InvertedIndex& index, size_t limit /* = SIZE_MAX */,
+    indexing::PostingCache* cache /* = nullptr */) const {
+  std::vector<indexing::DocID> result;
+  if (!tree_) {
+    return result;
+  }
+
+  const auto plan = PlanQuery(*tree_, index);
+  if (plan->type == NodeType::kEmpty) {
+    return result;
+  }
+  auto itr = MakeIterator(*plan, index, cache);
+  if (index.GetDeletedCount() > 0) {
+    itr = std::make_unique<LiveDocsIterator>(std::move(itr), index);
+  }
+  for (; !itr->IsEnd() && result.size() < limit; itr->Next()) {
+    result.push_back(itr->doc());
+  }
+  return result;
+}
+
+std::vector<indexing::DocID> BoolQuery::Execute(
+    const std::vector<const indexing::InvertedIndex*>& segments,
+    size_t limit /* = SIZE_MAX */,
+    indexing::PostingCache* cache /* = nullptr */) const {
+  std::vector<indexing::DocID> result;
+  for (const auto* segment : segments) {
+    const auto docs = Execute(*segment, limit, cache);
+    result.insert(result.end(), docs.begin(), docs.end());
+  }
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+  if (result.size() > limit) {
+    result.resize(limit);
+  }
+  return result;
+}
+
+std::string BoolQuery::CacheKey() const {
+  return tree_ ? Serialize(*tree_) : "";
+}
+
+std::string BoolQuery::Explain(const indexing::InvertedIndex& index) const {
   if (!tree_) {
-    return {};
+    return "";
   }
-  return ExecuteAST(*tree_, index);
+  return ExplainPlan(*PlanQuery(*tree_, index));
 }
 
 }  // namespace query
\ No newline at end of file
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
+#include "engine/indexing/types.h"
 #include "engine/query/ast.h"
 
 namespace linguistics {
@@ -10,7 +12,7 @@ class Preprocessor;
 }
 namespace indexing {
 class InvertedIndex;
-class CompressedPostingList;
+class PostingCache;
 }  // namespace indexing
 
 namespace query {
@@ -25,7 +27,21 @@ class BoolQuery {
 
   const std::vector<std::string>& terms() const;
 
-  indexing::CompressedPostingList Execute(const indexing::InvertedIndex& index);
+  // Terms whose lists are in `cache` are read from their decoded postings
+  std::vector<indexing::DocID> Execute(
+      const indexing::InvertedIndex& index, size_t limit = SIZE_MAX,
+      indexing::PostingCache* cache = nullptr) const;
+  // Each segment is planned and executed on its own, the first `limit`
+  // documents of the union are returned
+  std::vector<indexing::DocID> Execute(
+      const std::vector<const indexing::InvertedIndex*>& segments,
+      size_t limit = SIZE_MAX,
+      indexing::PostingCache* cache = nullptr) const;
+
+  // Execution plan of the query against the index, see PlanQuery
+  std::string Explain(const indexing::InvertedIndex& index) const;
+  // Equal for queries with the same preprocessed tree
+  std::string CacheKey() const;
 
  private:
   std::unique_ptr<ASTNode> tree_;
@@ -3,7 +3,7 @@
 #include <gtest/gtest.h>
 
 #include "engine/indexing/inverted_index.h"
-#include "engine/indexing/posting_list.h"
+#include "engine/indexing/posting_cache.h"
 #include "linguistics/lemmatization/mock_lemmatizer.h"
 #include "linguistics/preprocessor.h"
 #include "linguistics/tokenization/tokenizer_impl.h"
@@ -33,48 +33,153 @@ class BoolQueryTest : public testing::Test {
 
 TEST_F(BoolQueryTest, OneWordQuery) {
   auto q = BoolQuery::Parse("text", preprocessor);
-  const auto list = q.Execute(index);
+  const auto docs = q.Execute(index);
   const std::vector<indexing::DocID> expected{0, 1, 2};
-  EXPECT_EQ(list.Decompress().docs(), expected);
+  EXPECT_EQ(docs, expected);
 }
 
 TEST_F(BoolQueryTest, AndQuery) {
   auto q = BoolQuery::Parse("text & simple", preprocessor);
-  const auto list = q.Execute(index);
+  const auto docs = q.Execute(index);
   const std::vector<indexing::DocID> expected{0, 2};
-  EXPECT_EQ(list.Decompress().docs(), expected);
+  EXPECT_EQ(docs, expected);
 }
 
 TEST_F(BoolQueryTest, OrQuery) {
   auto q = BoolQuery::Parse("text | world", preprocessor);
-  const auto list = q.Execute(index);
+  const auto docs = q.Execute(index);
   const std::vector<indexing::DocID> expected{0, 1, 2, 3};
-  EXPECT_EQ(list.Decompress().docs(), expected);
+  EXPECT_EQ(docs, expected);
 }
 
 TEST_F(BoolQueryTest, ComplexQuery) {
   auto q = BoolQuery::Parse("hello | simple & text", preprocessor);
-  const auto list = q.Execute(index);
+  const auto docs = q.Execute(index);
   const std::vector<indexing::DocID> expected{0, 2, 3};
-  EXPECT_EQ(list.Decompress().docs(), expected);
+  EXPECT_EQ(docs, expected);
 }
 
 TEST_F(BoolQueryTest, PhraseQuery) {
   auto q = BoolQuery::Parse("hello | \"simple text\"", preprocessor);
-  const auto list = q.Execute(index);
+  const auto docs = q.Execute(index);
   const std::vector<indexing::DocID> expected{0, 3};
-  EXPECT_EQ(list.Decompress().docs(), expected);
+  EXPECT_EQ(docs, expected);
+}
+
+TEST_F(BoolQueryTest, ProximityQuery) {
+  auto q = BoolQuery::Parse("\"simple text\"~1", preprocessor);
+  std::vector<indexing::DocID> expected{0, 2};
+  EXPECT_EQ(q.Execute(index), expected);
+
+  q = BoolQuery::Parse("text NEAR/1 very | hello NEAR/0 world", preprocessor);
+  expected = {1, 3};
+  EXPECT_EQ(q.Execute(index), expected);
+
+  q = BoolQuery::Parse("!(text NEAR/0 simple)", preprocessor);
+  expected = {1, 2, 3};
+  EXPECT_EQ(q.Execute(index), expected);
+
+  EXPECT_THROW(BoolQuery::Parse("text NEAR/1", preprocessor),
+               std::runtime_error);
+  EXPECT_THROW(BoolQuery::Parse("text NEAR/1 (very)", preprocessor),
+               std::runtime_error);
 }
 
 TEST_F(BoolQueryTest, QueryWithParentheses) {
   auto q = BoolQuery::Parse("text & (complex | simple)", preprocessor);
-  const auto list = q.Execute(index);
+  const auto docs = q.Execute(index);
   const std::vector<indexing::DocID> expected{0, 1, 2};
-  EXPECT_EQ(list.Decompress().docs(), expected);
+  EXPECT_EQ(docs, expected);
 }
 
 TEST_F(BoolQueryTest, EmptyQuery) {
   auto q = BoolQuery::Parse("", preprocessor);
-  const auto list = q.Execute(index);
-  EXPECT_TRUE(list.size() == 0);
-}
\ No newline at end of file
+  const auto docs = q.Execute(index);
+  EXPECT_TRUE(docs.empty());
+}
+TEST_F(BoolQueryTest, Limit) {
+  auto q = BoolQuery::Parse("text | world", preprocessor);
+  const auto docs = q.Execute(index, 2);
+  const std::vector<indexing::DocID> expected{0, 1};
+  EXPECT_EQ(docs, expected);
+}
+
+TEST_F(BoolQueryTest, NotQuery) {
+  auto q = BoolQuery::Parse("text -simple", preprocessor);
+  std::vector<indexing::DocID> expected{1};
+  EXPECT_EQ(q.Execute(index), expected);
+
+  q = BoolQuery::Parse("text & !(complex | another)", preprocessor);
+  expected = {0};
+  EXPECT_EQ(q.Execute(index), expected);
+
+  q = BoolQuery::Parse("not text", preprocessor);
+  expected = {3};
+  EXPECT_EQ(q.Execute(index), expected);
+
+  q = BoolQuery::Parse("hello | -simple & -very", preprocessor);
+  expected = {3};
+  EXPECT_EQ(q.Execute(index), expected);
+
+  q = BoolQuery::Parse("simple -\"simple text\"", preprocessor);
+  expected = {2};
+  EXPECT_EQ(q.Execute(index), expected);
+}
+
+TEST_F(BoolQueryTest, Segments) {
+  indexing::InvertedIndex first;
+  indexing::InvertedIndex second;
+  first.AddDocument(0, {"simple", "text"});
+  second.AddDocument(1, {"very", "complex", "text"});
+  first.AddDocument(2, {"simple", "another", "text"});
+  second.AddDocument(3, {"hello", "world"});
+
+  auto q = BoolQuery::Parse("text -complex", preprocessor);
+  std::vector<indexing::DocID> expected{0, 2};
+  EXPECT_EQ(q.Execute({&second, &first}), expected);
+
+  q = BoolQuery::Parse("text | hello", preprocessor);
+  expected = {0, 1};
+  EXPECT_EQ(q.Execute({&first, &second}, 2), expected);
+}
+
+TEST_F(BoolQueryTest, DeletedDocuments) {
+  EXPECT_TRUE(index.Delete(2));
+  EXPECT_FALSE(index.Delete(2));
+  EXPECT_FALSE(index.Delete(10));
+
+  auto q = BoolQuery::Parse("text", preprocessor);
+  std::vector<indexing::DocID> expected{0, 1};
+  EXPECT_EQ(q.Execute(index), expected);
+
+  q = BoolQuery::Parse("not complex", preprocessor);
+  expected = {0, 3};
+  EXPECT_EQ(q.Execute(index), expected);
+
+  q = BoolQuery::Parse("\"simple text\" | another", preprocessor);
+  expected = {0};
+  EXPECT_EQ(q.Execute(index), expected);
+}
+
+TEST_F(BoolQueryTest, CacheKey) {
+  const auto key = BoolQuery::Parse("text & \"simple text\"~1", preprocessor)
+                       .CacheKey();
+  EXPECT_EQ(BoolQuery::Parse("  text   \"simple  text\"~1", preprocessor)
+                .CacheKey(),
+            key);
+  EXPECT_NE(BoolQuery::Parse("text | \"simple text\"~1", preprocessor)
+                .CacheKey(),
+            key);
+  EXPECT_NE(BoolQuery::Parse("text & \"simple text\"", preprocessor)
+                .CacheKey(),
+            key);
+}
+
+TEST_F(BoolQueryTest, PostingCache) {
+  indexing::PostingCache cache({.admit_after = 1, .min_list_size = 1});
+  auto q = BoolQuery::Parse("text & !(complex | world) | hello", preprocessor);
+  const std::vector<indexing::DocID> expected{0, 2, 3};
+  EXPECT_EQ(q.Execute(index, SIZE_MAX, &cache), expected);
+  EXPECT_EQ(q.Execute(index, SIZE_MAX, &cache), expected);
+  EXPECT_GT(cache.stats().hits, 0);
+}
@@ -2,11 +2,12 @@
 
 #include "engine/indexing/compressed_posting_list.h"
 #include "engine/indexing/inverted_index.h"
+#include "engine/query/ast.h"
 
 namespace query {
 
 indexing::CompressedPostingList ExecutePhraseQuery(
     const std::vector<std::string>& terms,
-    const indexing::InvertedIndex& index);
+    const indexing::InvertedIndex& index, Proximity proximity = {});
 
 }  // namespace query
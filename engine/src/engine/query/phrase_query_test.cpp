@@ -55,3 +55,21 @@ TEST_F(PhraseQueryTest, NonexistentWordQuery) {
 
   EXPECT_TRUE(res.Decompress().docs().empty());
 }
+
+TEST_F(PhraseQueryTest, SlopQuery) {
+  const auto res = ExecutePhraseQuery({"simple", "text"}, index, {.slop = 1});
+  const std::vector<indexing::DocID> expected{0, 2};
+
+  EXPECT_EQ(res.Decompress().docs(), expected);
+}
+
+TEST_F(PhraseQueryTest, NearQuery) {
+  auto res = ExecutePhraseQuery({"text", "very"}, index,
+                                {.slop = 0, .ordered = false});
+  EXPECT_TRUE(res.Decompress().docs().empty());
+
+  res = ExecutePhraseQuery({"text", "very"}, index,
+                           {.slop = 1, .ordered = false});
+  const std::vector<indexing::DocID> expected{1};
+  EXPECT_EQ(res.Decompress().docs(), expected);
+}
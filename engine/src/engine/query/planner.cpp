@@ -0,0 +1,213 @@
+#include "engine/query/planner.h"
+
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+
+#include "engine/indexing/inverted_index.h"
+
+namespace {
+
+void Flatten(const query::ASTNode& node, query::NodeType type,
+             const indexing::InvertedIndex& index,
+             std::vector<std::unique_ptr<query::ASTNode>>& children) {
+  for (const auto& child : node.children) {
+    if (child->type == type) {
+      Flatten(*child, type, index, children);
+      continue;
+    }
+    // Pruning may collapse a child into a node of the parent's type
+    auto planned = query::PlanQuery(*child, index);
+    if (planned->type == type) {
+      std::move(planned->children.begin(), planned->children.end(),
+                std::back_inserter(children));
+    } else {
+      children.push_back(std::move(planned));
+    }
+  }
+}
+
+bool IsNegation(const query::ASTNode& node) {
+  return node.type == query::NodeType::kNot;
+}
+
+std::unique_ptr<query::ASTNode> PlanAnd(
+    std::vector<std::unique_ptr<query::ASTNode>>&& children) {
+  for (const auto& child : children) {
+    if (child->type == query::NodeType::kEmpty) {
+      return query::ASTNode::MakeEmpty();
+    }
+  }
+  // Excluding nothing does not restrict the conjunction
+  if (children.size() > 1) {
+    std::erase_if(children, [](const auto& child) {
+      return IsNegation(*child) &&
+             child->children.front()->type == query::NodeType::kEmpty;
+    });
+  }
+
+  // Phrases are verified only on documents the cheaper terms agree on,
+  // negations are subtracted from the result of the rest
+  std::stable_sort(children.begin(), children.end(),
+                   [](const auto& a, const auto& b) {
+                     if (IsNegation(*a) != IsNegation(*b)) {
+                       return IsNegation(*b);
+                     }
+                     const bool a_phrase = a->type == query::NodeType::kPhrase;
+                     const bool b_phrase = b->type == query::NodeType::kPhrase;
+                     if (a_phrase != b_phrase) {
+                       return b_phrase;
+                     }
+                     return a->cost < b->cost;
+                   });
+
+  if (children.size() == 1) {
+    return std::move(children.front());
+  }
+  auto node = std::make_unique<query::ASTNode>();
+  node->type = query::NodeType::kAnd;
+  node->cost = children.front()->cost;
+  for (const auto& child : children) {
+    if (!IsNegation(*child)) {
+      node->cost = std::min(node->cost, child->cost);
+    }
+  }
+  node->children = std::move(children);
+  return node;
+}
+
+std::unique_ptr<query::ASTNode> PlanOr(
+    std::vector<std::unique_ptr<query::ASTNode>>&& children) {
+  std::erase_if(children, [](const auto& child) {
+    return child->type == query::NodeType::kEmpty;
+  });
+
+  if (children.empty()) {
+    return query::ASTNode::MakeEmpty();
+  }
+  if (children.size() == 1) {
+    return std::move(children.front());
+  }
+  auto node = std::make_unique<query::ASTNode>();
+  node->type = query::NodeType::kOr;
+  for (const auto& child : children) {
+    node->cost += child->cost;
+  }
+  node->children = std::move(children);
+  return node;
+}
+
+void Explain(const query::ASTNode& node, size_t depth,
+             std::ostringstream& oss) {
+  oss << std::string(depth * 2, ' ');
+  switch (node.type) {
+    case query::NodeType::kTerm: {
+      oss << "TERM " << node.terms.front();
+      break;
+    }
+    case query::NodeType::kPhrase: {
+      if (!node.proximity.ordered) {
+        oss << "NEAR/" << node.proximity.slop;
+        for (const auto& term : node.terms) {
+          oss << ' ' << term;
+        }
+        break;
+      }
+      oss << "PHRASE \"";
+      for (size_t i = 0; i < node.terms.size(); ++i) {
+        oss << (i > 0 ? " " : "") << node.terms[i];
+      }
+      oss << '"';
+      if (node.proximity.slop > 0) {
+        oss << '~' << node.proximity.slop;
+      }
+      break;
+    }
+    case query::NodeType::kAnd: {
+      oss << "AND";
+      break;
+    }
+    case query::NodeType::kOr: {
+      oss << "OR";
+      break;
+    }
+    case query::NodeType::kNot: {
+      oss << "NOT";
+      break;
+    }
+    case query::NodeType::kEmpty: {
+      oss << "EMPTY";
+      break;
+    }
+  }
+  oss << " [cost=" << node.cost << "]\n";
+
+  for (const auto& child : node.children) {
+    Explain(*child, depth + 1, oss);
+  }
+}
+
+}  // namespace
+
+namespace query {
+
+std::unique_ptr<ASTNode> PlanQuery(const ASTNode& tree,
+                                   const indexing::InvertedIndex& index) {
+  switch (tree.type) {
+    case NodeType::kTerm: {
+      auto node = ASTNode::MakeTerm(tree.terms.front());
+      node->cost = index.GetPostings(node->terms.front()).size();
+      if (node->cost == 0) {
+        return ASTNode::MakeEmpty();
+      }
+      return node;
+    }
+    case NodeType::kPhrase: {
+      if (tree.terms.empty()) {
+        return ASTNode::MakeEmpty();
+      }
+      auto node = ASTNode::MakePhrase(tree.terms, tree.proximity);
+      node->cost = SIZE_MAX;
+      for (const auto& term : node->terms) {
+        node->cost = std::min(node->cost, index.GetPostings(term).size());
+      }
+      if (node->cost == 0) {
+        return ASTNode::MakeEmpty();
+      }
+      return node;
+    }
+    case NodeType::kAnd: {
+      std::vector<std::unique_ptr<ASTNode>> children;
+      Flatten(tree, NodeType::kAnd, index, children);
+      return PlanAnd(std::move(children));
+    }
+    case NodeType::kOr: {
+      std::vector<std::unique_ptr<ASTNode>> children;
+      Flatten(tree, NodeType::kOr, index, children);
+      return PlanOr(std::move(children));
+    }
+    case NodeType::kNot: {
+      auto child = PlanQuery(*tree.children.front(), index);
+      if (IsNegation(*child)) {
+        return std::move(child->children.front());
+      }
+      const size_t docs_count = index.GetDocsCount();
+      const size_t excluded = std::min(child->cost, docs_count);
+      auto node = ASTNode::MakeNot(std::move(child));
+      node->cost = docs_count - excluded;
+      return node;
+    }
+    case NodeType::kEmpty: {
+      return ASTNode::MakeEmpty();
+    }
+  }
+  throw std::runtime_error("PlanQuery: unknown NodeType");
+}
+
+std::string ExplainPlan(const ASTNode& plan) {
+  std::ostringstream oss;
+  Explain(plan, 0, oss);
+  return oss.str();
+}
+
+}  // namespace query
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "engine/query/ast.h"
+
+namespace indexing {
+class InvertedIndex;
+}  // namespace indexing
+
+namespace query {
+
+// Rewrites a parsed query into an execution plan: AND/OR chains are
+// flattened into n-ary nodes, conjunctions are ordered from the cheapest
+// child with phrases last, and branches that cannot match are pruned.
+// Every node of the plan carries its estimated cost.
+std::unique_ptr<ASTNode> PlanQuery(const ASTNode& tree,
+                                   const indexing::InvertedIndex& index);
+
+// Indented dump of a plan with the estimated cost of every node.
+std::string ExplainPlan(const ASTNode& plan);
+
+}  // namespace query
@@ -0,0 +1,85 @@
+#include "engine/query/planner.h"
+
+#include <gtest/gtest.h>
+
+#include "engine/indexing/inverted_index.h"
+#include "engine/query/bool_query.h"
+#include "linguistics/lemmatization/mock_lemmatizer.h"
+#include "linguistics/preprocessor.h"
+#include "linguistics/tokenization/tokenizer_impl.h"
+
+using namespace query;
+
+class PlannerTest : public testing::Test {
+ public:
+  PlannerTest()
+      : preprocessor(std::make_unique<linguistics::TokenizerImpl>(),
+                     std::make_unique<linguistics::MockLemmatizer>()) {
+    std::vector<std::vector<std::string>> docs{
+        {"common", "text"},
+        {"common", "rare", "text"},
+        {"common", "another", "text"},
+        {"common", "text", "again"},
+    };
+    for (indexing::DocID i = 0; i < docs.size(); ++i) {
+      index.AddDocument(i, docs[i]);
+    }
+  }
+
+ protected:
+  indexing::InvertedIndex index;
+  linguistics::Preprocessor preprocessor;
+};
+
+TEST_F(PlannerTest, OrdersConjunctionByCost) {
+  auto q = BoolQuery::Parse("common & \"rare text\" & (text & rare)",
+                            preprocessor);
+  const std::string expected =
+      "AND [cost=1]\n"
+      "  TERM rare [cost=1]\n"
+      "  TERM common [cost=4]\n"
+      "  TERM text [cost=4]\n"
+      "  PHRASE \"rare text\" [cost=1]\n";
+  EXPECT_EQ(q.Explain(index), expected);
+
+  const std::vector<indexing::DocID> docs{1};
+  EXPECT_EQ(q.Execute(index), docs);
+}
+
+TEST_F(PlannerTest, FlattensDisjunction) {
+  auto q = BoolQuery::Parse("rare | (another | again)", preprocessor);
+  const std::string expected =
+      "OR [cost=3]\n"
+      "  TERM rare [cost=1]\n"
+      "  TERM another [cost=1]\n"
+      "  TERM again [cost=1]\n";
+  EXPECT_EQ(q.Explain(index), expected);
+}
+
+TEST_F(PlannerTest, PrunesEmptyBranches) {
+  auto q = BoolQuery::Parse("missing & text", preprocessor);
+  EXPECT_EQ(q.Explain(index), "EMPTY [cost=0]\n");
+  EXPECT_TRUE(q.Execute(index).empty());
+
+  q = BoolQuery::Parse("(missing & text) | rare & (another | missing)",
+                       preprocessor);
+  const std::string expected =
+      "AND [cost=1]\n"
+      "  TERM rare [cost=1]\n"
+      "  TERM another [cost=1]\n";
+  EXPECT_EQ(q.Explain(index), expected);
+  EXPECT_TRUE(q.Execute(index).empty());
+}
+
+TEST_F(PlannerTest, ExplainsProximity) {
+  auto q = BoolQuery::Parse("\"common text\"~1 & again NEAR/2 common",
+                            preprocessor);
+  const std::string expected =
+      "AND [cost=1]\n"
+      "  NEAR/2 again common [cost=1]\n"
+      "  PHRASE \"common text\"~1 [cost=4]\n";
+  EXPECT_EQ(q.Explain(index), expected);
+
+  const std::vector<indexing::DocID> docs{3};
+  EXPECT_EQ(q.Execute(index), docs);
+}
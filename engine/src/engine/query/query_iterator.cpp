@@ -0,0 +1,394 @@
+#include "engine/query/query_iterator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+
+#include "engine/indexing/inverted_index.h"
+
+namespace query {
+
+TermIterator::TermIterator(
+    const indexing::CompressedPostingList& list,
+    std::shared_ptr<const indexing::DecodedPostings> decoded /* = nullptr */)
+    : decoded_(std::move(decoded)),
+      itr_(decoded_ ? indexing::CompressedPostingList::DocIterator(
+                          &list, decoded_.get())
+                    : list.begin()) {}
+
+indexing::DocID TermIterator::doc() const { return itr_.doc_id(); }
+
+bool TermIterator::IsEnd() const { return itr_.IsEnd(); }
+
+void TermIterator::Next() { ++itr_; }
+
+void TermIterator::SkipTo(indexing::DocID target) {
+  if (!itr_.IsEnd()) {
+    itr_.SkipTo(target);
+  }
+}
+
+AndIterator::AndIterator(
+    std::vector<std::unique_ptr<QueryIterator>>&& children)
+    : children_(std::move(children)) {
+  is_end_ = children_.empty();
+  Align();
+}
+
+indexing::DocID AndIterator::doc() const { return children_.front()->doc(); }
+
+bool AndIterator::IsEnd() const { return is_end_; }
+
+void AndIterator::Next() {
+  if (is_end_) {
+    return;
+  }
+  children_.front()->Next();
+  Align();
+}
+
+void AndIterator::SkipTo(indexing::DocID target) {
+  if (is_end_) {
+    return;
+  }
+  children_.front()->SkipTo(target);
+  Align();
+}
+
+void AndIterator::Align() {
+  if (is_end_) {
+    return;
+  }
+  if (children_.front()->IsEnd()) {
+    is_end_ = true;
+    return;
+  }
+
+  // The first child drives, the others are skipped to its candidates
+  indexing::DocID target = children_.front()->doc();
+  for (size_t i = 1; i < children_.size();) {
+    auto& child = children_[i];
+    child->SkipTo(target);
+    if (child->IsEnd()) {
+      is_end_ = true;
+      return;
+    }
+    if (child->doc() > target) {
+      target = child->doc();
+      children_.front()->SkipTo(target);
+      if (children_.front()->IsEnd()) {
+        is_end_ = true;
+        return;
+      }
+      target = children_.front()->doc();
+      i = 1;
+      continue;
+    }
+    ++i;
+  }
+}
+
+OrIterator::OrIterator(std::vector<std::unique_ptr<QueryIterator>>&& children)
+    : children_(std::move(children)) {
+  UpdateCurrent();
+}
+
+indexing::DocID OrIterator::doc() const { return current_; }
+
+bool OrIterator::IsEnd() const { return is_end_; }
+
+void OrIterator::Next() {
+  if (is_end_) {
+    return;
+  }
+  for (auto& child : children_) {
+    if (!child->IsEnd() && child->doc() == current_) {
+      child->Next();
+    }
+  }
+  UpdateCurrent();
+}
+
+void OrIterator::SkipTo(indexing::DocID target) {
+  if (is_end_ || current_ >= target) {
+    return;
+  }
+  for (auto& child : children_) {
+    if (!child->IsEnd() && child->doc() < target) {
+      child->SkipTo(target);
+    }
+  }
+  UpdateCurrent();
+}
+
+void OrIterator::UpdateCurrent() {
+  is_end_ = true;
+  for (const auto& child : children_) {
+    if (child->IsEnd()) {
+      continue;
+    }
+    if (is_end_ || child->doc() < current_) {
+      current_ = child->doc();
+      is_end_ = false;
+    }
+  }
+}
+
+AndNotIterator::AndNotIterator(std::unique_ptr<QueryIterator>&& include,
+                               std::unique_ptr<QueryIterator>&& exclude)
+    : include_(std::move(include)), exclude_(std::move(exclude)) {
+  SkipExcluded();
+}
+
+indexing::DocID AndNotIterator::doc() const { return include_->doc(); }
+
+bool AndNotIterator::IsEnd() const { return include_->IsEnd(); }
+
+void AndNotIterator::Next() {
+  if (include_->IsEnd()) {
+    return;
+  }
+  include_->Next();
+  SkipExcluded();
+}
+
+void AndNotIterator::SkipTo(indexing::DocID target) {
+  if (include_->IsEnd()) {
+    return;
+  }
+  include_->SkipTo(target);
+  SkipExcluded();
+}
+
+void AndNotIterator::SkipExcluded() {
+  while (!include_->IsEnd()) {
+    exclude_->SkipTo(include_->doc());
+    if (exclude_->IsEnd() || exclude_->doc() != include_->doc()) {
+      return;
+    }
+    include_->Next();
+  }
+}
+
+AllDocsIterator::AllDocsIterator(const indexing::InvertedIndex& index)
+    : index_(&index), current_(index.GetFirstDocID()) {
+  SkipMissing();
+}
+
+indexing::DocID AllDocsIterator::doc() const { return current_; }
+
+bool AllDocsIterator::IsEnd() const {
+  return current_ >= index_->GetDocsCount();
+}
+
+void AllDocsIterator::Next() {
+  if (IsEnd()) {
+    return;
+  }
+  ++current_;
+  SkipMissing();
+}
+
+void AllDocsIterator::SkipTo(indexing::DocID target) {
+  if (current_ >= target) {
+    return;
+  }
+  current_ = target;
+  SkipMissing();
+}
+
+void AllDocsIterator::SkipMissing() {
+  while (!IsEnd() && index_->GetDocLength(current_) == 0) {
+    ++current_;
+  }
+}
+
+LiveDocsIterator::LiveDocsIterator(std::unique_ptr<QueryIterator>&& child,
+                                   const indexing::InvertedIndex& index)
+    : child_(std::move(child)), index_(&index) {
+  SkipDeleted();
+}
+
+indexing::DocID LiveDocsIterator::doc() const { return child_->doc(); }
+
+bool LiveDocsIterator::IsEnd() const { return child_->IsEnd(); }
+
+void LiveDocsIterator::Next() {
+  if (child_->IsEnd()) {
+    return;
+  }
+  child_->Next();
+  SkipDeleted();
+}
+
+void LiveDocsIterator::SkipTo(indexing::DocID target) {
+  if (child_->IsEnd()) {
+    return;
+  }
+  child_->SkipTo(target);
+  SkipDeleted();
+}
+
+void LiveDocsIterator::SkipDeleted() {
+  while (!child_->IsEnd() && index_->IsDeleted(child_->doc())) {
+    child_->Next();
+  }
+}
+
+PositionMatcher::PositionMatcher(size_t terms_count, Proximity proximity)
+    : proximity_(proximity),
+      positions_(terms_count),
+      cursors_(terms_count) {}
+
+std::vector<uint32_t>& PositionMatcher::positions(size_t term) {
+  return positions_[term];
+}
+
+bool PositionMatcher::Match() {
+  if (positions_.empty()) {
+    return false;
+  }
+  return proximity_.ordered ? MatchOrdered() : MatchUnordered();
+}
+
+bool PositionMatcher::MatchOrdered() {
+  // From every start takes the earliest following position of each next
+  // term, these only grow with the start, so the cursors never go back
+  std::fill(cursors_.begin(), cursors_.end(), 0);
+  const auto& starts = positions_.front();
+  const uint32_t max_span = proximity_.slop + positions_.size() - 1;
+  for (const uint32_t start : starts) {
+    uint32_t last = start;
+    for (size_t i = 1; i < positions_.size(); ++i) {
+      const auto& term_positions = positions_[i];
+      auto& cursor = cursors_[i];
+      while (cursor < term_positions.size() &&
+             term_positions[cursor] <= last) {
+        ++cursor;
+      }
+      if (cursor == term_positions.size()) {
+        return false;
+      }
+      last = term_positions[cursor];
+    }
+    if (last - start <= max_span) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool PositionMatcher::MatchUnordered() {
+  // Moves the smallest of the current positions, which visits the minimal
+  // window ending at every position
+  std::fill(cursors_.begin(), cursors_.end(), 0);
+  const uint32_t max_span = proximity_.slop + positions_.size() - 1;
+  while (true) {
+    size_t lowest = 0;
+    uint32_t low = UINT32_MAX;
+    uint32_t high = 0;
+    for (size_t i = 0; i < positions_.size(); ++i) {
+      if (cursors_[i] == positions_[i].size()) {
+        return false;
+      }
+      const uint32_t position = positions_[i][cursors_[i]];
+      if (position < low) {
+        low = position;
+        lowest = i;
+      }
+      high = std::max(high, position);
+    }
+    if (high - low <= max_span) {
+      return true;
+    }
+    ++cursors_[lowest];
+  }
+}
+
+PhraseIterator::PhraseIterator(
+    const std::vector<const indexing::CompressedPostingList*>& lists,
+    Proximity proximity /* = {} */)
+    : matcher_(lists.size(), proximity) {
+  for (const auto* list : lists) {
+    iters_.push_back(list->begin());
+  }
+  order_.resize(lists.size());
+  std::iota(order_.begin(), order_.end(), 0);
+  std::stable_sort(order_.begin(), order_.end(), [&](size_t a, size_t b) {
+    return lists[a]->size() < lists[b]->size();
+  });
+  is_end_ = iters_.empty();
+  FindMatch();
+}
+
+indexing::DocID PhraseIterator::doc() const {
+  return iters_[order_.front()].doc_id();
+}
+
+bool PhraseIterator::IsEnd() const { return is_end_; }
+
+void PhraseIterator::Next() {
+  if (is_end_) {
+    return;
+  }
+  ++driver();
+  FindMatch();
+}
+
+void PhraseIterator::SkipTo(indexing::DocID target) {
+  if (is_end_ || doc() >= target) {
+    return;
+  }
+  driver().SkipTo(target);
+  FindMatch();
+}
+
+void PhraseIterator::FindMatch() {
+  while (!is_end_) {
+    if (driver().IsEnd()) {
+      is_end_ = true;
+      return;
+    }
+    const indexing::DocID target = driver().doc_id();
+    size_t i = 1;
+    for (; i < order_.size(); ++i) {
+      auto& itr = iters_[order_[i]];
+      itr.SkipTo(target);
+      if (itr.IsEnd()) {
+        is_end_ = true;
+        return;
+      }
+      if (itr.doc_id() != target) {
+        break;
+      }
+    }
+    if (i < order_.size()) {
+      driver().SkipTo(iters_[order_[i]].doc_id());
+      continue;
+    }
+
+    if (HasPhrase()) {
+      return;
+    }
+    ++driver();
+  }
+}
+
+indexing::CompressedPostingList::DocIterator& PhraseIterator::driver() {
+  return iters_[order_.front()];
+}
+
+bool PhraseIterator::HasPhrase() {
+  // Positions of each term are decoded once per document
+  for (size_t i = 0; i < iters_.size(); ++i) {
+    auto& positions = matcher_.positions(i);
+    positions.clear();
+    for (auto coord_itr = iters_[i].GetCoordItr(); !coord_itr.IsEnd();
+         ++coord_itr) {
+      positions.push_back(*coord_itr);
+    }
+  }
+  return matcher_.Match();
+}
+
+}  // namespace query
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "engine/indexing/compressed_posting_list.h"
+#include "engine/indexing/posting_cache.h"
+#include "engine/query/ast.h"
+
+namespace indexing {
+class InvertedIndex;
+}  // namespace indexing
+
+namespace query {
+
+// Lazy stream of document ids in increasing order. Operator iterators pull
+// from their children on demand, so a query never materializes
+// intermediate posting lists.
+class QueryIterator {
+ public:
+  virtual ~QueryIterator() = default;
+
+  // Current document, undefined when IsEnd()
+  virtual indexing::DocID doc() const = 0;
+  virtual bool IsEnd() const = 0;
+
+  virtual void Next() = 0;
+  // Moves to the first document >= target, never backwards
+  virtual void SkipTo(indexing::DocID target) = 0;
+};
+
+class TermIterator : public QueryIterator {
+ public:
+  // Reads the docs from `decoded` if the list is cached
+  explicit TermIterator(
+      const indexing::CompressedPostingList& list,
+      std::shared_ptr<const indexing::DecodedPostings> decoded = nullptr);
+
+  indexing::DocID doc() const override;
+  bool IsEnd() const override;
+
+  void Next() override;
+  void SkipTo(indexing::DocID target) override;
+
+ private:
+  std::shared_ptr<const indexing::DecodedPostings> decoded_;
+  indexing::CompressedPostingList::DocIterator itr_;
+};
+
+class AndIterator : public QueryIterator {
+ public:
+  explicit AndIterator(std::vector<std::unique_ptr<QueryIterator>>&& children);
+
+  indexing::DocID doc() const override;
+  bool IsEnd() const override;
+
+  void Next() override;
+  void SkipTo(indexing::DocID target) override;
+
+ private:
+  void Align();
+
+  std::vector<std::unique_ptr<QueryIterator>> children_;
+  bool is_end_ = false;
+};
+
+class OrIterator : public QueryIterator {
+ public:
+  explicit OrIterator(std::vector<std::unique_ptr<QueryIterator>>&& children);
+
+  indexing::DocID doc() const override;
+  bool IsEnd() const override;
+
+  void Next() override;
+  void SkipTo(indexing::DocID target) override;
+
+ private:
+  void UpdateCurrent();
+
+  std::vector<std::unique_ptr<QueryIterator>> children_;
+  indexing::DocID current_ = 0;
+  bool is_end_ = false;
+};
+
+// Documents of `include` that are missing from `exclude`. The excluded
+// side is only skipped to the included candidates, never fully decoded.
+class AndNotIterator : public QueryIterator {
+ public:
+  AndNotIterator(std::unique_ptr<QueryIterator>&& include,
+                 std::unique_ptr<QueryIterator>&& exclude);
+
+  indexing::DocID doc() const override;
+  bool IsEnd() const override;
+
+  void Next() override;
+  void SkipTo(indexing::DocID target) override;
+
+ private:
+  void SkipExcluded();
+
+  std::unique_ptr<QueryIterator> include_;
+  std::unique_ptr<QueryIterator> exclude_;
+};
+
+// Every indexed document, the universe a pure negation is taken from.
+class AllDocsIterator : public QueryIterator {
+ public:
+  explicit AllDocsIterator(const indexing::InvertedIndex& index);
+
+  indexing::DocID doc() const override;
+  bool IsEnd() const override;
+
+  void Next() override;
+  void SkipTo(indexing::DocID target) override;
+
+ private:
+  void SkipMissing();
+
+  const indexing::InvertedIndex* index_;
+  indexing::DocID current_ = 0;
+};
+
+// Documents of `child` not deleted from the index. Deletions make no
+// difference to the operators, so one filter at the root is enough.
+class LiveDocsIterator : public QueryIterator {
+ public:
+  LiveDocsIterator(std::unique_ptr<QueryIterator>&& child,
+                   const indexing::InvertedIndex& index);
+
+  indexing::DocID doc() const override;
+  bool IsEnd() const override;
+
+  void Next() override;
+  void SkipTo(indexing::DocID target) override;
+
+ private:
+  void SkipDeleted();
+
+  std::unique_ptr<QueryIterator> child_;
+  const indexing::InvertedIndex* index_;
+};
+
+// Checks the positions of the terms of a phrase within one document against
+// a proximity. The caller fills the sorted positions of every term, the
+// buffers are reused from document to document.
+class PositionMatcher {
+ public:
+  PositionMatcher(size_t terms_count, Proximity proximity);
+
+  std::vector<uint32_t>& positions(size_t term);
+  bool Match();
+
+ private:
+  // Both are a single pass over the positions with a cursor per term
+  bool MatchOrdered();
+  bool MatchUnordered();
+
+  Proximity proximity_;
+  std::vector<std::vector<uint32_t>> positions_;
+  std::vector<size_t> cursors_;
+};
+
+// Documents containing the terms at positions satisfying the proximity,
+// consecutive for an exact phrase, within the slop for "..."~N and in any
+// order for NEAR. The shortest list drives, the others are skipped to its
+// documents.
+class PhraseIterator : public QueryIterator {
+ public:
+  explicit PhraseIterator(
+      const std::vector<const indexing::CompressedPostingList*>& lists,
+      Proximity proximity = {});
+
+  indexing::DocID doc() const override;
+  bool IsEnd() const override;
+
+  void Next() override;
+  void SkipTo(indexing::DocID target) override;
+
+ private:
+  // Advances to the first common document holding the phrase
+  void FindMatch();
+  bool HasPhrase();
+
+  indexing::CompressedPostingList::DocIterator& driver();
+
+  // In phrase order, `order_` lists them from the shortest
+  std::vector<indexing::CompressedPostingList::DocIterator> iters_;
+  std::vector<size_t> order_;
+  PositionMatcher matcher_;
+  bool is_end_ = false;
+};
+
+}  // namespace query
@@ -0,0 +1,134 @@
+#include "engine/query/query_iterator.h"
+
+#include <gtest/gtest.h>
+
+using namespace query;
+
+namespace {
+
+indexing::CompressedPostingList MakeList(
+    const std::vector<indexing::DocID>& docs) {
+  indexing::CompressedPostingList list;
+  for (const auto doc_id : docs) {
+    list.Add(doc_id, {0});
+  }
+  list.BuildSkips();
+  return list;
+}
+
+std::vector<indexing::DocID> Drain(QueryIterator& itr) {
+  std::vector<indexing::DocID> result;
+  for (; !itr.IsEnd(); itr.Next()) {
+    result.push_back(itr.doc());
+  }
+  return result;
+}
+
+std::vector<std::unique_ptr<QueryIterator>> MakeTerms(
+    const std::vector<const indexing::CompressedPostingList*>& lists) {
+  std::vector<std::unique_ptr<QueryIterator>> result;
+  for (const auto* list : lists) {
+    result.push_back(std::make_unique<TermIterator>(*list));
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(QueryIteratorTest, And) {
+  const auto list1 = MakeList({1, 3, 5, 7, 9, 11});
+  const auto list2 = MakeList({2, 3, 4, 9, 10, 11});
+  const auto list3 = MakeList({3, 11, 12});
+
+  AndIterator itr(MakeTerms({&list1, &list2, &list3}));
+  const std::vector<indexing::DocID> expected{3, 11};
+  EXPECT_EQ(Drain(itr), expected);
+}
+
+TEST(QueryIteratorTest, Or) {
+  const auto list1 = MakeList({1, 5, 9});
+  const auto list2 = MakeList({2, 5, 10});
+
+  OrIterator itr(MakeTerms({&list1, &list2}));
+  itr.SkipTo(3);
+  const std::vector<indexing::DocID> expected{5, 9, 10};
+  EXPECT_EQ(Drain(itr), expected);
+}
+
+TEST(QueryIteratorTest, NestedSkipTo) {
+  const auto list1 = MakeList({1, 2, 3, 4, 5, 6, 7, 8});
+  const auto list2 = MakeList({2, 4, 6, 8});
+  const auto list3 = MakeList({7});
+
+  std::vector<std::unique_ptr<QueryIterator>> children;
+  children.push_back(
+      std::make_unique<AndIterator>(MakeTerms({&list1, &list2})));
+  children.push_back(std::make_unique<TermIterator>(list3));
+  OrIterator itr(std::move(children));
+
+  EXPECT_EQ(itr.doc(), 2);
+  itr.SkipTo(5);
+  EXPECT_EQ(itr.doc(), 6);
+  itr.Next();
+  EXPECT_EQ(itr.doc(), 7);
+  itr.SkipTo(9);
+  EXPECT_TRUE(itr.IsEnd());
+}
+
+TEST(QueryIteratorTest, Phrase) {
+  indexing::CompressedPostingList simple;
+  simple.Add(0, {0});
+  simple.Add(1, {3});
+  simple.Add(2, {1, 5});
+  indexing::CompressedPostingList text;
+  text.Add(0, {1});
+  text.Add(1, {1});
+  text.Add(2, {6});
+
+  PhraseIterator itr({&simple, &text});
+  const std::vector<indexing::DocID> expected{0, 2};
+  EXPECT_EQ(Drain(itr), expected);
+}
+
+TEST(QueryIteratorTest, PositionMatcher) {
+  auto match = [](const std::vector<std::vector<uint32_t>>& positions,
+                  Proximity proximity) {
+    PositionMatcher matcher(positions.size(), proximity);
+    for (size_t i = 0; i < positions.size(); ++i) {
+      matcher.positions(i) = positions[i];
+    }
+    return matcher.Match();
+  };
+
+  EXPECT_TRUE(match({{0, 4}, {5}, {6}}, {}));
+  EXPECT_FALSE(match({{0, 4}, {5}, {7}}, {}));
+  EXPECT_TRUE(match({{0, 4}, {5}, {7}}, {.slop = 1}));
+  EXPECT_FALSE(match({{6}, {5}}, {.slop = 3}));
+  // The same word twice needs two positions
+  EXPECT_FALSE(match({{2}, {2}}, {}));
+  EXPECT_TRUE(match({{2, 3}, {2, 3}}, {}));
+
+  EXPECT_TRUE(match({{6}, {5}}, {.slop = 0, .ordered = false}));
+  EXPECT_TRUE(match({{1, 20}, {10, 21}, {8, 22}},
+                    {.slop = 2, .ordered = false}));
+  EXPECT_FALSE(match({{1, 20}, {10, 30}, {8, 25}},
+                     {.slop = 2, .ordered = false}));
+  EXPECT_FALSE(match({{1}, {}}, {.slop = 9, .ordered = false}));
+}
+
+TEST(QueryIteratorTest, PhraseWithSlop) {
+  indexing::CompressedPostingList simple;
+  simple.Add(0, {0});
+  simple.Add(1, {3});
+  simple.Add(2, {1, 5});
+  indexing::CompressedPostingList text;
+  text.Add(0, {2});
+  text.Add(1, {1});
+  text.Add(2, {8});
+
+  PhraseIterator ordered({&simple, &text}, {.slop = 1});
+  EXPECT_EQ(Drain(ordered), std::vector<indexing::DocID>{0});
+  PhraseIterator near({&simple, &text}, {.slop = 2, .ordered = false});
+  const std::vector<indexing::DocID> expected{0, 1, 2};
+  EXPECT_EQ(Drain(near), expected);
+}
@@ -1,41 +1,303 @@
 #include "engine/query/ranked_query.h"
 
 #include <algorithm>
+#include <cctype>
 #include <cmath>
+#include <limits>
+#include <numeric>
+#include <queue>
 
 #include "engine/indexing/compressed_posting_list.h"
 #include "engine/indexing/inverted_index.h"
+#include "engine/indexing/posting_cache.h"
 #include "engine/query/phrase_query.h"
 #include "linguistics/preprocessor.h"
 
+namespace {
+
+// Guards pruning against rounding in the precomputed upper bounds
+constexpr double kBoundSlack = 1.0 + 1e-9;
+
+double TfWeight(uint32_t tf) { return 1.0 + std::log(tf); }
+
+double BlockUpperBound(
+    const indexing::CompressedPostingList::BlockMax& block) {
+  return TfWeight(block.max_tf) / std::sqrt(block.min_doc_length);
+}
+
+struct TermCursor {
+  // Keeps the postings read by `itr` alive if they are cached
+  std::shared_ptr<const indexing::DecodedPostings> decoded;
+  indexing::CompressedPostingList::DocIterator itr;
+  // idf * query weight, scaled by the document norm at scoring time
+  double weight;
+  // Maximum contribution of the term to a normalized score
+  double upper_bound;
+};
+
+// Bounded min-heap keeping the best `limit` documents seen so far.
+class TopK {
+ public:
+  explicit TopK(size_t limit) : limit_(limit) {}
+
+  double Threshold() const {
+    if (heap_.size() < limit_) {
+      return -std::numeric_limits<double>::infinity();
+    }
+    return heap_.top().second;
+  }
+
+  void Push(indexing::DocID doc_id, double score) {
+    if (heap_.size() < limit_) {
+      heap_.emplace(doc_id, score);
+    } else if (IsBetter({doc_id, score}, heap_.top())) {
+      heap_.pop();
+      heap_.emplace(doc_id, score);
+    }
+  }
+
+  std::vector<indexing::DocID> Extract() {
+    std::vector<indexing::DocID> result(heap_.size());
+    for (auto itr = result.rbegin(); itr != result.rend(); ++itr) {
+      *itr = heap_.top().first;
+      heap_.pop();
+    }
+    return result;
+  }
+
+ private:
+  using ScoredDoc = std::pair<indexing::DocID, double>;
+
+  static bool IsBetter(const ScoredDoc& a, const ScoredDoc& b) {
+    if (a.second != b.second) {
+      return a.second > b.second;
+    }
+    return a.first < b.first;
+  }
+
+  struct WorseOnTop {
+    bool operator()(const ScoredDoc& a, const ScoredDoc& b) const {
+      return IsBetter(a, b);
+    }
+  };
+
+  size_t limit_;
+  std::priority_queue<ScoredDoc, std::vector<ScoredDoc>, WorseOnTop> heap_;
+};
+
+// Query term weighted with collection-wide statistics
+struct TermWeight {
+  const std::string* term;
+  // idf * query weight
+  double weight;
+};
+
+// WAND over one segment, the heap is shared by all segments of the index
+void RankSegment(const indexing::InvertedIndex& index,
+                 const std::vector<std::vector<std::string>>& phrases,
+                 const std::vector<query::Proximity>& proximities,
+                 const std::vector<TermWeight>& terms, double query_norm,
+                 indexing::PostingCache* cache, TopK& top) {
+  std::vector<indexing::CompressedPostingList> phrase_lists;
+  std::vector<const indexing::CompressedPostingList*> phrase_ptrs;
+  phrase_lists.reserve(phrases.size());
+  for (size_t i = 0; i < phrases.size(); ++i) {
+    phrase_lists.push_back(
+        query::ExecutePhraseQuery(phrases[i], index, proximities[i]));
+    phrase_ptrs.push_back(&phrase_lists.back());
+  }
+  const auto phrases_list =
+      indexing::CompressedPostingList::IntersectAll(phrase_ptrs);
+  if (!phrases.empty() && phrases_list.size() == 0) {
+    return;
+  }
+
+  std::vector<TermCursor> cursors;
+  for (const auto& [term, weight] : terms) {
+    const auto& posting_list = index.GetPostings(*term);
+    if (posting_list.size() == 0) {
+      continue;
+    }
+    auto decoded = cache ? cache->Get(index, *term) : nullptr;
+    auto itr = decoded ? indexing::CompressedPostingList::DocIterator(
+                             &posting_list, decoded.get())
+                       : posting_list.begin();
+    cursors.push_back({std::move(decoded), itr, weight,
+                       TfWeight(posting_list.max_tf()) * weight /
+                           std::sqrt(posting_list.min_doc_length()) /
+                           query_norm});
+  }
+
+  auto phrase_itr = phrases_list.begin();
+
+  // Cursor indices ordered by current document, exhausted cursors dropped
+  std::vector<size_t> order(cursors.size());
+  std::iota(order.begin(), order.end(), 0);
+
+  while (true) {
+    std::erase_if(order, [&](size_t i) { return cursors[i].itr.IsEnd(); });
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return cursors[a].itr.doc_id() < cursors[b].itr.doc_id();
+    });
+
+    // Pivot is the first document whose accumulated bound beats the heap
+    const double threshold = top.Threshold();
+    double bound = 0.0;
+    size_t pivot = 0;
+    for (; pivot < order.size(); ++pivot) {
+      bound += cursors[order[pivot]].upper_bound;
+      if (bound * kBoundSlack > threshold) {
+        break;
+      }
+    }
+    if (pivot == order.size()) {
+      break;
+    }
+
+    indexing::DocID target = cursors[order[pivot]].itr.doc_id();
+
+    // Block-max check over the blocks holding the pivot document. If they
+    // cannot beat the heap either, no document before the end of the
+    // shortest of those blocks can.
+    size_t last = pivot;
+    while (last + 1 < order.size() &&
+           cursors[order[last + 1]].itr.doc_id() == target) {
+      ++last;
+    }
+    double block_bound = 0.0;
+    uint64_t next_target = UINT32_MAX + 1ull;
+    for (size_t i = 0; i <= last; ++i) {
+      const auto& cursor = cursors[order[i]];
+      const auto block = cursor.itr.GetBlockMax(target);
+      block_bound += BlockUpperBound(block) * cursor.weight / query_norm;
+      next_target = std::min<uint64_t>(next_target, block.last_doc_id + 1ull);
+    }
+    if (block_bound * kBoundSlack <= threshold) {
+      if (last + 1 < order.size()) {
+        next_target = std::min<uint64_t>(next_target,
+                                         cursors[order[last + 1]].itr.doc_id());
+      } else if (next_target > UINT32_MAX) {
+        break;
+      }
+      for (size_t i = 0; i <= last; ++i) {
+        cursors[order[i]].itr.SkipTo(static_cast<indexing::DocID>(next_target));
+      }
+      continue;
+    }
+
+    if (!phrases.empty()) {
+      phrase_itr.SkipTo(target);
+      if (phrase_itr.IsEnd()) {
+        break;
+      }
+      target = phrase_itr.doc_id();
+    }
+
+    if (cursors[order.front()].itr.doc_id() != target) {
+      for (const auto i : order) {
+        if (cursors[i].itr.doc_id() >= target) {
+          break;
+        }
+        cursors[i].itr.SkipTo(target);
+      }
+      continue;
+    }
+
+    // Terms are summed in query order so scores do not depend on the pivot
+    double score = 0.0;
+    for (auto& cursor : cursors) {
+      if (!cursor.itr.IsEnd() && cursor.itr.doc_id() == target) {
+        score += TfWeight(cursor.itr->tf) * cursor.weight;
+        ++cursor.itr;
+      }
+    }
+
+    const double doc_length = index.GetDocLength(target);
+    if (doc_length == 0.0 || index.IsDeleted(target)) {
+      continue;
+    }
+    top.Push(target, score / (std::sqrt(doc_length) * query_norm));
+  }
+}
+
+}  // namespace
+
 namespace query {
 
 RankedQuery RankedQuery::Parse(const std::string& query,
                                const linguistics::Preprocessor& preprocessor) {
-  std::vector<std::string> raw_phrases;
+  // Words and `"..."` or `"..."~slop` phrases
+  std::vector<std::string> tokens;
+  std::string buffer;
   bool in_phrase = false;
   for (auto c : query) {
-    if (c == '"') {
-      if (!in_phrase) {
-        raw_phrases.emplace_back();
+    if (c == '"' || (!in_phrase && std::isspace(c))) {
+      if (in_phrase) {
+        tokens.push_back('"' + buffer + '"');
+      } else if (!buffer.empty()) {
+        tokens.push_back(buffer);
       }
-      in_phrase = !in_phrase;
+      buffer.clear();
+      in_phrase = c == '"' && !in_phrase;
+    } else {
+      buffer.push_back(c);
     }
-    if (in_phrase) {
-      raw_phrases.back().push_back(c);
+  }
+  if (in_phrase) {
+    tokens.push_back('"' + buffer + '"');
+  } else if (!buffer.empty()) {
+    tokens.push_back(buffer);
+  }
+  for (size_t i = 1; i < tokens.size(); ++i) {
+    if (tokens[i].front() == '~' && ParsePhraseToken(tokens[i - 1])) {
+      tokens[i - 1] += tokens[i];
+      tokens.erase(tokens.begin() + i);
     }
   }
+
+  // Every word is scored, NEAR operators and slops are not
+  std::string text;
   std::vector<std::vector<std::string>> phrases;
-  for (auto& phrase : raw_phrases) {
-    phrases.emplace_back(preprocessor.Preprocess(phrase));
+  std::vector<Proximity> proximities;
+  // Index of the last word of the latest NEAR group
+  size_t near_end = SIZE_MAX;
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    if (const auto phrase = ParsePhraseToken(tokens[i])) {
+      phrases.push_back(preprocessor.Preprocess(phrase->text));
+      proximities.push_back({.slop = phrase->slop});
+      text += ' ' + phrase->text;
+      continue;
+    }
+    const auto distance = ParseNearToken(tokens[i]);
+    if (!distance) {
+      text += ' ' + tokens[i];
+      continue;
+    }
+    // Operators without words on both sides are dropped
+    if (i == 0 || i + 1 == tokens.size() || ParsePhraseToken(tokens[i - 1]) ||
+        ParsePhraseToken(tokens[i + 1]) || ParseNearToken(tokens[i + 1])) {
+      continue;
+    }
+    const auto right = preprocessor.Preprocess(tokens[i + 1]);
+    if (near_end == i - 1 && proximities.back().slop == *distance) {
+      phrases.back().insert(phrases.back().end(), right.begin(), right.end());
+    } else {
+      phrases.push_back(preprocessor.Preprocess(tokens[i - 1]));
+      phrases.back().insert(phrases.back().end(), right.begin(), right.end());
+      proximities.push_back({.slop = *distance, .ordered = false});
+    }
+    near_end = i + 1;
   }
-  const auto terms = preprocessor.Preprocess(query);
-  return RankedQuery(std::move(terms), std::move(phrases));
+  const auto terms = preprocessor.Preprocess(text);
+  return RankedQuery(std::move(terms), std::move(phrases),
+                     std::move(proximities));
 }
 
 RankedQuery::RankedQuery(const std::vector<std::string>& terms,
-                         const std::vector<std::vector<std::string>>& phrases)
-    : phrases_(phrases) {
+                         const std::vector<std::vector<std::string>>& phrases,
+                         const std::vector<Proximity>& proximities /* = {} */)
+    : phrases_(phrases), proximities_(proximities) {
+  proximities_.resize(phrases_.size());
   for (const auto& term : terms) {
     ++query_tf_[term];
   }
@@ -49,39 +311,59 @@ std::vector<std::string> RankedQuery::terms() const {
   return result;
 }
 
+std::string RankedQuery::CacheKey() const {
+  std::vector<std::string> terms;
+  for (const auto& [term, tf] : query_tf_) {
+    terms.push_back(term + '^' + std::to_string(tf));
+  }
+  std::sort(terms.begin(), terms.end());
+  std::string result;
+  for (const auto& term : terms) {
+    result += term + ' ';
+  }
+  for (size_t i = 0; i < phrases_.size(); ++i) {
+    result += proximities_[i].ordered ? "\"" : "NEAR(";
+    for (const auto& term : phrases_[i]) {
+      result += term + ' ';
+    }
+    result += (proximities_[i].ordered ? "\"~" : ")/") +
+              std::to_string(proximities_[i].slop) + ' ';
+  }
+  return result;
+}
+
 std::vector<indexing::DocID> RankedQuery::Execute(
-    const indexing::InvertedIndex& index) {
-  std::unordered_map<indexing::DocID, double> doc_scores;
-  double query_norm = 0.0;
+    const indexing::InvertedIndex& index, size_t limit /* = SIZE_MAX */,
+    indexing::PostingCache* cache /* = nullptr */) const {
+  return Execute(std::vector<const indexing::InvertedIndex*>{&index}, limit,
+                 cache);
+}
 
-  indexing::CompressedPostingList phrases_list;
-  for (const auto& phrase : phrases_) {
-    auto list = query::ExecutePhraseQuery(phrase, index);
-    if (phrases_list.size() == 0) {
-      phrases_list = std::move(list);
-    } else {
-      phrases_list = phrases_list & list;
-    }
+std::vector<indexing::DocID> RankedQuery::Execute(
+    const std::vector<const indexing::InvertedIndex*>& segments,
+    size_t limit /* = SIZE_MAX */,
+    indexing::PostingCache* cache /* = nullptr */) const {
+  if (limit == 0) {
+    return {};
+  }
+
+  size_t docs_count = 0;
+  for (const auto* segment : segments) {
+    docs_count = std::max(docs_count, segment->GetDocsCount());
   }
 
+  std::vector<TermWeight> terms;
+  double query_norm = 0.0;
   for (const auto& [term, tf] : query_tf_) {
-    auto posting_list = index.GetPostings(std::string(term));
-    if (!phrases_.empty()) {
-      posting_list = posting_list & phrases_list;
+    size_t doc_freq = 0;
+    for (const auto* segment : segments) {
+      doc_freq += segment->GetPostings(term).size();
     }
-    const double idf =
-        std::log((1.0 + index.GetDocsCount()) / (1.0 + posting_list.size())) +
-        1.0;
+    const double idf = std::log((1.0 + docs_count) / (1.0 + doc_freq)) + 1.0;
     const double query_tf_weight = 1.0 + std::log(tf);
     const double query_weight = query_tf_weight * idf;
     query_norm += query_weight * query_weight;
-
-    for (const auto& posting : posting_list) {
-      const double doc_tf_weight = 1.0 + std::log(posting.tf);
-      const double doc_weight = doc_tf_weight * idf;
-
-      doc_scores[posting.doc_id] += doc_weight * query_weight;
-    }
+    terms.push_back({&term, idf * query_weight});
   }
 
   query_norm = std::sqrt(query_norm);
@@ -89,33 +371,12 @@ std::vector<indexing::DocID> RankedQuery::Execute(
     return {};
   }
 
-  std::vector<std::pair<indexing::DocID, double>> ranked;
-  ranked.reserve(doc_scores.size());
-
-  for (const auto& [doc_id, score] : doc_scores) {
-    const double doc_length = index.GetDocLength(doc_id);
-    if (doc_length == 0.0) {
-      continue;
-    }
-    const double doc_norm = std::sqrt(doc_length);
-    const double normalized_score = score / (doc_norm * query_norm);
-
-    ranked.emplace_back(doc_id, normalized_score);
+  TopK top(limit);
+  for (const auto* segment : segments) {
+    RankSegment(*segment, phrases_, proximities_, terms, query_norm, cache,
+                top);
   }
-
-  std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {
-    if (a.second != b.second) {
-      return a.second > b.second;
-    }
-    return a.first < b.first;
-  });
-
-  std::vector<indexing::DocID> result;
-  result.reserve(ranked.size());
-  for (const auto& [doc_id, _] : ranked) {
-    result.push_back(doc_id);
-  }
-  return result;
+  return top.Extract();
 }
 
 }  // namespace query
@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "engine/indexing/types.h"
+#include "engine/query/ast.h"
 #include "utils/hash_table.h"
 
 namespace linguistics {
@@ -12,6 +13,7 @@ class Preprocessor;
 }
 namespace indexing {
 class InvertedIndex;
+class PostingCache;
 }  // namespace indexing
 
 namespace query {
@@ -21,15 +23,29 @@ class RankedQuery {
   static RankedQuery Parse(const std::string& query,
                            const linguistics::Preprocessor& preprocessor);
 
+  // Phrases without a proximity are matched exactly
   explicit RankedQuery(const std::vector<std::string>& terms,
-                       const std::vector<std::vector<std::string>>& phrases);
+                       const std::vector<std::vector<std::string>>& phrases,
+                       const std::vector<Proximity>& proximities = {});
 
   std::vector<std::string> terms() const;
-
-  std::vector<indexing::DocID> Execute(const indexing::InvertedIndex& index);
+  // Equal for queries with the same preprocessed terms and phrases
+  std::string CacheKey() const;
+
+  // Terms whose lists are in `cache` are scored from their decoded postings
+  std::vector<indexing::DocID> Execute(
+      const indexing::InvertedIndex& index, size_t limit = SIZE_MAX,
+      indexing::PostingCache* cache = nullptr) const;
+  // Ranks the documents of all segments together, scored with statistics
+  // of the whole collection
+  std::vector<indexing::DocID> Execute(
+      const std::vector<const indexing::InvertedIndex*>& segments,
+      size_t limit = SIZE_MAX,
+      indexing::PostingCache* cache = nullptr) const;
 
  private:
   std::vector<std::vector<std::string>> phrases_;
+  std::vector<Proximity> proximities_;
   utils::HashTable<uint32_t> query_tf_;
 };
 
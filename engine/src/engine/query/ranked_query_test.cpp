@@ -3,6 +3,7 @@
 #include <gtest/gtest.h>
 
 #include "engine/indexing/inverted_index.h"
+#include "engine/indexing/posting_cache.h"
 #include "engine/indexing/posting_list.h"
 #include "linguistics/lemmatization/mock_lemmatizer.h"
 #include "linguistics/preprocessor.h"
@@ -77,4 +78,76 @@ TEST_F(RankedQueryTest, PhraseQuery) {
   const auto results = q.Execute(index);
   const std::vector<indexing::DocID> expected{1};
   EXPECT_EQ(results, expected);
-}
\ No newline at end of file
+}
+
+TEST_F(RankedQueryTest, ProximityQuery) {
+  auto q = RankedQuery::Parse("\"simple text\"~1", preprocessor);
+  std::vector<indexing::DocID> expected{0, 2};
+  EXPECT_EQ(q.Execute(index), expected);
+
+  q = RankedQuery::Parse("hello NEAR/0 simple", preprocessor);
+  expected = {4};
+  EXPECT_EQ(q.Execute(index), expected);
+}
+
+TEST_F(RankedQueryTest, LimitReturnsBestDocuments) {
+  auto q = RankedQuery::Parse("simple text", preprocessor);
+  const auto all = q.Execute(index);
+  for (size_t limit = 0; limit <= all.size() + 1; ++limit) {
+    const auto results = q.Execute(index, limit);
+    const std::vector<indexing::DocID> expected(
+        all.begin(), all.begin() + std::min(limit, all.size()));
+    EXPECT_EQ(results, expected);
+  }
+}
+
+TEST_F(RankedQueryTest, SegmentsRankLikeSingleIndex) {
+  const std::vector<std::vector<std::string>> docs{
+      {"simple", "text"},
+      {"very", "complex", "text"},
+      {"another", "simple", "text"},
+      {"hello", "world"},
+      {"simple", "hello", "world"},
+  };
+  indexing::InvertedIndex first;
+  indexing::InvertedIndex second;
+  for (indexing::DocID i = 0; i < docs.size(); ++i) {
+    (i % 2 == 0 ? first : second).AddDocument(i, docs[i]);
+  }
+
+  for (const auto* text : {"simple text", "hello simple", "\"simple text\""}) {
+    auto q = RankedQuery::Parse(text, preprocessor);
+    EXPECT_EQ(q.Execute({&first, &second}), q.Execute(index));
+    EXPECT_EQ(q.Execute({&second, &first}, 2), q.Execute(index, 2));
+  }
+}
+
+TEST_F(RankedQueryTest, DeletedDocuments) {
+  index.Delete(0);
+
+  auto q = RankedQuery::Parse("simple", preprocessor);
+  std::vector<indexing::DocID> expected{2, 4};
+  EXPECT_EQ(q.Execute(index), expected);
+
+  q = RankedQuery::Parse("\"simple text\"", preprocessor);
+  expected = {2};
+  EXPECT_EQ(q.Execute(index), expected);
+}
+
+TEST_F(RankedQueryTest, CacheKey) {
+  const auto key = RankedQuery::Parse("simple text", preprocessor).CacheKey();
+  EXPECT_EQ(RankedQuery::Parse("text  simple", preprocessor).CacheKey(), key);
+  EXPECT_NE(RankedQuery::Parse("\"simple text\"", preprocessor).CacheKey(),
+            key);
+  EXPECT_NE(RankedQuery::Parse("simple text text", preprocessor).CacheKey(),
+            key);
+}
+
+TEST_F(RankedQueryTest, PostingCache) {
+  indexing::PostingCache cache({.admit_after = 1, .min_list_size = 1});
+  auto q = RankedQuery::Parse("simple hello text", preprocessor);
+  const auto expected = q.Execute(index);
+  EXPECT_EQ(q.Execute(index, SIZE_MAX, &cache), expected);
+  EXPECT_EQ(q.Execute(index, 2, &cache), q.Execute(index, 2));
+  EXPECT_GT(cache.stats().hits, 0);
+}
@@ -17,7 +17,12 @@ Preprocessor::Preprocessor(std::unique_ptr<Tokenizer>&& tokenizer,
 
 std::vector<std::string> Preprocessor::Preprocess(
     const std::string& text) const {
-  auto result = tokenizer_->Tokenize(text);
+  return Preprocess(text, nullptr);
+}
+
+std::vector<std::string> Preprocessor::Preprocess(
+    const std::string& text, std::vector<TokenSpan>* spans) const {
+  auto result = tokenizer_->Tokenize(text, spans);
   for (auto& word : result) {
     word = lemmatizer_->Lemmatize(word);
   }
@@ -13,6 +13,9 @@ class Preprocessor {
                std::unique_ptr<Lemmatizer>&& lemmatizer);
 
   std::vector<std::string> Preprocess(const std::string& text) const;
+  // Also fills `spans` with the byte range of every term in the text
+  std::vector<std::string> Preprocess(const std::string& text,
+                                      std::vector<TokenSpan>* spans) const;
 
   std::vector<std::string> Tokenize(const std::string& text) const;
   std::string Lemmatize(const std::string& word) const;
@@ -1,13 +1,25 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
 namespace linguistics {
 
+// Byte range of a token in the tokenized text
+struct TokenSpan {
+  uint32_t begin;
+  uint32_t end;
+
+  bool operator==(const TokenSpan&) const = default;
+};
+
 class Tokenizer {
  public:
   virtual std::vector<std::string> Tokenize(const std::string& text) const = 0;
+  // Also fills `spans` with the byte range of every token
+  virtual std::vector<std::string> Tokenize(
+      const std::string& text, std::vector<TokenSpan>* spans) const = 0;
 };
 
 };  // namespace linguistics
\ No newline at end of file
@@ -1,20 +1,15 @@
 #pragma once
 
-#include <memory>
-
-#include "linguistics/tokenization/rules/token_rule.h"
 #include "linguistics/tokenization/tokenizer.h"
 
 namespace linguistics {
 
+// Words, numbers and abbreviations of UTF-8 text, see Utf8Scanner
 class TokenizerImpl : public Tokenizer {
  public:
-  TokenizerImpl();
-
   std::vector<std::string> Tokenize(const std::string& text) const override;
-
- private:
-  std::vector<std::unique_ptr<TokenRule>> rules_;
+  std::vector<std::string> Tokenize(
+      const std::string& text, std::vector<TokenSpan>* spans) const override;
 };
 
 }  // namespace linguistics
@@ -76,3 +76,19 @@ TEST_F(TokenizerTest, Abbreviation) {
   const std::vector<std::string> expected{"USA", "USA", "СССР", "СССР"};
   EXPECT_EQ(res, expected);
 }
+
+TEST_F(TokenizerTest, Spans) {
+  const std::string text = "Ёжик, U.S.A. и 42 ёлки";
+  std::vector<TokenSpan> spans;
+  const auto res = tokenizer.Tokenize(text, &spans);
+  ASSERT_EQ(spans.size(), res.size());
+
+  std::vector<std::string> words;
+  for (const auto& span : spans) {
+    words.push_back(text.substr(span.begin, span.end - span.begin));
+  }
+  const std::vector<std::string> expected{"Ёжик", "U.S.A.", "и", "42",
+                                          "ёлки"};
+  EXPECT_EQ(words, expected);
+  EXPECT_EQ(tokenizer.Tokenize(text), res);
+}
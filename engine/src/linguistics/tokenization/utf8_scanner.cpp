@@ -0,0 +1,164 @@
+#include "linguistics/tokenization/utf8_scanner.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace {
+
+enum CharFlags : uint8_t {
+  kLetter = 1 << 0,
+  kUpper = 1 << 1,
+  kDigit = 1 << 2,
+  // Allowed in words besides letters and digits
+  kWordSymbol = 1 << 3,
+};
+
+struct CharClass {
+  uint8_t flags;
+  // In bytes
+  uint8_t size;
+};
+
+constexpr auto kAsciiFlags = [] {
+  std::array<uint8_t, 128> table{};
+  for (int c = 'a'; c <= 'z'; ++c) {
+    table[c] = kLetter;
+  }
+  for (int c = 'A'; c <= 'Z'; ++c) {
+    table[c] = kLetter | kUpper;
+  }
+  for (int c = '0'; c <= '9'; ++c) {
+    table[c] = kDigit;
+  }
+  for (const char c : {'\'', '-', '+', '#'}) {
+    table[c] = kWordSymbol;
+  }
+  return table;
+}();
+
+// Two-byte characters with the lead byte 0xD0 or 0xD1, by the low bits of
+// the continuation byte
+constexpr auto kCyrillicFlags = [] {
+  std::array<std::array<uint8_t, 64>, 2> table{};
+  // Ё is 0xD0 0x81, А-Я are 0xD0 0x90-0xAF, а-п are 0xD0 0xB0-0xBF
+  table[0][0x01] = kLetter | kUpper;
+  for (int c = 0x10; c <= 0x2f; ++c) {
+    table[0][c] = kLetter | kUpper;
+  }
+  for (int c = 0x30; c <= 0x3f; ++c) {
+    table[0][c] = kLetter;
+  }
+  // р-я are 0xD1 0x80-0x8F, ё is 0xD1 0x91
+  for (int c = 0x00; c <= 0x0f; ++c) {
+    table[1][c] = kLetter;
+  }
+  table[1][0x11] = kLetter;
+  return table;
+}();
+
+CharClass Classify(std::string_view text, size_t pos) {
+  const auto c = static_cast<uint8_t>(text[pos]);
+  if (c < 0x80) {
+    return {kAsciiFlags[c], 1};
+  }
+  if ((c == 0xd0 || c == 0xd1) && pos + 1 < text.size()) {
+    const auto next = static_cast<uint8_t>(text[pos + 1]);
+    if ((next & 0xc0) == 0x80) {
+      return {kCyrillicFlags[c - 0xd0][next & 0x3f], 2};
+    }
+  }
+  // Bytes of other characters separate tokens one by one
+  return {0, 1};
+}
+
+bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+}  // namespace
+
+namespace linguistics {
+
+std::optional<RawToken> Utf8Scanner::Next() {
+  while (pos_ < text_.size()) {
+    const auto current = Classify(text_, pos_);
+    const size_t next = pos_ + current.size;
+    if ((current.flags & kUpper) && next < text_.size() &&
+        text_[next] == '.') {
+      return ScanAbbreviation();
+    }
+    if (current.flags & kDigit) {
+      return ScanNumber();
+    }
+    if (current.flags & kLetter) {
+      return ScanWord();
+    }
+    pos_ = next;
+  }
+  return std::nullopt;
+}
+
+RawToken Utf8Scanner::ScanWord() {
+  const size_t begin = pos_;
+  bool after_letter = false;
+  while (pos_ < text_.size()) {
+    const auto current = Classify(text_, pos_);
+    if (current.flags & (kLetter | kDigit | kWordSymbol)) {
+      after_letter = current.flags & kLetter;
+      pos_ += current.size;
+      continue;
+    }
+    // A dot is kept only between letters, like in "e.g"
+    if (text_[pos_] == '.' && after_letter && pos_ + 1 < text_.size() &&
+        (Classify(text_, pos_ + 1).flags & kLetter)) {
+      after_letter = false;
+      ++pos_;
+      continue;
+    }
+    break;
+  }
+  return {text_.substr(begin, pos_ - begin), RawToken::Kind::kWord};
+}
+
+RawToken Utf8Scanner::ScanNumber() {
+  const size_t begin = pos_;
+  while (pos_ < text_.size()) {
+    const char c = text_[pos_];
+    if (IsDigit(c) || ((c == '.' || c == ',') && pos_ + 1 < text_.size() &&
+                       IsDigit(text_[pos_ + 1]))) {
+      ++pos_;
+    } else {
+      break;
+    }
+  }
+  return {text_.substr(begin, pos_ - begin), RawToken::Kind::kNumber};
+}
+
+RawToken Utf8Scanner::ScanAbbreviation() {
+  const size_t begin = pos_;
+  while (pos_ < text_.size()) {
+    const auto current = Classify(text_, pos_);
+    if (!(current.flags & kUpper) && text_[pos_] != '.') {
+      break;
+    }
+    pos_ += current.size;
+  }
+  return {text_.substr(begin, pos_ - begin), RawToken::Kind::kAbbreviation};
+}
+
+std::string Normalize(const RawToken& token) {
+  std::string result(token.text);
+  switch (token.kind) {
+    case RawToken::Kind::kWord:
+      break;
+    case RawToken::Kind::kNumber:
+      std::replace(result.begin(), result.end(), ',', '.');
+      break;
+    case RawToken::Kind::kAbbreviation:
+      result.erase(std::remove(result.begin(), result.end(), '.'),
+                   result.end());
+      break;
+  }
+  return result;
+}
+
+}  // namespace linguistics
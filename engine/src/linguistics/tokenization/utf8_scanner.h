@@ -0,0 +1,45 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace linguistics {
+
+struct RawToken {
+  enum class Kind {
+    kWord,
+    // Digits with decimal points or commas
+    kNumber,
+    // Capitals with dots, like "U.S.A."
+    kAbbreviation,
+  };
+
+  // View into the scanned text
+  std::string_view text;
+  Kind kind;
+};
+
+// Splits UTF-8 text into words of Latin and Cyrillic letters, numbers and
+// abbreviations, classifying characters by lookup tables without decoding
+// the text. Other characters and invalid bytes separate the tokens.
+class Utf8Scanner {
+ public:
+  explicit Utf8Scanner(std::string_view text) : text_(text) {}
+
+  std::optional<RawToken> Next();
+
+ private:
+  RawToken ScanWord();
+  RawToken ScanNumber();
+  RawToken ScanAbbreviation();
+
+  std::string_view text_;
+  size_t pos_ = 0;
+};
+
+// The token as the tokenizer returns it: decimal commas of numbers become
+// dots and abbreviations lose their dots
+std::string Normalize(const RawToken& token);
+
+}  // namespace linguistics
@@ -0,0 +1,75 @@
+#include "linguistics/tokenization/utf8_scanner.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace linguistics;
+
+namespace {
+
+std::vector<RawToken> Scan(std::string_view text) {
+  std::vector<RawToken> tokens;
+  Utf8Scanner scanner(text);
+  while (const auto token = scanner.Next()) {
+    tokens.push_back(*token);
+  }
+  return tokens;
+}
+
+std::vector<std::string> Normalized(std::string_view text) {
+  std::vector<std::string> tokens;
+  for (const auto& token : Scan(text)) {
+    tokens.push_back(Normalize(token));
+  }
+  return tokens;
+}
+
+}  // namespace
+
+TEST(Utf8ScannerTest, TokensAreViewsIntoText) {
+  const std::string text = "Ёлка 3,14 и С.С.С.Р.";
+  const auto tokens = Scan(text);
+  ASSERT_EQ(tokens.size(), 4);
+
+  EXPECT_EQ(tokens[0].text, "Ёлка");
+  EXPECT_EQ(tokens[0].kind, RawToken::Kind::kWord);
+  EXPECT_EQ(tokens[0].text.data(), text.data());
+  EXPECT_EQ(tokens[1].text, "3,14");
+  EXPECT_EQ(tokens[1].kind, RawToken::Kind::kNumber);
+  EXPECT_EQ(tokens[2].text, "и");
+  EXPECT_EQ(tokens[3].text, "С.С.С.Р.");
+  EXPECT_EQ(tokens[3].kind, RawToken::Kind::kAbbreviation);
+  EXPECT_EQ(tokens[3].text.data() + tokens[3].text.size(),
+            text.data() + text.size());
+
+  EXPECT_EQ(Normalize(tokens[1]), "3.14");
+  EXPECT_EQ(Normalize(tokens[3]), "СССР");
+}
+
+TEST(Utf8ScannerTest, DotsInWords) {
+  const std::vector<std::string> expected{"e.g", "node.js", "end", "a",
+                                          "b"};
+  EXPECT_EQ(Normalized("e.g. node.js end. a..b"), expected);
+}
+
+TEST(Utf8ScannerTest, Numbers) {
+  // Every point followed by a digit stays in the number
+  const std::vector<std::string> expected{"1.2.3", "4", "5", "x2"};
+  EXPECT_EQ(Normalized("1.2,3 4. -5 x2"), expected);
+}
+
+TEST(Utf8ScannerTest, Abbreviations) {
+  // An abbreviation takes the capitals that follow it
+  const std::vector<std::string> expected{"ABC", "def", "A", "B"};
+  EXPECT_EQ(Normalized("A.B.Cdef A B"), expected);
+}
+
+TEST(Utf8ScannerTest, OtherCharactersSeparateTokens) {
+  // Em dash, Ukrainian Є, an emoji and invalid bytes
+  const std::vector<std::string> expected{"слово", "word", "ab", "cd", "ef"};
+  EXPECT_EQ(Normalized("слово—word Єab\xF0\x9F\x98\x80"
+                       "cd\xD0\xFF"
+                       "ef\xD1"),
+            expected);
+}
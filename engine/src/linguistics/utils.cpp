@@ -72,14 +72,4 @@ std::string ToLower(const std::string& input) {
   return result;
 }
 
-bool IsLetter(char16_t c) {
-  return (c >= u'A' && c <= u'Z') || (c >= u'a' && c <= u'z') ||
-         (c >= u'А' && c <= u'Я') || (c >= u'а' && c <= u'я') || c == u'Ё' ||
-         c == u'ё';
-}
-
-bool IsUpper(char16_t c) {
-  return (c >= u'A' && c <= u'Z') || (c >= u'А' && c <= u'Я') || c == u'Ё';
-}
-
 }  // namespace linguistics
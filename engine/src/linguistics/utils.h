@@ -10,8 +10,4 @@ void NormalizeYo(std::string& text);
 
 std::string ToLower(const std::string& text);
 
-bool IsLetter(char16_t c);
-
-bool IsUpper(char16_t c);
-
 }  // namespace linguistics
@@ -1,8 +1,14 @@
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <locale>
+#include <optional>
 #include <set>
+#include <sstream>
+#include <thread>
 
 #include "engine/engine.h"
+#include "server/query_server.h"
 #include "storage/document.h"
 
 std::set<std::string> ParseArgs(int argc, char** argv) {
@@ -13,24 +19,119 @@ std::set<std::string> ParseArgs(int argc, char** argv) {
   return args;
 }
 
+// Value of a `--name=value` argument
+std::optional<std::string> GetOption(const std::set<std::string>& args,
+                                     const std::string& name) {
+  const auto prefix = name + "=";
+  for (const auto& arg : args) {
+    if (arg.starts_with(prefix)) {
+      return arg.substr(prefix.size());
+    }
+  }
+  return std::nullopt;
+}
+
+// Answers "ranked|boolean <limit> <query>" with a "<url>\t<snippet>" line
+// per result
+std::string HandleRequest(const Engine& engine, const std::string& request) {
+  std::istringstream stream(request);
+  std::string mode;
+  size_t limit = 0;
+  if (!(stream >> mode >> limit) ||
+      (mode != "ranked" && mode != "boolean")) {
+    throw std::invalid_argument("expected ranked|boolean <limit> <query>");
+  }
+  std::string query;
+  std::getline(stream >> std::ws, query);
+
+  const auto results = mode == "ranked" ? engine.SearchRanked(query, limit)
+                                        : engine.SearchBoolean(query, limit);
+  std::string response;
+  for (const auto& res : results) {
+    auto snippet = res.snippet;
+    std::replace_if(
+        snippet.begin(), snippet.end(),
+        [](char c) { return c == '\n' || c == '\t'; }, ' ');
+    response += res.doc.url + '\t' + snippet + '\n';
+  }
+  return response;
+}
+
 int main(int argc, char** argv) {
   std::locale::global(std::locale("ru_RU.UTF-8"));
 
   const auto args = ParseArgs(argc, argv);
   const bool use_boolean = args.contains("--boolean");
   const bool build_index = args.contains("--build");
+  const bool explain = args.contains("--explain");
+  const auto threads = GetOption(args, "--threads");
+  // In megabytes, the index is built in memory when not set
+  const auto memory_budget = GetOption(args, "--memory-budget");
+  // In seconds, new documents are indexed into segments in the background
+  const auto update_interval = GetOption(args, "--update-interval");
+  // Encoding of the built index, "vbyte" or "bitpacking"
+  const auto codec = GetOption(args, "--codec");
+  // Number of distinct queries whose results are cached
+  const auto cache_size = GetOption(args, "--cache-size");
+  // In megabytes, decoded posting lists of hot terms are kept within it
+  const auto posting_cache = GetOption(args, "--posting-cache");
+  // Unix socket to serve queries on, with `--threads` workers
+  const auto serve = GetOption(args, "--serve");
+  // Local document file, written by --build and read instead of MongoDB
+  // otherwise
+  const auto doc_file = GetOption(args, "--doc-file");
 
-  auto engine = CreateEngine();
+  auto engine = CreateEngine(codec == "bitpacking"
+                                 ? indexing::CodecType::kBitPacking
+                                 : indexing::CodecType::kVByte,
+                             cache_size ? std::stoul(*cache_size) : 4096,
+                             posting_cache ? std::stoul(*posting_cache) << 20
+                                           : 64 << 20,
+                             build_index ? "" : doc_file.value_or(""));
   if (build_index) {
-    engine.BuildIndex();
+    engine.BuildIndex(
+        threads ? std::stoul(*threads) : std::thread::hardware_concurrency(),
+        memory_budget ? std::stoul(*memory_budget) << 20 : 0,
+        doc_file.value_or(""));
   } else {
     engine.LoadIndex();
   }
+
+  std::jthread updater;
+  if (update_interval) {
+    const std::chrono::seconds interval(std::stoul(*update_interval));
+    updater = std::jthread([&engine, interval](std::stop_token stop) {
+      while (!stop.stop_requested()) {
+        try {
+          engine.Update();
+        } catch (const std::exception& e) {
+          std::cerr << "Update failed: " << e.what() << std::endl;
+        }
+        std::this_thread::sleep_for(interval);
+      }
+    });
+  }
+
+  if (serve) {
+    server::QueryServer server(
+        *serve,
+        threads ? std::stoul(*threads) : std::thread::hardware_concurrency(),
+        [&engine](const std::string& request) {
+          return HandleRequest(engine, request);
+        });
+    server.Start();
+    server.Wait();
+    return 0;
+  }
+
   while (true) {
     std::string query;
     std::cout << "\033[1;35mSearch:\033[m " << std::flush;
     std::getline(std::cin, query);
     if (use_boolean) {
+      if (explain) {
+        std::cout << engine.ExplainBoolean(query);
+      }
       for (const auto& res : engine.SearchBoolean(query, 10)) {
         std::cout << "\033[4;36m" << res.doc.url << "\033[m" << std::endl;
         std::cout << res.snippet << std::endl;
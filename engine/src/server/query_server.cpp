@@ -0,0 +1,186 @@
+#include "server/query_server.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+constexpr int kBacklog = 128;
+constexpr size_t kReadSize = 4096;
+
+std::runtime_error SystemError(const std::string& what) {
+  return std::runtime_error("QueryServer: " + what + ": " +
+                            std::strerror(errno));
+}
+
+bool SendAll(int fd, const std::string& data) {
+  for (size_t sent = 0; sent < data.size();) {
+    const auto count =
+        send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      return false;
+    }
+    sent += count;
+  }
+  return true;
+}
+
+}  // namespace
+
+namespace server {
+
+QueryServer::QueryServer(const std::filesystem::path& socket_path,
+                         size_t threads, Handler handler)
+    : socket_path_(socket_path),
+      threads_(std::max(threads, 1ul)),
+      handler_(std::move(handler)),
+      connections_(threads_ * 4) {}
+
+QueryServer::~QueryServer() {
+  Stop();
+  Wait();
+}
+
+void QueryServer::Start() {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  const auto path = socket_path_.string();
+  if (path.size() >= sizeof(address.sun_path)) {
+    throw std::runtime_error("QueryServer: socket path is too long: " + path);
+  }
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+  listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listen_fd_ < 0) {
+    throw SystemError("socket");
+  }
+  std::filesystem::remove(socket_path_);
+  if (bind(listen_fd_, reinterpret_cast<const sockaddr*>(&address),
+           sizeof(address)) < 0 ||
+      listen(listen_fd_, kBacklog) < 0) {
+    const auto error = SystemError("bind " + path);
+    close(listen_fd_);
+    listen_fd_ = -1;
+    throw error;
+  }
+
+  acceptor_ = std::thread([this] { AcceptLoop(); });
+  for (size_t i = 0; i < threads_; ++i) {
+    workers_.emplace_back([this] { WorkerLoop(); });
+  }
+}
+
+void QueryServer::Stop() {
+  std::lock_guard lock(mutex_);
+  if (stopped_) {
+    return;
+  }
+  stopped_ = true;
+  if (listen_fd_ >= 0) {
+    shutdown(listen_fd_, SHUT_RDWR);
+  }
+  for (const int connection : active_) {
+    shutdown(connection, SHUT_RDWR);
+  }
+}
+
+void QueryServer::Wait() {
+  if (acceptor_.joinable()) {
+    acceptor_.join();
+  }
+  for (auto& worker : workers_) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+  if (listen_fd_ >= 0) {
+    close(listen_fd_);
+    listen_fd_ = -1;
+    std::filesystem::remove(socket_path_);
+  }
+}
+
+void QueryServer::AcceptLoop() {
+  while (true) {
+    const int connection = accept(listen_fd_, nullptr, nullptr);
+    if (connection >= 0) {
+      if (!connections_.Push(connection)) {
+        close(connection);
+      }
+      continue;
+    }
+    const int error = errno;
+    std::lock_guard lock(mutex_);
+    if (stopped_ || (error != EINTR && error != ECONNABORTED)) {
+      break;
+    }
+  }
+  connections_.Close();
+}
+
+void QueryServer::WorkerLoop() {
+  while (const auto connection = connections_.Pop()) {
+    {
+      std::lock_guard lock(mutex_);
+      if (stopped_) {
+        close(*connection);
+        continue;
+      }
+      active_.insert(*connection);
+    }
+    Serve(*connection);
+    {
+      std::lock_guard lock(mutex_);
+      active_.erase(*connection);
+    }
+    close(*connection);
+  }
+}
+
+void QueryServer::Serve(int connection) {
+  std::string buffer;
+  char chunk[kReadSize];
+  while (true) {
+    const auto count = recv(connection, chunk, sizeof(chunk), 0);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      return;
+    }
+    buffer.append(chunk, count);
+
+    size_t start = 0;
+    for (size_t end = buffer.find('\n'); end != std::string::npos;
+         end = buffer.find('\n', start)) {
+      auto request = buffer.substr(start, end - start);
+      if (!request.empty() && request.back() == '\r') {
+        request.pop_back();
+      }
+      start = end + 1;
+      if (!SendAll(connection, Handle(request) + '\n')) {
+        return;
+      }
+    }
+    buffer.erase(0, start);
+  }
+}
+
+std::string QueryServer::Handle(const std::string& request) const {
+  try {
+    return handler_(request);
+  } catch (const std::exception& e) {
+    return std::string("error: ") + e.what() + '\n';
+  }
+}
+
+}  // namespace server
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "utils/blocking_queue.h"
+
+namespace server {
+
+// Line protocol over a Unix domain socket. Every request line is answered
+// with the lines returned by the handler followed by an empty line, a
+// failed request with a single "error: ..." line. Connections are served
+// by a fixed pool of workers, each serving one connection at a time, so a
+// client opens a connection per concurrent stream of requests.
+class QueryServer {
+ public:
+  // Called from the workers concurrently, the response lines end with '\n'
+  using Handler = std::function<std::string(const std::string& request)>;
+
+  QueryServer(const std::filesystem::path& socket_path, size_t threads,
+              Handler handler);
+  ~QueryServer();
+
+  QueryServer(const QueryServer&) = delete;
+  QueryServer& operator=(const QueryServer&) = delete;
+
+  // Binds the socket, replacing a stale one, and starts accepting
+  void Start();
+  // Closes the socket and all connections, then waits for the workers
+  void Stop();
+  // Blocks until the server is stopped
+  void Wait();
+
+ private:
+  void AcceptLoop();
+  void WorkerLoop();
+  void Serve(int connection);
+  std::string Handle(const std::string& request) const;
+
+  const std::filesystem::path socket_path_;
+  const size_t threads_;
+  const Handler handler_;
+
+  int listen_fd_ = -1;
+  utils::BlockingQueue<int> connections_;
+  std::thread acceptor_;
+  std::vector<std::thread> workers_;
+
+  // Connections being served, shut down on Stop to wake their workers
+  std::mutex mutex_;
+  std::unordered_set<int> active_;
+  bool stopped_ = false;
+};
+
+}  // namespace server
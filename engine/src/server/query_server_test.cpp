@@ -0,0 +1,124 @@
+#include "server/query_server.h"
+
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+using server::QueryServer;
+
+namespace {
+
+std::filesystem::path SocketPath() {
+  return std::filesystem::temp_directory_path() /
+         ("query-server-test-" + std::to_string(getpid()) + ".sock");
+}
+
+class Client {
+ public:
+  explicit Client(const std::filesystem::path& path)
+      : fd_(socket(AF_UNIX, SOCK_STREAM, 0)) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, path.c_str());
+    if (connect(fd_, reinterpret_cast<const sockaddr*>(&address),
+                sizeof(address)) < 0) {
+      throw std::runtime_error("connect failed");
+    }
+  }
+  ~Client() { close(fd_); }
+
+  void Send(const std::string& data) {
+    ASSERT_EQ(send(fd_, data.data(), data.size(), 0), data.size());
+  }
+
+  // Lines up to the empty line ending a response
+  std::string Receive() {
+    while (true) {
+      const auto end = buffer_.find("\n\n");
+      if (end != std::string::npos) {
+        auto response = buffer_.substr(0, end + 1);
+        buffer_.erase(0, end + 2);
+        return response;
+      }
+      char chunk[256];
+      const auto count = recv(fd_, chunk, sizeof(chunk), 0);
+      if (count <= 0) {
+        return "";
+      }
+      buffer_.append(chunk, count);
+    }
+  }
+
+ private:
+  int fd_;
+  std::string buffer_;
+};
+
+}  // namespace
+
+TEST(QueryServerTest, AnswersRequests) {
+  QueryServer server(SocketPath(), 2, [](const std::string& request) {
+    if (request == "fail") {
+      throw std::runtime_error("bad request");
+    }
+    return request + "\n" + request + "\n";
+  });
+  server.Start();
+
+  Client client(SocketPath());
+  client.Send("first\nsec");
+  EXPECT_EQ(client.Receive(), "first\nfirst\n");
+  client.Send("ond\r\nfail\n");
+  EXPECT_EQ(client.Receive(), "second\nsecond\n");
+  EXPECT_EQ(client.Receive(), "error: bad request\n");
+}
+
+TEST(QueryServerTest, ServesConnectionsConcurrently) {
+  constexpr int kClients = 4;
+  std::atomic<int> running = 0;
+  std::atomic<int> max_running = 0;
+  QueryServer server(SocketPath(), kClients, [&](const std::string& request) {
+    const int now = ++running;
+    for (int seen = max_running; seen < now;) {
+      max_running.compare_exchange_weak(seen, now);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    --running;
+    return request + "\n";
+  });
+  server.Start();
+
+  std::vector<std::thread> clients;
+  for (int i = 0; i < kClients; ++i) {
+    clients.emplace_back([i] {
+      Client client(SocketPath());
+      const auto request = "query " + std::to_string(i);
+      client.Send(request + "\n");
+      EXPECT_EQ(client.Receive(), request + "\n");
+    });
+  }
+  for (auto& client : clients) {
+    client.join();
+  }
+  EXPECT_GT(max_running, 1);
+}
+
+TEST(QueryServerTest, StopClosesConnections) {
+  QueryServer server(SocketPath(), 1,
+                     [](const std::string& request) { return request + "\n"; });
+  server.Start();
+  Client client(SocketPath());
+  client.Send("ping\n");
+  EXPECT_EQ(client.Receive(), "ping\n");
+
+  // The worker is blocked reading the idle connection
+  server.Stop();
+  server.Wait();
+  EXPECT_EQ(client.Receive(), "");
+  EXPECT_FALSE(std::filesystem::exists(SocketPath()));
+}
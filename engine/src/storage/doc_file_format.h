@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+namespace storage {
+
+// On-disk layout of a document file, a pair of append-only files:
+//
+//   <path>          zlib-compressed blocks, each the concatenated url and
+//                   text bytes of consecutive documents
+//   <path>.entries  Header followed by a DocEntry per appended document
+//
+// A block is written before its entries, so a torn append leaves at most an
+// unreferenced block and a partial entry, which are ignored. A document
+// appended again replaces its earlier copy.
+namespace doc_format {
+
+inline constexpr uint64_t kMagic = 0x53434f4449525349;  // "ISRIDOCS"
+inline constexpr uint32_t kVersion = 1;
+
+struct Header {
+  uint64_t magic;
+  uint32_t version;
+  // Zero
+  uint32_t padding;
+};
+static_assert(sizeof(Header) == 16);
+
+struct DocEntry {
+  int32_t doc_id;
+  uint32_t url_size;
+  uint32_t text_size;
+  // Of the url in the decompressed block, the text follows it
+  uint32_t offset;
+  uint64_t block_offset;
+  uint32_t block_size;
+  uint32_t raw_block_size;
+};
+static_assert(sizeof(DocEntry) == 32);
+
+inline std::filesystem::path EntriesPath(const std::filesystem::path& path) {
+  return std::filesystem::path(path) += ".entries";
+}
+
+}  // namespace doc_format
+
+}  // namespace storage
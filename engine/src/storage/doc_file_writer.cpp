@@ -0,0 +1,102 @@
+#include "storage/doc_file_writer.h"
+
+#include <zlib.h>
+
+#include <stdexcept>
+
+namespace storage {
+
+DocFileWriter::DocFileWriter(const std::filesystem::path& path,
+                             bool truncate /* = false */,
+                             size_t block_size /* = kDefaultBlockSize */)
+    : block_size_(block_size) {
+  const auto entries_path = doc_format::EntriesPath(path);
+  if (truncate) {
+    std::filesystem::remove(path);
+    std::filesystem::remove(entries_path);
+  }
+
+  std::error_code error;
+  const auto entries_size = std::filesystem::file_size(entries_path, error);
+  const bool append = !error && entries_size >= sizeof(doc_format::Header);
+  if (append) {
+    doc_format::Header header;
+    std::ifstream in(entries_path, std::ios::binary);
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || header.magic != doc_format::kMagic ||
+        header.version != doc_format::kVersion) {
+      throw std::runtime_error("DocFileWriter: not a document file: " +
+                               entries_path.string());
+    }
+    // Drops a torn entry of an interrupted append
+    const auto entries_count = (entries_size - sizeof(header)) /
+                               sizeof(doc_format::DocEntry);
+    std::filesystem::resize_file(
+        entries_path,
+        sizeof(header) + entries_count * sizeof(doc_format::DocEntry));
+  }
+  data_size_ = std::filesystem::exists(path)
+                   ? std::filesystem::file_size(path)
+                   : 0;
+
+  data_.open(path, std::ios::binary | std::ios::app);
+  entries_.open(entries_path, std::ios::binary | (append ? std::ios::app
+                                                         : std::ios::trunc));
+  if (!data_.is_open() || !entries_.is_open()) {
+    throw std::runtime_error("DocFileWriter: can't open " + path.string());
+  }
+  if (!append) {
+    doc_format::Header header{};
+    header.magic = doc_format::kMagic;
+    header.version = doc_format::kVersion;
+    entries_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    entries_.flush();
+  }
+}
+
+void DocFileWriter::Add(const Document& doc) {
+  // The block fields are set by Flush()
+  doc_format::DocEntry entry{};
+  entry.doc_id = doc.id;
+  entry.url_size = static_cast<uint32_t>(doc.url.size());
+  entry.text_size = static_cast<uint32_t>(doc.text.size());
+  entry.offset = static_cast<uint32_t>(block_.size());
+  pending_.push_back(entry);
+  block_ += doc.url;
+  block_ += doc.text;
+  if (block_.size() >= block_size_) {
+    Flush();
+  }
+}
+
+void DocFileWriter::Flush() {
+  if (pending_.empty()) {
+    return;
+  }
+  uLongf size = compressBound(block_.size());
+  std::vector<Bytef> compressed(size);
+  if (compress2(compressed.data(), &size,
+                reinterpret_cast<const Bytef*>(block_.data()), block_.size(),
+                Z_DEFAULT_COMPRESSION) != Z_OK) {
+    throw std::runtime_error("DocFileWriter: can't compress a block");
+  }
+  for (auto& entry : pending_) {
+    entry.block_offset = data_size_;
+    entry.block_size = static_cast<uint32_t>(size);
+    entry.raw_block_size = static_cast<uint32_t>(block_.size());
+  }
+
+  data_.write(reinterpret_cast<const char*>(compressed.data()), size);
+  data_.flush();
+  entries_.write(reinterpret_cast<const char*>(pending_.data()),
+                 pending_.size() * sizeof(doc_format::DocEntry));
+  entries_.flush();
+  if (!data_ || !entries_) {
+    throw std::runtime_error("DocFileWriter: write failed");
+  }
+  data_size_ += size;
+  block_.clear();
+  pending_.clear();
+}
+
+}  // namespace storage
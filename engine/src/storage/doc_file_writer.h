@@ -0,0 +1,38 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "storage/doc_file_format.h"
+#include "storage/document.h"
+
+namespace storage {
+
+// Appends documents to a document file. Documents are buffered into a block
+// that is compressed and written once it grows past `block_size` bytes.
+class DocFileWriter {
+ public:
+  static constexpr size_t kDefaultBlockSize = 64 << 10;
+
+  // Appends to the existing file unless `truncate` is set
+  explicit DocFileWriter(const std::filesystem::path& path,
+                         bool truncate = false,
+                         size_t block_size = kDefaultBlockSize);
+
+  void Add(const Document& doc);
+  // Writes the buffered documents as a block, they are lost unless flushed
+  void Flush();
+
+ private:
+  const size_t block_size_;
+  std::ofstream data_;
+  std::ofstream entries_;
+  uint64_t data_size_ = 0;
+
+  std::string block_;
+  std::vector<doc_format::DocEntry> pending_;
+};
+
+}  // namespace storage
@@ -2,20 +2,31 @@
 
 #include <memory>
 #include <optional>
+#include <vector>
 
 namespace storage {
 
 class Document;
 
+// Implementations are safe to use from concurrent threads
 class DocStorage {
  public:
   class Cursor {
    public:
+    virtual ~Cursor() = default;
     virtual std::optional<Document> Next() = 0;
   };
 
+  virtual ~DocStorage() = default;
+
   virtual std::unique_ptr<Cursor> GetCursor() const = 0;
-  virtual Document GetDocByID(int32_t doc_id) = 0;
+  // Documents with ids greater than `doc_id`, in increasing id order
+  virtual std::unique_ptr<Cursor> GetCursorAfter(int32_t doc_id) const = 0;
+  virtual Document GetDocByID(int32_t doc_id) const = 0;
+  // Documents with the `doc_ids`, in the same order. Ids missing from the
+  // storage, e.g. deleted since they were searched, are skipped.
+  virtual std::vector<Document> GetDocsByIDs(
+      const std::vector<int32_t>& doc_ids) const = 0;
 };
 
 }  // namespace storage
\ No newline at end of file
@@ -0,0 +1,197 @@
+#include "storage/file_doc_storage.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+#include "storage/mapped_file.h"
+
+namespace {
+
+storage::Document Extract(const storage::doc_format::DocEntry& entry,
+                          const std::string& block) {
+  if (static_cast<uint64_t>(entry.offset) + entry.url_size + entry.text_size >
+      block.size()) {
+    throw std::runtime_error("FileDocStorage: corrupted entry for id: " +
+                             std::to_string(entry.doc_id));
+  }
+  return {.id = entry.doc_id,
+          .url = block.substr(entry.offset, entry.url_size),
+          .text = block.substr(entry.offset + entry.url_size,
+                               entry.text_size)};
+}
+
+}  // namespace
+
+namespace storage {
+
+// Walks the entries from `next`, decompressing every block once as long as
+// the documents were appended in id order
+class FileDocStorage::FileCursor : public DocStorage::Cursor {
+ public:
+  FileCursor(const FileDocStorage& storage, size_t next)
+      : storage_(storage), next_(next) {}
+
+  std::optional<Document> Next() override {
+    if (next_ == storage_.entries_.size()) {
+      return std::nullopt;
+    }
+    const auto& entry = storage_.entries_[next_++];
+    if (!block_offset_ || *block_offset_ != entry.block_offset) {
+      block_ = storage_.ReadBlock(entry);
+      block_offset_ = entry.block_offset;
+    }
+    return Extract(entry, block_);
+  }
+
+ private:
+  const FileDocStorage& storage_;
+  size_t next_;
+  std::string block_;
+  std::optional<uint64_t> block_offset_;
+};
+
+FileDocStorage::FileDocStorage(const std::filesystem::path& path)
+    : path_(path) {
+  const auto file = MappedFile::Read(doc_format::EntriesPath(path));
+  const auto data = file->data();
+  doc_format::Header header;
+  if (data.size() < sizeof(header)) {
+    throw std::runtime_error("FileDocStorage: not a document file: " +
+                             path.string());
+  }
+  std::memcpy(&header, data.data(), sizeof(header));
+  if (header.magic != doc_format::kMagic ||
+      header.version != doc_format::kVersion) {
+    throw std::runtime_error("FileDocStorage: not a document file: " +
+                             path.string());
+  }
+
+  // A torn entry at the end is ignored
+  entries_.resize((data.size() - sizeof(header)) /
+                  sizeof(doc_format::DocEntry));
+  std::memcpy(entries_.data(), data.data() + sizeof(header),
+              entries_.size() * sizeof(doc_format::DocEntry));
+  std::stable_sort(entries_.begin(), entries_.end(),
+                   [](const auto& lhs, const auto& rhs) {
+                     return lhs.doc_id < rhs.doc_id;
+                   });
+  // The last appended copy of a document wins
+  size_t size = 0;
+  for (const auto& entry : entries_) {
+    if (size > 0 && entries_[size - 1].doc_id == entry.doc_id) {
+      entries_[size - 1] = entry;
+    } else {
+      entries_[size++] = entry;
+    }
+  }
+  entries_.resize(size);
+
+  fd_ = open(path.c_str(), O_RDONLY);
+  if (fd_ < 0) {
+    throw std::runtime_error("FileDocStorage: can't open " + path.string());
+  }
+}
+
+FileDocStorage::~FileDocStorage() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+std::unique_ptr<DocStorage::Cursor> FileDocStorage::GetCursor() const {
+  return std::make_unique<FileCursor>(*this, 0);
+}
+
+std::unique_ptr<DocStorage::Cursor> FileDocStorage::GetCursorAfter(
+    int32_t doc_id) const {
+  const auto it = std::upper_bound(
+      entries_.begin(), entries_.end(), doc_id,
+      [](int32_t id, const auto& entry) { return id < entry.doc_id; });
+  return std::make_unique<FileCursor>(*this, it - entries_.begin());
+}
+
+Document FileDocStorage::GetDocByID(int32_t doc_id) const {
+  const auto* entry = FindEntry(doc_id);
+  if (entry == nullptr) {
+    throw std::runtime_error("FileDocStorage: document not found for id: " +
+                             std::to_string(doc_id));
+  }
+  return Extract(*entry, ReadBlock(*entry));
+}
+
+std::vector<Document> FileDocStorage::GetDocsByIDs(
+    const std::vector<int32_t>& doc_ids) const {
+  std::vector<const doc_format::DocEntry*> entries;
+  entries.reserve(doc_ids.size());
+  for (const auto doc_id : doc_ids) {
+    if (const auto* entry = FindEntry(doc_id)) {
+      entries.push_back(entry);
+    }
+  }
+  // Documents of a block are extracted together
+  std::vector<size_t> order(entries.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&entries](size_t lhs, size_t rhs) {
+    return entries[lhs]->block_offset < entries[rhs]->block_offset;
+  });
+
+  std::vector<Document> result(entries.size());
+  std::string block;
+  for (size_t i = 0; i < order.size(); ++i) {
+    const auto& entry = *entries[order[i]];
+    if (i == 0 || entries[order[i - 1]]->block_offset != entry.block_offset) {
+      block = ReadBlock(entry);
+    }
+    result[order[i]] = Extract(entry, block);
+  }
+  return result;
+}
+
+size_t FileDocStorage::size() const { return entries_.size(); }
+
+const doc_format::DocEntry* FileDocStorage::FindEntry(int32_t doc_id) const {
+  const auto it = std::lower_bound(
+      entries_.begin(), entries_.end(), doc_id,
+      [](const auto& entry, int32_t id) { return entry.doc_id < id; });
+  if (it == entries_.end() || it->doc_id != doc_id) {
+    return nullptr;
+  }
+  return &*it;
+}
+
+std::string FileDocStorage::ReadBlock(
+    const doc_format::DocEntry& entry) const {
+  std::vector<Bytef> compressed(entry.block_size);
+  for (size_t read = 0; read < compressed.size();) {
+    const auto count =
+        pread(fd_, compressed.data() + read, compressed.size() - read,
+              static_cast<off_t>(entry.block_offset + read));
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      throw std::runtime_error("FileDocStorage: can't read " +
+                               path_.string());
+    }
+    read += count;
+  }
+
+  std::string block(entry.raw_block_size, '\0');
+  uLongf size = block.size();
+  if (uncompress(reinterpret_cast<Bytef*>(block.data()), &size,
+                 compressed.data(), compressed.size()) != Z_OK ||
+      size != block.size()) {
+    throw std::runtime_error("FileDocStorage: corrupted block in " +
+                             path_.string());
+  }
+  return block;
+}
+
+}  // namespace storage
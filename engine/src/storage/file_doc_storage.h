@@ -0,0 +1,49 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "storage/doc_file_format.h"
+#include "storage/doc_storage.h"
+#include "storage/document.h"
+
+namespace storage {
+
+// Documents of a document file written by DocFileWriter. Blocks are read
+// with pread, so hot documents are served from the page cache. Documents
+// appended after it's opened aren't visible until it's reopened.
+class FileDocStorage : public DocStorage {
+ public:
+  explicit FileDocStorage(const std::filesystem::path& path);
+  ~FileDocStorage() override;
+
+  FileDocStorage(const FileDocStorage&) = delete;
+  FileDocStorage& operator=(const FileDocStorage&) = delete;
+
+  std::unique_ptr<DocStorage::Cursor> GetCursor() const override;
+  std::unique_ptr<DocStorage::Cursor> GetCursorAfter(
+      int32_t doc_id) const override;
+
+  Document GetDocByID(int32_t doc_id) const override;
+  // Every block holding the documents is decompressed once
+  std::vector<Document> GetDocsByIDs(
+      const std::vector<int32_t>& doc_ids) const override;
+
+  size_t size() const;
+
+ private:
+  class FileCursor;
+
+  // Null if the document isn't stored
+  const doc_format::DocEntry* FindEntry(int32_t doc_id) const;
+  // Decompressed block holding the entry
+  std::string ReadBlock(const doc_format::DocEntry& entry) const;
+
+  const std::filesystem::path path_;
+  int fd_ = -1;
+  // Latest entry of every document, ordered by id
+  std::vector<doc_format::DocEntry> entries_;
+};
+
+}  // namespace storage
@@ -0,0 +1,135 @@
+#include "storage/file_doc_storage.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include "storage/doc_file_writer.h"
+
+using storage::DocFileWriter;
+using storage::Document;
+using storage::FileDocStorage;
+
+class FileDocStorageTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    path = std::filesystem::temp_directory_path() /
+           ("file_doc_storage_test_" + std::to_string(getpid()) + ".bin");
+    // Small blocks, so the documents span several of them
+    DocFileWriter writer(path, true, 256);
+    for (int32_t doc_id = 0; doc_id < 50; ++doc_id) {
+      writer.Add(MakeDocument(doc_id));
+    }
+    writer.Flush();
+  }
+
+  void TearDown() override {
+    std::filesystem::remove(path);
+    std::filesystem::remove(storage::doc_format::EntriesPath(path));
+  }
+
+  static Document MakeDocument(int32_t doc_id, const std::string& tag = "") {
+    return {.id = doc_id,
+            .url = "https://example.com/" + std::to_string(doc_id),
+            .text = tag + "text of document " + std::to_string(doc_id) +
+                    std::string(doc_id, 'x')};
+  }
+
+  static void ExpectDocument(const Document& actual,
+                             const Document& expected) {
+    EXPECT_EQ(actual.id, expected.id);
+    EXPECT_EQ(actual.url, expected.url);
+    EXPECT_EQ(actual.text, expected.text);
+  }
+
+  std::filesystem::path path;
+};
+
+TEST_F(FileDocStorageTest, GetByID) {
+  const FileDocStorage storage(path);
+  EXPECT_EQ(storage.size(), 50);
+  for (const int32_t doc_id : {0, 1, 17, 49}) {
+    ExpectDocument(storage.GetDocByID(doc_id), MakeDocument(doc_id));
+  }
+  EXPECT_THROW(storage.GetDocByID(50), std::runtime_error);
+}
+
+TEST_F(FileDocStorageTest, GetByIDsKeepsOrder) {
+  const FileDocStorage storage(path);
+  const std::vector<int32_t> doc_ids{42, 3, 4, 49, 0};
+  const auto docs = storage.GetDocsByIDs(doc_ids);
+  ASSERT_EQ(docs.size(), doc_ids.size());
+  for (size_t i = 0; i < doc_ids.size(); ++i) {
+    ExpectDocument(docs[i], MakeDocument(doc_ids[i]));
+  }
+  EXPECT_TRUE(storage.GetDocsByIDs({}).empty());
+}
+
+TEST_F(FileDocStorageTest, GetByIDsRepeatedAndMissing) {
+  const FileDocStorage storage(path);
+  const auto docs = storage.GetDocsByIDs({7, 100, 7, 3});
+  ASSERT_EQ(docs.size(), 3);
+  ExpectDocument(docs[0], MakeDocument(7));
+  ExpectDocument(docs[1], MakeDocument(7));
+  ExpectDocument(docs[2], MakeDocument(3));
+}
+
+TEST_F(FileDocStorageTest, Cursors) {
+  const FileDocStorage storage(path);
+  auto cursor = storage.GetCursor();
+  for (int32_t doc_id = 0; doc_id < 50; ++doc_id) {
+    const auto doc = cursor->Next();
+    ASSERT_TRUE(doc.has_value());
+    ExpectDocument(*doc, MakeDocument(doc_id));
+  }
+  EXPECT_FALSE(cursor->Next().has_value());
+
+  auto after = storage.GetCursorAfter(47);
+  EXPECT_EQ(after->Next()->id, 48);
+  EXPECT_EQ(after->Next()->id, 49);
+  EXPECT_FALSE(after->Next().has_value());
+  EXPECT_FALSE(storage.GetCursorAfter(49)->Next().has_value());
+}
+
+TEST_F(FileDocStorageTest, AppendReplacesDocuments) {
+  {
+    DocFileWriter writer(path);
+    writer.Add(MakeDocument(7, "updated "));
+    writer.Add(MakeDocument(50));
+    writer.Flush();
+  }
+  const FileDocStorage storage(path);
+  EXPECT_EQ(storage.size(), 51);
+  ExpectDocument(storage.GetDocByID(7), MakeDocument(7, "updated "));
+  ExpectDocument(storage.GetDocByID(50), MakeDocument(50));
+  ExpectDocument(storage.GetDocByID(8), MakeDocument(8));
+}
+
+TEST_F(FileDocStorageTest, IgnoresTornAppend) {
+  {
+    std::ofstream entries(storage::doc_format::EntriesPath(path),
+                          std::ios::binary | std::ios::app);
+    entries << "torn";
+  }
+  EXPECT_EQ(FileDocStorage(path).size(), 50);
+
+  // The writer drops the torn entry before appending
+  {
+    DocFileWriter writer(path);
+    writer.Add(MakeDocument(50));
+    writer.Flush();
+  }
+  const FileDocStorage storage(path);
+  EXPECT_EQ(storage.size(), 51);
+  ExpectDocument(storage.GetDocByID(50), MakeDocument(50));
+}
+
+TEST_F(FileDocStorageTest, RejectsOtherFiles) {
+  {
+    std::ofstream entries(storage::doc_format::EntriesPath(path),
+                          std::ios::binary | std::ios::trunc);
+    entries << "not a document file";
+  }
+  EXPECT_THROW(FileDocStorage storage(path), std::runtime_error);
+  EXPECT_THROW(DocFileWriter writer(path), std::runtime_error);
+}
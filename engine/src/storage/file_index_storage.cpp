@@ -1,101 +1,284 @@
 #include "storage/file_index_storage.h"
 
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+
 #include "engine/indexing/inverted_index.h"
+#include "storage/index_reader.h"
+#include "storage/index_writer.h"
+#include "storage/mapped_file.h"
 
-namespace storage {
+namespace {
+
+std::filesystem::path DeletionsPath(const std::filesystem::path& path) {
+  auto result = path;
+  result += ".del";
+  return result;
+}
 
-FileIndexStorage::FileIndexStorage(const std::filesystem::path& filename)
-    : file_(filename, std::ios::in | std::ios::out | std::ios::binary) {}
+// Deletions saved next to the index, none if there is no such file
+indexing::DeletedDocs LoadDeletions(const std::filesystem::path& path,
+                                    const storage::IndexReader& reader) {
+  const uint64_t first_doc_id = reader.first_doc_id();
+  const uint64_t docs_count = reader.doc_lengths().size();
+  indexing::DeletedDocs deleted;
+  deleted.Resize(first_doc_id, first_doc_id + docs_count);
 
-void FileIndexStorage::SaveIndex(const indexing::InvertedIndex& index) {
-  if (!file_.is_open()) {
-    throw std::runtime_error("FileIndexStorage: can't open file");
-  }
-
-  const auto terms_count = index.index_.size();
-  file_.write(reinterpret_cast<const char*>(&terms_count), sizeof(terms_count));
-  for (const auto& [term, posting_list] : index.index_) {
-    const auto term_size = term.size();
-    file_.write(reinterpret_cast<const char*>(&term_size), sizeof(term_size));
-    file_.write(reinterpret_cast<const char*>(term.data()), term_size);
-
-    const auto list_size = posting_list.size();
-    file_.write(reinterpret_cast<const char*>(&list_size), sizeof(list_size));
-
-    const auto doc_buf_size = posting_list.doc_buffer_.size();
-    file_.write(reinterpret_cast<const char*>(&doc_buf_size),
-                sizeof(doc_buf_size));
-    file_.write(reinterpret_cast<const char*>(posting_list.doc_buffer_.data()),
-                doc_buf_size);
-
-    const auto coord_buf_size = posting_list.coord_buffer_.size();
-    file_.write(reinterpret_cast<const char*>(&coord_buf_size),
-                sizeof(coord_buf_size));
-    file_.write(
-        reinterpret_cast<const char*>(posting_list.coord_buffer_.data()),
-        coord_buf_size);
-  }
-
-  const auto docs_count = index.doc_lengths_.size();
-  file_.write(reinterpret_cast<const char*>(&docs_count), sizeof(docs_count));
-  file_.write(reinterpret_cast<const char*>(index.doc_lengths_.data()),
-              sizeof(uint32_t) * docs_count);
-  file_.flush();
-  file_.seekg(0, std::ios::beg);
-  file_.seekp(0, std::ios::beg);
+  std::ifstream in(DeletionsPath(path), std::ios::binary);
+  if (!in) {
+    return deleted;
+  }
+  uint64_t saved_first = 0;
+  uint64_t saved_count = 0;
+  in.read(reinterpret_cast<char*>(&saved_first), sizeof(saved_first));
+  in.read(reinterpret_cast<char*>(&saved_count), sizeof(saved_count));
+  if (!in || saved_first != first_doc_id || saved_count != docs_count) {
+    throw std::runtime_error("FileIndexStorage: corrupted deletions file");
+  }
+  std::vector<uint64_t> words((saved_count + 63) / 64);
+  in.read(reinterpret_cast<char*>(words.data()),
+          words.size() * sizeof(uint64_t));
+  if (!in) {
+    throw std::runtime_error("FileIndexStorage: corrupted deletions file");
+  }
+  deleted.SetWords(words);
+  return deleted;
 }
 
-indexing::InvertedIndex FileIndexStorage::LoadIndex() {
-  if (!file_.is_open()) {
-    throw std::runtime_error("FileIndexStorage: can't open file");
+// Lexicon of a loaded index file. Lists are views built at their first
+// lookup, so loading touches no terms and concurrent lookups take no lock.
+class MappedLexicon : public indexing::Lexicon {
+ public:
+  explicit MappedLexicon(storage::IndexReader reader)
+      : reader_(std::move(reader)),
+        lists_(std::make_unique<
+               std::atomic<const indexing::CompressedPostingList*>[]>(
+            reader_.terms_count())) {}
+
+  ~MappedLexicon() override {
+    for (size_t idx = 0; idx < reader_.terms_count(); ++idx) {
+      delete lists_[idx].load();
+    }
   }
 
-  indexing::InvertedIndex index;
+  MappedLexicon(const MappedLexicon&) = delete;
+  MappedLexicon& operator=(const MappedLexicon&) = delete;
 
-  size_t terms_count;
-  file_.read(reinterpret_cast<char*>(&terms_count), sizeof(terms_count));
-  for (size_t i = 0; i < terms_count; ++i) {
-    size_t term_size;
-    file_.read(reinterpret_cast<char*>(&term_size), sizeof(term_size));
-    std::string term(term_size, '\0');
-    file_.read(reinterpret_cast<char*>(term.data()), term_size);
+  size_t size() const override { return reader_.terms_count(); }
 
-    indexing::CompressedPostingList posting_list;
+  std::string_view GetTerm(size_t idx) const override {
+    return reader_.GetTerm(idx);
+  }
 
-    size_t list_size;
-    file_.read(reinterpret_cast<char*>(&list_size), sizeof(list_size));
-    posting_list.size_ = list_size;
+  std::optional<size_t> Find(std::string_view term) const override {
+    return reader_.Find(term);
+  }
 
-    size_t doc_buf_size;
-    file_.read(reinterpret_cast<char*>(&doc_buf_size), sizeof(doc_buf_size));
-    posting_list.doc_buffer_.resize(doc_buf_size);
+  const indexing::CompressedPostingList& GetPostings(
+      size_t idx) const override {
+    auto& slot = lists_[idx];
+    if (const auto* list = slot.load(std::memory_order_acquire)) {
+      return *list;
+    }
+    // Lookups racing for the same term build a view each, one is kept
+    auto list = std::make_unique<const indexing::CompressedPostingList>(
+        reader_.GetPostings(idx));
+    const indexing::CompressedPostingList* expected = nullptr;
+    if (slot.compare_exchange_strong(expected, list.get(),
+                                     std::memory_order_acq_rel)) {
+      return *list.release();
+    }
+    return *expected;
+  }
 
-    file_.read(reinterpret_cast<char*>(posting_list.doc_buffer_.data()),
-               doc_buf_size);
+ private:
+  const storage::IndexReader reader_;
+  // By lexicon position, null until looked up
+  const std::unique_ptr<std::atomic<const indexing::CompressedPostingList*>[]>
+      lists_;
+};
 
-    size_t coord_buf_size;
-    file_.read(reinterpret_cast<char*>(&coord_buf_size),
-               sizeof(coord_buf_size));
-    posting_list.coord_buffer_.resize(coord_buf_size);
+}  // namespace
+
+namespace storage {
 
-    file_.read(reinterpret_cast<char*>(posting_list.coord_buffer_.data()),
-               coord_buf_size);
+FileIndexStorage::FileIndexStorage(const std::filesystem::path& filename,
+                                   LoadMode mode /* = LoadMode::kMmap */)
+    : filename_(filename), mode_(mode) {}
 
-    index.index_[std::move(term)] = std::move(posting_list);
+void FileIndexStorage::SaveIndex(const indexing::InvertedIndex& index) {
+  IndexWriter writer(filename_);
+  if (index.GetDeletedCount() == 0) {
+    index.ForEachList([&writer](std::string_view term,
+                                const indexing::CompressedPostingList& list) {
+      writer.AddList(std::string(term), list);
+    });
+    writer.Finish(index.doc_lengths_, index.codec_);
+    std::filesystem::remove(DeletionsPath(filename_));
+    return;
   }
-  index.BuildSkips();
 
-  size_t docs_count;
-  file_.read(reinterpret_cast<char*>(&docs_count), sizeof(docs_count));
-  index.doc_lengths_.resize(docs_count);
-  file_.read(reinterpret_cast<char*>(index.doc_lengths_.data()),
-             sizeof(uint32_t) * docs_count);
+  // Deleted documents are purged while the lists are rewritten
+  auto doc_lengths = index.doc_lengths_;
+  for (indexing::DocID doc_id = index.GetFirstDocID();
+       doc_id < index.GetDocsCount(); ++doc_id) {
+    if (index.IsDeleted(doc_id)) {
+      doc_lengths.Set(doc_id, 0);
+    }
+  }
+  index.ForEachList([&](std::string_view term,
+                         const indexing::CompressedPostingList& posting_list) {
+    auto purged = indexing::CompressedPostingList::MergeDisjoint(
+        {&posting_list}, doc_lengths, {&index.deleted_docs_});
+    if (purged.size() == 0) {
+      return;
+    }
+    if (posting_list.skip_step() > 0) {
+      purged.BuildSkips(doc_lengths, posting_list.skip_step(),
+                        posting_list.codec());
+    }
+    writer.AddList(std::string(term), purged);
+  });
+  writer.Finish(doc_lengths, index.codec_);
+  std::filesystem::remove(DeletionsPath(filename_));
+}
 
-  file_.flush();
-  file_.seekg(0, std::ios::beg);
-  file_.seekp(0, std::ios::beg);
+indexing::InvertedIndex FileIndexStorage::LoadIndex() {
+  const IndexReader reader(mode_ == LoadMode::kMmap
+                               ? MappedFile::Map(filename_)
+                               : MappedFile::Read(filename_));
 
+  indexing::InvertedIndex index;
+  const auto doc_lengths = reader.doc_lengths();
+  index.doc_lengths_ = indexing::DocLengths(
+      reader.first_doc_id(),
+      std::vector<uint32_t>(doc_lengths.begin(), doc_lengths.end()));
+  index.deleted_docs_ = LoadDeletions(filename_, reader);
+  index.codec_ = reader.codec();
+  index.lexicon_ = std::make_shared<MappedLexicon>(reader);
   return index;
 }
 
+void FileIndexStorage::MergeRuns(
+    const std::vector<std::filesystem::path>& runs,
+    indexing::CodecType codec) {
+  std::vector<IndexReader> readers;
+  readers.reserve(runs.size());
+  for (const auto& run : runs) {
+    readers.emplace_back(MappedFile::Map(run));
+  }
+
+  // Deleted documents are purged from the merged index
+  std::vector<indexing::DeletedDocs> deleted;
+  deleted.reserve(runs.size());
+  uint64_t first_doc_id = UINT32_MAX;
+  uint64_t end_doc_id = 0;
+  for (size_t i = 0; i < runs.size(); ++i) {
+    deleted.push_back(LoadDeletions(runs[i], readers[i]));
+    if (!readers[i].doc_lengths().empty()) {
+      first_doc_id = std::min<uint64_t>(first_doc_id,
+                                        readers[i].first_doc_id());
+      end_doc_id = std::max(end_doc_id, readers[i].first_doc_id() +
+                                            readers[i].doc_lengths().size());
+    }
+  }
+
+  // The merged index spans the ids of all the runs
+  indexing::DocLengths doc_lengths;
+  if (first_doc_id < end_doc_id) {
+    doc_lengths = indexing::DocLengths(
+        first_doc_id, std::vector<uint32_t>(end_doc_id - first_doc_id, 0));
+  }
+  for (size_t i = 0; i < readers.size(); ++i) {
+    const auto lengths = readers[i].doc_lengths();
+    for (size_t j = 0; j < lengths.size(); ++j) {
+      const indexing::DocID doc_id = readers[i].first_doc_id() + j;
+      if (lengths[j] != 0 && !deleted[i].Contains(doc_id)) {
+        doc_lengths.Set(doc_id, lengths[j]);
+      }
+    }
+  }
+
+  // Lexicons are sorted, so equal terms of all runs come out together and
+  // only one merged list is held in memory at a time
+  using Cursor = std::pair<std::string_view, size_t>;
+  std::priority_queue<Cursor, std::vector<Cursor>, std::greater<>> heap;
+  std::vector<size_t> positions(readers.size(), 0);
+  for (size_t i = 0; i < readers.size(); ++i) {
+    if (readers[i].terms_count() > 0) {
+      heap.emplace(readers[i].GetTerm(0), i);
+    }
+  }
+
+  IndexWriter writer(filename_);
+  std::vector<indexing::CompressedPostingList> lists;
+  std::vector<const indexing::CompressedPostingList*> list_ptrs;
+  std::vector<const indexing::DeletedDocs*> list_deleted;
+  while (!heap.empty()) {
+    const auto term = heap.top().first;
+    lists.clear();
+    list_deleted.clear();
+    while (!heap.empty() && heap.top().first == term) {
+      const auto idx = heap.top().second;
+      heap.pop();
+      lists.push_back(readers[idx].GetPostings(positions[idx]));
+      list_deleted.push_back(&deleted[idx]);
+      if (++positions[idx] < readers[idx].terms_count()) {
+        heap.emplace(readers[idx].GetTerm(positions[idx]), idx);
+      }
+    }
+
+    list_ptrs.clear();
+    for (const auto& list : lists) {
+      list_ptrs.push_back(&list);
+    }
+    auto merged = indexing::CompressedPostingList::MergeDisjoint(
+        list_ptrs, doc_lengths, list_deleted);
+    if (merged.size() == 0) {
+      continue;
+    }
+    merged.BuildSkips(doc_lengths, 0, codec);
+    writer.AddList(std::string(term), merged);
+  }
+  writer.Finish(doc_lengths, codec);
+  std::filesystem::remove(DeletionsPath(filename_));
+}
+
+void FileIndexStorage::SaveDeletions(const indexing::InvertedIndex& index) {
+  const auto path = DeletionsPath(filename_);
+  if (index.GetDeletedCount() == 0) {
+    std::filesystem::remove(path);
+    return;
+  }
+
+  // Replaced at once, so a crash never leaves a partial file
+  auto tmp = path;
+  tmp += ".tmp";
+  {
+    const uint64_t first_doc_id = index.deleted_docs_.first_doc_id();
+    const uint64_t docs_count =
+        index.deleted_docs_.end_doc_id() - first_doc_id;
+    const auto words = index.deleted_docs_.GetWords();
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&first_doc_id),
+              sizeof(first_doc_id));
+    out.write(reinterpret_cast<const char*>(&docs_count), sizeof(docs_count));
+    out.write(reinterpret_cast<const char*>(words.data()),
+              words.size() * sizeof(uint64_t));
+    if (!out) {
+      throw std::runtime_error("FileIndexStorage: can't write deletions");
+    }
+  }
+  std::filesystem::rename(tmp, path);
+}
+
+void FileIndexStorage::Remove() {
+  std::filesystem::remove(filename_);
+  std::filesystem::remove(DeletionsPath(filename_));
+}
+
 }  // namespace storage
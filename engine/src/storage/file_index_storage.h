@@ -1,7 +1,6 @@
 #pragma once
 
 #include <filesystem>
-#include <fstream>
 
 #include "storage/index_storage.h"
 
@@ -9,13 +8,31 @@ namespace storage {
 
 class FileIndexStorage : public IndexStorage {
  public:
-  explicit FileIndexStorage(const std::filesystem::path& filename);
+  enum class LoadMode {
+    // Posting lists are views into the mapped file, nothing is decoded
+    // or copied at startup
+    kMmap,
+    // The file is read into memory at once, the lists are views into it
+    kRead,
+  };
+
+  explicit FileIndexStorage(const std::filesystem::path& filename,
+                            LoadMode mode = LoadMode::kMmap);
 
   void SaveIndex(const indexing::InvertedIndex&) override;
   indexing::InvertedIndex LoadIndex() override;
+  void MergeRuns(const std::vector<std::filesystem::path>& runs,
+                 indexing::CodecType codec) override;
+  // Deletions are kept in a side file next to the index, the index file
+  // itself is never modified
+  void SaveDeletions(const indexing::InvertedIndex&) override;
+
+  // Deletes the index file along with its deletions
+  void Remove();
 
  private:
-  std::fstream file_;
+  std::filesystem::path filename_;
+  LoadMode mode_;
 };
 
 }  // namespace storage
@@ -0,0 +1,354 @@
+#include "storage/file_index_storage.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <thread>
+
+#include "engine/indexing/inverted_index.h"
+
+using storage::FileIndexStorage;
+
+class FileIndexStorageTest
+    : public ::testing::TestWithParam<FileIndexStorage::LoadMode> {
+ protected:
+  void SetUp() override {
+    filename = std::filesystem::temp_directory_path() /
+               ("file_index_storage_test_" +
+                std::to_string(static_cast<int>(GetParam())) + ".bin");
+
+    for (indexing::DocID doc_id = 0; doc_id < 100; ++doc_id) {
+      std::vector<std::string> terms{"common", "word"};
+      if (doc_id % 7 == 0) {
+        terms.push_back("rare");
+        terms.push_back("common");
+      }
+      index.AddDocument(doc_id, terms);
+    }
+    index.BuildSkips();
+  }
+
+  void TearDown() override { FileIndexStorage(filename).Remove(); }
+
+  std::filesystem::path filename;
+  indexing::InvertedIndex index;
+};
+
+TEST_P(FileIndexStorageTest, SaveAndLoad) {
+  FileIndexStorage storage(filename, GetParam());
+  storage.SaveIndex(index);
+  const auto loaded = storage.LoadIndex();
+
+  EXPECT_EQ(loaded.GetDocsCount(), index.GetDocsCount());
+  EXPECT_EQ(loaded.GetDocLength(7), 4);
+  EXPECT_EQ(loaded.GetPostings("missing").size(), 0);
+
+  for (const std::string term : {"common", "word", "rare"}) {
+    const auto& expected = index.GetPostings(term);
+    const auto& actual = loaded.GetPostings(term);
+    ASSERT_EQ(actual.size(), expected.size());
+    EXPECT_EQ(actual.max_tf(), expected.max_tf());
+    EXPECT_EQ(actual.min_doc_length(), expected.min_doc_length());
+    EXPECT_EQ(actual.skip_step(), expected.skip_step());
+
+    auto jtr = actual.begin();
+    for (auto itr = expected.begin(); itr != expected.end(); ++itr, ++jtr) {
+      ASSERT_NE(jtr, actual.end());
+      EXPECT_EQ(jtr->doc_id, itr->doc_id);
+      EXPECT_EQ(jtr->tf, itr->tf);
+      EXPECT_EQ(*jtr.GetCoordItr(), *itr.GetCoordItr());
+    }
+    EXPECT_EQ(jtr, actual.end());
+  }
+
+  auto itr = loaded.GetPostings("rare").begin();
+  itr.SkipTo(50);
+  EXPECT_EQ(itr->doc_id, 56);
+  const auto block = itr.GetBlockMax(56);
+  EXPECT_EQ(block.max_tf, 1);
+  EXPECT_EQ(block.min_doc_length, 4);
+}
+
+TEST_P(FileIndexStorageTest, SkipStepPerList) {
+  index.BuildSkips([](const std::string& term, size_t list_size) -> size_t {
+    return term == "word" ? list_size / 2 : 0;
+  });
+  EXPECT_EQ(index.GetPostings("word").skip_step(), 50);
+  EXPECT_EQ(index.GetPostings("common").skip_step(), 10);
+
+  FileIndexStorage storage(filename, GetParam());
+  storage.SaveIndex(index);
+  const auto loaded = storage.LoadIndex();
+  EXPECT_EQ(loaded.GetPostings("word").skip_step(), 50);
+  EXPECT_EQ(loaded.GetPostings("common").skip_step(), 10);
+
+  auto itr = loaded.GetPostings("word").begin();
+  itr.SkipTo(73);
+  EXPECT_EQ(itr->doc_id, 73);
+  EXPECT_EQ(itr.GetBlockMax(73).last_doc_id, UINT32_MAX);
+  EXPECT_EQ(itr.GetBlockMax(10).last_doc_id, 49);
+}
+
+TEST_P(FileIndexStorageTest, LoadedListsAreReadOnly) {
+  FileIndexStorage storage(filename, GetParam());
+  storage.SaveIndex(index);
+  auto loaded = storage.LoadIndex();
+
+  auto list = loaded.GetPostings("word");
+  EXPECT_THROW(list.Add(100, {0}), std::runtime_error);
+}
+
+TEST_P(FileIndexStorageTest, BitPacking) {
+  auto packed = std::move(index);
+  packed.BuildSkips({}, indexing::CodecType::kBitPacking);
+  FileIndexStorage storage(filename, GetParam());
+  storage.SaveIndex(packed);
+  const auto loaded = storage.LoadIndex();
+  EXPECT_EQ(loaded.GetCodecType(), indexing::CodecType::kBitPacking);
+
+  for (const std::string term : {"common", "word", "rare"}) {
+    const auto& list = loaded.GetPostings(term);
+    EXPECT_EQ(list.codec(), indexing::CodecType::kBitPacking);
+    auto jtr = list.begin();
+    for (const auto& posting : packed.GetPostings(term)) {
+      ASSERT_NE(jtr, list.end());
+      EXPECT_EQ(*jtr, posting);
+      ++jtr;
+    }
+    EXPECT_EQ(jtr, list.end());
+  }
+
+  auto itr = loaded.GetPostings("common").begin();
+  itr.SkipTo(49);
+  ASSERT_EQ(itr->doc_id, 49);
+  std::vector<uint32_t> coords;
+  for (auto jtr = itr.GetCoordItr(); !jtr.IsEnd(); ++jtr) {
+    coords.push_back(*jtr);
+  }
+  const std::vector<uint32_t> expected{0, 3};
+  EXPECT_EQ(coords, expected);
+}
+
+TEST_P(FileIndexStorageTest, EliasFano) {
+  // Long lists of short gaps are denser as Elias-Fano than as gaps
+  indexing::InvertedIndex fifths;
+  for (indexing::DocID doc_id = 0; doc_id < 2500; ++doc_id) {
+    fifths.AddDocument(doc_id, doc_id % 5 == 0
+                                   ? std::vector<std::string>{"fifth", "word"}
+                                   : std::vector<std::string>{"word"});
+  }
+  fifths.BuildSkips();
+
+  FileIndexStorage storage(filename, GetParam());
+  storage.SaveIndex(fifths);
+  const auto loaded = storage.LoadIndex();
+
+  const auto& list = loaded.GetPostings("fifth");
+  EXPECT_EQ(list.doc_encoding(), indexing::DocEncoding::kEliasFano);
+  auto itr = list.begin();
+  itr.SkipTo(1001);
+  ASSERT_EQ(itr.doc_id(), 1005);
+  EXPECT_EQ(itr->tf, 1);
+  itr.SkipTo(2495);
+  ASSERT_EQ(itr.doc_id(), 2495);
+  itr.SkipTo(2496);
+  EXPECT_TRUE(itr.IsEnd());
+}
+
+TEST_P(FileIndexStorageTest, Bitmap) {
+  FileIndexStorage storage(filename, GetParam());
+  storage.SaveIndex(index);
+  const auto loaded = storage.LoadIndex();
+
+  // Lists over every document are a single run per block
+  const auto& list = loaded.GetPostings("common");
+  EXPECT_EQ(list.doc_encoding(), indexing::DocEncoding::kBitmap);
+  EXPECT_EQ(loaded.GetPostings("rare").doc_encoding(),
+            indexing::DocEncoding::kGaps);
+
+  auto itr = list.begin();
+  itr.SkipTo(48);
+  ASSERT_EQ(itr.doc_id(), 48);
+  EXPECT_EQ(itr->tf, 1);
+  itr.SkipTo(63);
+  ASSERT_EQ(itr.doc_id(), 63);
+  EXPECT_EQ(itr->tf, 2);
+  itr.SkipTo(100);
+  EXPECT_TRUE(itr.IsEnd());
+
+  const auto both = list & loaded.GetPostings("rare");
+  EXPECT_EQ(both.size(), loaded.GetPostings("rare").size());
+}
+
+TEST_P(FileIndexStorageTest, LookupsInLoadedLexicon) {
+  FileIndexStorage storage(filename, GetParam());
+  storage.SaveIndex(index);
+  auto loaded = storage.LoadIndex();
+
+  // Before, between and after the stored terms
+  EXPECT_EQ(loaded.GetPostings("a").size(), 0);
+  EXPECT_EQ(loaded.GetPostings("commons").size(), 0);
+  EXPECT_EQ(loaded.GetPostings("zzz").size(), 0);
+  EXPECT_EQ(loaded.GetPostings("word").size(), 100);
+  EXPECT_EQ(&loaded.GetPostings("rare"), &loaded.GetPostings("rare"));
+  EXPECT_THROW(loaded.AddDocument(100, {"word"}), std::runtime_error);
+}
+
+TEST_P(FileIndexStorageTest, ConcurrentLookups) {
+  FileIndexStorage storage(filename, GetParam());
+  storage.SaveIndex(index);
+  const auto loaded = storage.LoadIndex();
+
+  // Every thread sees the same lists, built once whoever comes first
+  const std::vector<std::string> terms{"common", "word", "rare", "missing"};
+  std::vector<std::vector<const indexing::CompressedPostingList*>> seen(8);
+  std::vector<std::thread> threads;
+  for (auto& lists : seen) {
+    threads.emplace_back([&loaded, &terms, &lists] {
+      for (int round = 0; round < 100; ++round) {
+        for (const auto& term : terms) {
+          lists.push_back(&loaded.GetPostings(term));
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (const auto& lists : seen) {
+    ASSERT_EQ(lists.size(), 100 * terms.size());
+    for (size_t i = 0; i < lists.size(); ++i) {
+      EXPECT_EQ(lists[i], seen.front()[i % terms.size()]);
+    }
+  }
+  EXPECT_EQ(seen.front()[0]->size(), 100);
+  EXPECT_EQ(seen.front()[2]->size(), 15);
+  EXPECT_EQ(seen.front()[3]->size(), 0);
+}
+
+TEST_P(FileIndexStorageTest, RejectsUnknownFormat) {
+  std::ofstream(filename, std::ios::binary) << "not an index";
+  FileIndexStorage storage(filename, GetParam());
+  EXPECT_THROW(storage.LoadIndex(), std::runtime_error);
+}
+
+TEST_P(FileIndexStorageTest, Deletions) {
+  FileIndexStorage storage(filename, GetParam());
+  storage.SaveIndex(index);
+  {
+    auto loaded = storage.LoadIndex();
+    EXPECT_TRUE(loaded.Delete(7));
+    EXPECT_TRUE(loaded.Delete(8));
+    storage.SaveDeletions(loaded);
+  }
+
+  auto loaded = storage.LoadIndex();
+  EXPECT_EQ(loaded.GetDeletedCount(), 2);
+  EXPECT_TRUE(loaded.IsDeleted(7));
+  EXPECT_FALSE(loaded.IsDeleted(14));
+  // Lists are only marked until rewritten
+  EXPECT_EQ(loaded.GetPostings("rare").size(), 15);
+
+  // The loaded lists are views of the file, so it's saved elsewhere
+  auto purged_filename = filename;
+  purged_filename += ".purged";
+  FileIndexStorage purged_storage(purged_filename, GetParam());
+  purged_storage.SaveIndex(loaded);
+  const auto purged = purged_storage.LoadIndex();
+  purged_storage.Remove();
+  EXPECT_EQ(purged.GetDeletedCount(), 0);
+  EXPECT_EQ(purged.GetDocLength(7), 0);
+  EXPECT_EQ(purged.GetPostings("rare").size(), 14);
+  EXPECT_EQ(purged.GetPostings("common").size(), 98);
+  EXPECT_EQ(purged.GetPostings("rare").skip_step(),
+            index.GetPostings("rare").skip_step());
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    LoadModes, FileIndexStorageTest,
+    ::testing::Values(FileIndexStorage::LoadMode::kMmap,
+                      FileIndexStorage::LoadMode::kRead));
+
+TEST(FileIndexStorageMergeTest, MergeRuns) {
+  const auto dir = std::filesystem::temp_directory_path();
+  const auto filename = dir / "file_index_storage_merge_test.bin";
+
+  indexing::InvertedIndex expected;
+  std::vector<indexing::InvertedIndex> parts(3);
+  for (indexing::DocID doc_id = 0; doc_id < 200; ++doc_id) {
+    std::vector<std::string> terms{"all", "term" + std::to_string(doc_id % 7),
+                                   "all"};
+    expected.AddDocument(doc_id, terms);
+    parts[doc_id / 10 % parts.size()].AddDocument(doc_id, terms);
+  }
+  expected.BuildSkips();
+
+  std::vector<std::filesystem::path> runs;
+  for (size_t i = 0; i < parts.size(); ++i) {
+    runs.push_back(dir / ("file_index_storage_run_" + std::to_string(i)));
+    FileIndexStorage(runs.back()).SaveIndex(parts[i]);
+  }
+
+  FileIndexStorage storage(filename);
+  storage.MergeRuns(runs, indexing::CodecType::kVByte);
+  const auto merged = storage.LoadIndex();
+
+  ASSERT_EQ(merged.GetDocsCount(), expected.GetDocsCount());
+  EXPECT_EQ(merged.GetDocLength(199), 3);
+  for (const std::string term : {"all", "term0", "term3", "term6"}) {
+    const auto& expected_list = expected.GetPostings(term);
+    const auto& merged_list = merged.GetPostings(term);
+    ASSERT_EQ(merged_list.size(), expected_list.size());
+    EXPECT_EQ(merged_list.skip_step(), expected_list.skip_step());
+
+    auto jtr = merged_list.begin();
+    for (auto itr = expected_list.begin(); itr != expected_list.end();
+         ++itr, ++jtr) {
+      ASSERT_NE(jtr, merged_list.end());
+      EXPECT_EQ(jtr->doc_id, itr->doc_id);
+      EXPECT_EQ(jtr->tf, itr->tf);
+    }
+  }
+
+  auto itr = merged.GetPostings("term3").begin();
+  itr.SkipTo(100);
+  EXPECT_EQ(itr->doc_id, 101);
+
+  for (const auto& run : runs) {
+    std::filesystem::remove(run);
+  }
+  std::filesystem::remove(filename);
+}
+
+TEST(FileIndexStorageMergeTest, MergeRunsPurgesDeletions) {
+  const auto dir = std::filesystem::temp_directory_path();
+  const auto filename = dir / "file_index_storage_purge_test.bin";
+  const auto old_run = dir / "file_index_storage_old_run.bin";
+  const auto new_run = dir / "file_index_storage_new_run.bin";
+
+  // Document 1 is replaced by a newer version in the second run
+  indexing::InvertedIndex old_part;
+  old_part.AddDocument(0, {"stale", "page"});
+  old_part.AddDocument(1, {"stale", "page"});
+  FileIndexStorage(old_run).SaveIndex(old_part);
+  old_part = FileIndexStorage(old_run).LoadIndex();
+  old_part.Delete(1);
+  FileIndexStorage(old_run).SaveDeletions(old_part);
+
+  indexing::InvertedIndex new_part;
+  new_part.AddDocument(1, {"fresh", "page", "text"});
+  FileIndexStorage(new_run).SaveIndex(new_part);
+
+  FileIndexStorage storage(filename);
+  storage.MergeRuns({old_run, new_run}, indexing::CodecType::kVByte);
+  const auto merged = storage.LoadIndex();
+  EXPECT_EQ(merged.GetDocLength(1), 3);
+  EXPECT_EQ(merged.GetPostings("stale").size(), 1);
+  EXPECT_EQ(merged.GetPostings("page").size(), 2);
+  EXPECT_EQ(merged.GetPostings("fresh").size(), 1);
+
+  FileIndexStorage(old_run).Remove();
+  FileIndexStorage(new_run).Remove();
+  FileIndexStorage(filename).Remove();
+}
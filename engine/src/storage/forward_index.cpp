@@ -0,0 +1,314 @@
+#include "storage/forward_index.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "engine/indexing/codec.h"
+#include "storage/mapped_file.h"
+
+namespace {
+
+// On-disk layout, a pair of append-only files:
+//
+//   <path>          a record per added document: a Checkpoint per block of
+//                   kBlockSize tokens followed by the VByte-coded pairs of
+//                   (gap from the end of the previous token, length)
+//   <path>.entries  Header followed by a DiskEntry per record
+//
+// Records are written before their entries and a document added again
+// replaces its earlier record.
+constexpr uint64_t kMagic = 0x5844574649525349;  // "ISRIFWDX"
+constexpr uint32_t kVersion = 1;
+// Buffered records are written once they grow past it
+constexpr size_t kFlushThreshold = 1 << 20;
+
+struct Header {
+  uint64_t magic;
+  uint32_t version;
+  // Zero
+  uint32_t padding;
+};
+static_assert(sizeof(Header) == 16);
+
+struct DiskEntry {
+  int32_t doc_id;
+  uint32_t tokens_count;
+  uint32_t size;
+  // Zero
+  uint32_t padding;
+  uint64_t offset;
+};
+static_assert(sizeof(DiskEntry) == 24);
+
+struct Checkpoint {
+  // Of the block in the coded pairs
+  uint32_t offset;
+  // End of the token before the block
+  uint32_t prev_end;
+};
+static_assert(sizeof(Checkpoint) == 8);
+
+std::runtime_error SystemError(const std::string& what,
+                               const std::filesystem::path& path) {
+  return std::runtime_error("ForwardIndex: " + what + " " + path.string() +
+                            ": " + std::strerror(errno));
+}
+
+void WriteAll(int fd, const void* data, size_t size,
+              const std::filesystem::path& path) {
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  for (size_t written = 0; written < size;) {
+    const auto count = write(fd, bytes + written, size - written);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      throw SystemError("can't write", path);
+    }
+    written += count;
+  }
+}
+
+std::filesystem::path EntriesPath(const std::filesystem::path& path) {
+  return std::filesystem::path(path) += ".entries";
+}
+
+}  // namespace
+
+namespace storage {
+
+ForwardIndex::ForwardIndex(const std::filesystem::path& path) : path_(path) {
+  data_fd_ = open(path_.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+  if (data_fd_ < 0) {
+    throw SystemError("can't open", path_);
+  }
+  entries_fd_ =
+      open(EntriesPath(path_).c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+  if (entries_fd_ < 0) {
+    close(data_fd_);
+    throw SystemError("can't open", EntriesPath(path_));
+  }
+  try {
+    Open(false);
+  } catch (...) {
+    close(data_fd_);
+    close(entries_fd_);
+    throw;
+  }
+}
+
+ForwardIndex::~ForwardIndex() {
+  close(data_fd_);
+  close(entries_fd_);
+}
+
+void ForwardIndex::Open(bool truncate) {
+  const auto file = MappedFile::Read(EntriesPath(path_));
+  const auto data = file->data();
+  Header header{};
+  if (data.size() >= sizeof(header)) {
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (!truncate &&
+        (header.magic != kMagic || header.version != kVersion)) {
+      throw std::runtime_error("ForwardIndex: not a forward index: " +
+                               path_.string());
+    }
+  }
+
+  entries_.clear();
+  if (truncate || data.size() < sizeof(header)) {
+    if (ftruncate(data_fd_, 0) != 0 || ftruncate(entries_fd_, 0) != 0) {
+      throw SystemError("can't truncate", path_);
+    }
+    header = {};
+    header.magic = kMagic;
+    header.version = kVersion;
+    WriteAll(entries_fd_, &header, sizeof(header), EntriesPath(path_));
+    data_size_ = 0;
+    return;
+  }
+
+  // Drops a torn entry of an interrupted append
+  const size_t count = (data.size() - sizeof(header)) / sizeof(DiskEntry);
+  if (ftruncate(entries_fd_, sizeof(header) + count * sizeof(DiskEntry)) !=
+      0) {
+    throw SystemError("can't truncate", EntriesPath(path_));
+  }
+  entries_.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    DiskEntry entry;
+    std::memcpy(&entry, data.data() + sizeof(header) + i * sizeof(entry),
+                sizeof(entry));
+    entries_[entry.doc_id] = {entry.offset, entry.size, entry.tokens_count};
+  }
+
+  struct stat st;
+  if (fstat(data_fd_, &st) != 0) {
+    throw SystemError("can't stat", path_);
+  }
+  data_size_ = static_cast<uint64_t>(st.st_size);
+}
+
+void ForwardIndex::Clear() {
+  std::lock_guard append_lock(append_mutex_);
+  std::unique_lock lock(mutex_);
+  pending_data_.clear();
+  pending_.clear();
+  Open(true);
+}
+
+void ForwardIndex::Add(int32_t doc_id,
+                       const std::vector<linguistics::TokenSpan>& spans) {
+  const auto& codec = indexing::GetCodec(indexing::CodecType::kVByte);
+
+  const size_t blocks = (spans.size() + kBlockSize - 1) / kBlockSize;
+  std::vector<Checkpoint> checkpoints(blocks);
+  std::vector<uint8_t> pairs;
+  std::vector<uint32_t> values;
+  uint32_t prev_end = 0;
+  for (size_t block = 0; block < blocks; ++block) {
+    checkpoints[block] = {static_cast<uint32_t>(pairs.size()), prev_end};
+    values.clear();
+    const size_t end = std::min(spans.size(), (block + 1) * kBlockSize);
+    for (size_t i = block * kBlockSize; i < end; ++i) {
+      if (spans[i].begin < prev_end || spans[i].end < spans[i].begin) {
+        throw std::invalid_argument("ForwardIndex: unordered token ranges");
+      }
+      values.push_back(spans[i].begin - prev_end);
+      values.push_back(spans[i].end - spans[i].begin);
+      prev_end = spans[i].end;
+    }
+    codec.Encode(values, pairs);
+  }
+
+  std::lock_guard lock(append_mutex_);
+  const Entry entry{
+      .offset = data_size_ + pending_data_.size(),
+      .size = static_cast<uint32_t>(blocks * sizeof(Checkpoint) +
+                                    pairs.size()),
+      .tokens_count = static_cast<uint32_t>(spans.size())};
+  pending_data_.append(reinterpret_cast<const char*>(checkpoints.data()),
+                       blocks * sizeof(Checkpoint));
+  pending_data_.append(reinterpret_cast<const char*>(pairs.data()),
+                       pairs.size());
+  pending_.emplace_back(doc_id, entry);
+  if (pending_data_.size() >= kFlushThreshold) {
+    FlushLocked();
+  }
+}
+
+void ForwardIndex::Flush() {
+  std::lock_guard lock(append_mutex_);
+  FlushLocked();
+}
+
+void ForwardIndex::FlushLocked() {
+  if (pending_.empty()) {
+    return;
+  }
+  std::vector<DiskEntry> disk_entries;
+  disk_entries.reserve(pending_.size());
+  for (const auto& [doc_id, entry] : pending_) {
+    DiskEntry disk_entry{};
+    disk_entry.doc_id = doc_id;
+    disk_entry.tokens_count = entry.tokens_count;
+    disk_entry.size = entry.size;
+    disk_entry.offset = entry.offset;
+    disk_entries.push_back(disk_entry);
+  }
+  WriteAll(data_fd_, pending_data_.data(), pending_data_.size(), path_);
+  WriteAll(entries_fd_, disk_entries.data(),
+           disk_entries.size() * sizeof(DiskEntry), EntriesPath(path_));
+  data_size_ += pending_data_.size();
+
+  std::unique_lock lock(mutex_);
+  for (const auto& [doc_id, entry] : pending_) {
+    entries_[doc_id] = entry;
+  }
+  pending_data_.clear();
+  pending_.clear();
+}
+
+std::optional<std::vector<linguistics::TokenSpan>> ForwardIndex::GetSpans(
+    int32_t doc_id, size_t first, size_t last) const {
+  Entry entry;
+  {
+    std::shared_lock lock(mutex_);
+    const auto it = entries_.find(doc_id);
+    if (it == entries_.end()) {
+      return std::nullopt;
+    }
+    entry = it->second;
+  }
+  last = std::min<size_t>(last, entry.tokens_count);
+  if (first >= last) {
+    return std::vector<linguistics::TokenSpan>();
+  }
+
+  // Only the blocks holding the window are read
+  const size_t blocks = (entry.tokens_count + kBlockSize - 1) / kBlockSize;
+  const size_t first_block = first / kBlockSize;
+  const size_t end_block = (last - 1) / kBlockSize + 1;
+  std::vector<Checkpoint> checkpoints(std::min(end_block + 1, blocks) -
+                                      first_block);
+  ReadAt(checkpoints.data(), checkpoints.size() * sizeof(Checkpoint),
+         entry.offset + first_block * sizeof(Checkpoint));
+  const size_t pairs_size = entry.size - blocks * sizeof(Checkpoint);
+  const size_t begin = checkpoints.front().offset;
+  const size_t end = end_block < blocks ? checkpoints.back().offset
+                                        : pairs_size;
+  if (begin > end || end > pairs_size) {
+    throw std::runtime_error("ForwardIndex: corrupted record for id: " +
+                             std::to_string(doc_id));
+  }
+  std::vector<uint8_t> pairs(end - begin);
+  ReadAt(pairs.data(), pairs.size(),
+         entry.offset + blocks * sizeof(Checkpoint) + begin);
+
+  const size_t tokens_begin = first_block * kBlockSize;
+  const size_t tokens_end =
+      std::min<size_t>(entry.tokens_count, end_block * kBlockSize);
+  std::vector<uint32_t> values(2 * (tokens_end - tokens_begin));
+  indexing::GetCodec(indexing::CodecType::kVByte).Decode(pairs, values);
+
+  std::vector<linguistics::TokenSpan> result;
+  result.reserve(last - first);
+  uint32_t prev_end = checkpoints.front().prev_end;
+  for (size_t i = tokens_begin; i < last; ++i) {
+    const size_t value = 2 * (i - tokens_begin);
+    const uint32_t token_begin = prev_end + values[value];
+    prev_end = token_begin + values[value + 1];
+    if (i >= first) {
+      result.push_back({token_begin, prev_end});
+    }
+  }
+  return result;
+}
+
+size_t ForwardIndex::size() const {
+  std::shared_lock lock(mutex_);
+  return entries_.size();
+}
+
+void ForwardIndex::ReadAt(void* data, size_t size, uint64_t offset) const {
+  auto* bytes = static_cast<uint8_t*>(data);
+  for (size_t read = 0; read < size;) {
+    const auto count = pread(data_fd_, bytes + read, size - read,
+                             static_cast<off_t>(offset + read));
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      throw SystemError("can't read", path_);
+    }
+    read += count;
+  }
+}
+
+}  // namespace storage
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "linguistics/tokenization/tokenizer.h"
+
+namespace storage {
+
+// Byte ranges of the terms of every indexed document, so snippets are cut
+// from the stored text without tokenizing it again. Like a document file
+// it's a pair of append-only files, the ranges are delta-coded with a
+// checkpoint every kBlockSize tokens, so a window of tokens is read and
+// decoded on its own. Safe to use from concurrent threads.
+class ForwardIndex {
+ public:
+  static constexpr size_t kBlockSize = 64;
+
+  explicit ForwardIndex(const std::filesystem::path& path);
+  ~ForwardIndex();
+
+  ForwardIndex(const ForwardIndex&) = delete;
+  ForwardIndex& operator=(const ForwardIndex&) = delete;
+
+  // Drops every document
+  void Clear();
+  // Replaces the ranges of the document. They are visible after the next
+  // Flush(), or earlier once enough documents are buffered.
+  void Add(int32_t doc_id, const std::vector<linguistics::TokenSpan>& spans);
+  void Flush();
+
+  // Ranges of the tokens in [first, last) of the document, fewer if it's
+  // shorter. Nothing if the document isn't in the index.
+  std::optional<std::vector<linguistics::TokenSpan>> GetSpans(
+      int32_t doc_id, size_t first, size_t last) const;
+
+  size_t size() const;
+
+ private:
+  struct Entry {
+    uint64_t offset;
+    uint32_t size;
+    uint32_t tokens_count;
+  };
+
+  // Starts a new file unless a valid one exists or when `truncate` is set
+  void Open(bool truncate);
+  void FlushLocked();
+  void ReadAt(void* data, size_t size, uint64_t offset) const;
+
+  const std::filesystem::path path_;
+  int data_fd_ = -1;
+  int entries_fd_ = -1;
+
+  // Guards the published entries
+  mutable std::shared_mutex mutex_;
+  std::unordered_map<int32_t, Entry> entries_;
+
+  // Guards the appends
+  std::mutex append_mutex_;
+  uint64_t data_size_ = 0;
+  std::string pending_data_;
+  std::vector<std::pair<int32_t, Entry>> pending_;
+};
+
+}  // namespace storage
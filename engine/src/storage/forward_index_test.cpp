@@ -0,0 +1,127 @@
+#include "storage/forward_index.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <thread>
+
+using linguistics::TokenSpan;
+using storage::ForwardIndex;
+
+class ForwardIndexTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    path = std::filesystem::temp_directory_path() /
+           ("forward_index_test_" + std::to_string(getpid()) + ".bin");
+  }
+
+  void TearDown() override {
+    std::filesystem::remove(path);
+    std::filesystem::remove(std::filesystem::path(path) += ".entries");
+  }
+
+  // Tokens of growing length separated by growing gaps
+  static std::vector<TokenSpan> MakeSpans(size_t count, uint32_t seed) {
+    std::vector<TokenSpan> spans;
+    uint32_t end = seed;
+    for (size_t i = 0; i < count; ++i) {
+      const uint32_t begin = end + 1 + i % 3;
+      end = begin + 1 + (i + seed) % 200;
+      spans.push_back({begin, end});
+    }
+    return spans;
+  }
+
+  static std::vector<TokenSpan> Slice(const std::vector<TokenSpan>& spans,
+                                      size_t first, size_t last) {
+    last = std::min(last, spans.size());
+    return {spans.begin() + std::min(first, last), spans.begin() + last};
+  }
+
+  std::filesystem::path path;
+};
+
+TEST_F(ForwardIndexTest, Windows) {
+  const auto spans = MakeSpans(300, 7);
+  ForwardIndex index(path);
+  index.Add(5, spans);
+  index.Add(6, {});
+  EXPECT_FALSE(index.GetSpans(5, 0, 1).has_value());
+  index.Flush();
+
+  // Windows within, across and past the blocks
+  for (const auto& [first, last] : std::vector<std::pair<size_t, size_t>>{
+           {0, 1}, {0, 300}, {10, 27}, {60, 70}, {64, 128}, {250, 400},
+           {299, 300}, {300, 310}}) {
+    const auto actual = index.GetSpans(5, first, last);
+    ASSERT_TRUE(actual.has_value());
+    EXPECT_EQ(*actual, Slice(spans, first, last)) << first << " " << last;
+  }
+  EXPECT_EQ(index.GetSpans(6, 0, 10), std::vector<TokenSpan>());
+  EXPECT_FALSE(index.GetSpans(7, 0, 10).has_value());
+}
+
+TEST_F(ForwardIndexTest, ReopenAndReplace) {
+  {
+    ForwardIndex index(path);
+    for (int32_t doc_id = 0; doc_id < 20; ++doc_id) {
+      index.Add(doc_id, MakeSpans(doc_id * 10, doc_id));
+    }
+    index.Flush();
+    index.Add(3, MakeSpans(100, 1000));
+    index.Flush();
+  }
+
+  ForwardIndex index(path);
+  EXPECT_EQ(index.size(), 20);
+  EXPECT_EQ(*index.GetSpans(3, 0, 100), MakeSpans(100, 1000));
+  EXPECT_EQ(*index.GetSpans(19, 50, 120), Slice(MakeSpans(190, 19), 50, 120));
+
+  index.Clear();
+  EXPECT_EQ(index.size(), 0);
+  EXPECT_FALSE(index.GetSpans(3, 0, 10).has_value());
+  index.Add(3, MakeSpans(5, 1));
+  index.Flush();
+  EXPECT_EQ(ForwardIndex(path).GetSpans(3, 0, 10), MakeSpans(5, 1));
+}
+
+TEST_F(ForwardIndexTest, IgnoresTornAppend) {
+  {
+    ForwardIndex index(path);
+    index.Add(1, MakeSpans(10, 1));
+    index.Flush();
+  }
+  {
+    std::ofstream entries(std::filesystem::path(path) += ".entries",
+                          std::ios::binary | std::ios::app);
+    entries << "torn";
+  }
+  ForwardIndex index(path);
+  index.Add(2, MakeSpans(10, 2));
+  index.Flush();
+  EXPECT_EQ(ForwardIndex(path).size(), 2);
+  EXPECT_EQ(ForwardIndex(path).GetSpans(2, 0, 10), MakeSpans(10, 2));
+}
+
+TEST_F(ForwardIndexTest, ConcurrentAdds) {
+  ForwardIndex index(path);
+  std::vector<std::thread> threads;
+  for (int32_t thread = 0; thread < 4; ++thread) {
+    threads.emplace_back([&index, thread] {
+      for (int32_t doc_id = thread; doc_id < 400; doc_id += 4) {
+        index.Add(doc_id, MakeSpans(doc_id % 100, doc_id));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  index.Flush();
+  EXPECT_EQ(index.size(), 400);
+  EXPECT_EQ(*index.GetSpans(397, 0, 100), MakeSpans(97, 397));
+}
+
+TEST_F(ForwardIndexTest, RejectsUnorderedSpans) {
+  ForwardIndex index(path);
+  EXPECT_THROW(index.Add(1, {{5, 10}, {7, 12}}), std::invalid_argument);
+}
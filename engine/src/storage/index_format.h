@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+
+namespace storage {
+
+// On-disk layout of an index file:
+//
+//   Header
+//   postings     doc, freq and coord streams and skips of every list
+//   lexicon      LexiconEntry per term, ordered by term
+//   terms        concatenated term bytes
+//   doc lengths  uint32_t per document id from first_doc_id
+//
+// All offsets are absolute file offsets. Sections and skip arrays are 8-byte
+// aligned, so the file can be mapped and used in place. Version 4 split the
+// tfs out of the doc stream, version 5 added Elias-Fano and bitmap doc
+// streams, version 6 stores only the lengths of the ids the index spans.
+// Older files have to be rebuilt.
+namespace format {
+
+inline constexpr uint64_t kMagic = 0x5844494e49525349;  // "ISRINIDX"
+inline constexpr uint32_t kVersion = 6;
+inline constexpr uint64_t kAlignment = 8;
+
+struct Header {
+  uint64_t magic;
+  uint32_t version;
+  // indexing::CodecType the index was built with
+  uint32_t codec;
+  uint64_t terms_count;
+  uint64_t first_doc_id;
+  // Document ids spanned from first_doc_id
+  uint64_t docs_count;
+  uint64_t lexicon_offset;
+  uint64_t terms_offset;
+  uint64_t doc_lengths_offset;
+  uint64_t file_size;
+};
+static_assert(sizeof(Header) == 72);
+
+// List-level stats come first, so they are available without touching the
+// postings.
+struct LexiconEntry {
+  uint64_t term_offset;
+  uint32_t term_size;
+  uint32_t doc_freq;
+  uint32_t max_tf;
+  uint32_t min_doc_length;
+  uint32_t skip_step;
+  // indexing::CodecType of the list, lists without skips are VByte
+  uint32_t codec;
+  // indexing::DocEncoding of the doc stream
+  uint32_t doc_encoding;
+  // Zero, keeps the offsets aligned
+  uint32_t padding;
+  uint64_t doc_offset;
+  uint64_t doc_size;
+  uint64_t freq_offset;
+  uint64_t freq_size;
+  uint64_t coord_offset;
+  uint64_t coord_size;
+  uint64_t skips_offset;
+  uint64_t skips_count;
+};
+static_assert(sizeof(LexiconEntry) == 104);
+
+}  // namespace format
+
+}  // namespace storage
@@ -0,0 +1,132 @@
+#include "storage/index_reader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+template <typename T>
+std::span<const T> GetSection(std::span<const uint8_t> data, uint64_t offset,
+                              uint64_t count) {
+  if (offset > data.size() || count > (data.size() - offset) / sizeof(T) ||
+      offset % alignof(T) != 0) {
+    throw std::runtime_error("IndexReader: corrupted index file");
+  }
+  return {reinterpret_cast<const T*>(data.data() + offset), count};
+}
+
+bool IsKnownCodec(uint32_t codec) {
+  return codec <= static_cast<uint32_t>(indexing::CodecType::kBitPacking);
+}
+
+bool IsKnownDocEncoding(uint32_t doc_encoding) {
+  return doc_encoding <=
+         static_cast<uint32_t>(indexing::DocEncoding::kBitmap);
+}
+
+}  // namespace
+
+namespace storage {
+
+IndexReader::IndexReader(std::shared_ptr<MappedFile> file)
+    : file_(std::move(file)) {
+  const auto data = file_->data();
+
+  format::Header header;
+  if (data.size() < sizeof(header)) {
+    throw std::runtime_error("IndexReader: corrupted index file");
+  }
+  std::memcpy(&header, data.data(), sizeof(header));
+  if (header.magic != format::kMagic || header.version != format::kVersion ||
+      !IsKnownCodec(header.codec)) {
+    throw std::runtime_error("IndexReader: unsupported index format");
+  }
+  if (header.file_size != data.size() ||
+      header.first_doc_id + header.docs_count > UINT32_MAX + 1ull) {
+    throw std::runtime_error("IndexReader: corrupted index file");
+  }
+
+  lexicon_ = GetSection<format::LexiconEntry>(data, header.lexicon_offset,
+                                              header.terms_count);
+  first_doc_id_ = static_cast<indexing::DocID>(header.first_doc_id);
+  doc_lengths_ = GetSection<uint32_t>(data, header.doc_lengths_offset,
+                                      header.docs_count);
+  codec_ = static_cast<indexing::CodecType>(header.codec);
+}
+
+size_t IndexReader::terms_count() const { return lexicon_.size(); }
+
+std::string_view IndexReader::GetTerm(size_t idx) const {
+  const auto& entry = lexicon_[idx];
+  const auto term =
+      GetSection<char>(file_->data(), entry.term_offset, entry.term_size);
+  return {term.data(), term.size()};
+}
+
+std::optional<size_t> IndexReader::Find(std::string_view term) const {
+  size_t begin = 0;
+  size_t end = lexicon_.size();
+  while (begin < end) {
+    const size_t mid = begin + (end - begin) / 2;
+    if (GetTerm(mid) < term) {
+      begin = mid + 1;
+    } else {
+      end = mid;
+    }
+  }
+  if (begin == lexicon_.size() || GetTerm(begin) != term) {
+    return std::nullopt;
+  }
+  return begin;
+}
+
+indexing::CompressedPostingList IndexReader::GetPostings(size_t idx) const {
+  const auto& entry = lexicon_[idx];
+  const auto data = file_->data();
+  if (!IsKnownCodec(entry.codec) || !IsKnownDocEncoding(entry.doc_encoding)) {
+    throw std::runtime_error("IndexReader: unsupported index format");
+  }
+  // Blocks of a list span its skip steps
+  const auto codec = static_cast<indexing::CodecType>(entry.codec);
+  const auto doc_encoding =
+      static_cast<indexing::DocEncoding>(entry.doc_encoding);
+  if ((codec != indexing::CodecType::kVByte ||
+       doc_encoding != indexing::DocEncoding::kGaps) &&
+      (entry.skip_step == 0
+           ? entry.doc_freq > 0
+           : entry.skips_count !=
+                 (entry.doc_freq + entry.skip_step - 1) / entry.skip_step)) {
+    throw std::runtime_error("IndexReader: corrupted index file");
+  }
+
+  indexing::CompressedPostingList posting_list;
+  posting_list.is_view_ = true;
+  posting_list.size_ = entry.doc_freq;
+  posting_list.max_tf_ = entry.max_tf;
+  posting_list.min_doc_length_ = entry.min_doc_length;
+  posting_list.skip_step_ = entry.skip_step;
+  posting_list.codec_ = codec;
+  posting_list.doc_encoding_ = doc_encoding;
+  posting_list.doc_view_ =
+      GetSection<uint8_t>(data, entry.doc_offset, entry.doc_size);
+  posting_list.freq_view_ =
+      GetSection<uint8_t>(data, entry.freq_offset, entry.freq_size);
+  posting_list.coord_view_ =
+      GetSection<uint8_t>(data, entry.coord_offset, entry.coord_size);
+  posting_list.skips_view_ = GetSection<indexing::CompressedPostingList::Skip>(
+      data, entry.skips_offset, entry.skips_count);
+  return posting_list;
+}
+
+indexing::DocID IndexReader::first_doc_id() const { return first_doc_id_; }
+
+std::span<const uint32_t> IndexReader::doc_lengths() const {
+  return doc_lengths_;
+}
+
+indexing::CodecType IndexReader::codec() const { return codec_; }
+
+const std::shared_ptr<MappedFile>& IndexReader::file() const { return file_; }
+
+}  // namespace storage
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#include "engine/indexing/compressed_posting_list.h"
+#include "storage/index_format.h"
+#include "storage/mapped_file.h"
+
+namespace storage {
+
+// Read access to an index file in place. Terms are visited in lexicon
+// order, posting lists are views into the file.
+class IndexReader {
+ public:
+  explicit IndexReader(std::shared_ptr<MappedFile> file);
+
+  size_t terms_count() const;
+  std::string_view GetTerm(size_t idx) const;
+  // Binary search of the sorted lexicon
+  std::optional<size_t> Find(std::string_view term) const;
+  // The list is valid while the file is alive
+  indexing::CompressedPostingList GetPostings(size_t idx) const;
+
+  indexing::DocID first_doc_id() const;
+  // Lengths of the documents from first_doc_id()
+  std::span<const uint32_t> doc_lengths() const;
+  indexing::CodecType codec() const;
+  const std::shared_ptr<MappedFile>& file() const;
+
+ private:
+  std::shared_ptr<MappedFile> file_;
+  std::span<const format::LexiconEntry> lexicon_;
+  indexing::DocID first_doc_id_;
+  std::span<const uint32_t> doc_lengths_;
+  indexing::CodecType codec_;
+};
+
+}  // namespace storage
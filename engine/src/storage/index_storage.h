@@ -1,5 +1,10 @@
 #pragma once
 
+#include <filesystem>
+#include <vector>
+
+#include "engine/indexing/codec.h"
+
 namespace indexing {
 class InvertedIndex;
 }
@@ -10,6 +15,13 @@ class IndexStorage {
  public:
   virtual void SaveIndex(const indexing::InvertedIndex&) = 0;
   virtual indexing::InvertedIndex LoadIndex() = 0;
+  // Saves the index merged from partial indexes previously saved to `runs`
+  // by FileIndexStorage, without loading them into memory at once. Merged
+  // lists are encoded with `codec`.
+  virtual void MergeRuns(const std::vector<std::filesystem::path>& runs,
+                         indexing::CodecType codec) = 0;
+  // Persists the deletions made since the index was saved or loaded
+  virtual void SaveDeletions(const indexing::InvertedIndex&) = 0;
 };
 
 }  // namespace storage
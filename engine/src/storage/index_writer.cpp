@@ -0,0 +1,122 @@
+#include "storage/index_writer.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+
+#include "engine/indexing/compressed_posting_list.h"
+
+namespace storage {
+
+IndexWriter::IndexWriter(const std::filesystem::path& filename)
+    : file_(filename, std::ios::out | std::ios::binary | std::ios::trunc) {
+  if (!file_.is_open()) {
+    throw std::runtime_error("IndexWriter: can't open file");
+  }
+  // Patched by Finish()
+  const format::Header header{};
+  Write(&header, sizeof(header));
+}
+
+void IndexWriter::AddList(const std::string& term,
+                          const indexing::CompressedPostingList& list) {
+  format::LexiconEntry entry{};
+  entry.term_offset = terms_.size();
+  entry.term_size = static_cast<uint32_t>(term.size());
+  entry.doc_freq = static_cast<uint32_t>(list.size());
+  entry.max_tf = list.max_tf_;
+  entry.min_doc_length = list.min_doc_length_;
+  entry.skip_step = static_cast<uint32_t>(list.skip_step_);
+  entry.codec = static_cast<uint32_t>(list.codec_);
+  entry.doc_encoding = static_cast<uint32_t>(list.doc_encoding_);
+  terms_ += term;
+
+  const auto doc_data = list.DocData();
+  entry.doc_offset = offset_;
+  entry.doc_size = doc_data.size();
+  Write(doc_data.data(), doc_data.size());
+
+  const auto freq_data = list.FreqData();
+  entry.freq_offset = offset_;
+  entry.freq_size = freq_data.size();
+  Write(freq_data.data(), freq_data.size());
+
+  const auto coord_data = list.CoordData();
+  entry.coord_offset = offset_;
+  entry.coord_size = coord_data.size();
+  Write(coord_data.data(), coord_data.size());
+
+  const auto skips = list.Skips();
+  Align();
+  entry.skips_offset = offset_;
+  entry.skips_count = skips.size();
+  Write(skips.data(), skips.size_bytes());
+
+  lexicon_.push_back(entry);
+}
+
+void IndexWriter::Finish(
+    const indexing::DocLengths& doc_lengths,
+    indexing::CodecType codec /* = indexing::CodecType::kVByte */) {
+  const auto term = [this](const format::LexiconEntry& entry) {
+    return std::string_view(terms_).substr(entry.term_offset, entry.term_size);
+  };
+  std::sort(lexicon_.begin(), lexicon_.end(),
+            [&term](const auto& lhs, const auto& rhs) {
+              return term(lhs) < term(rhs);
+            });
+
+  format::Header header{};
+  header.magic = format::kMagic;
+  header.version = format::kVersion;
+  header.codec = static_cast<uint32_t>(codec);
+  header.terms_count = lexicon_.size();
+  header.first_doc_id = doc_lengths.first_doc_id();
+  header.docs_count = doc_lengths.values().size();
+
+  // Terms follow the lexicon in the same order
+  std::string sorted_terms;
+  sorted_terms.reserve(terms_.size());
+  Align();
+  header.lexicon_offset = offset_;
+  header.terms_offset =
+      offset_ + sizeof(format::LexiconEntry) * lexicon_.size();
+  for (auto& entry : lexicon_) {
+    const auto term_offset = sorted_terms.size();
+    sorted_terms += term(entry);
+    entry.term_offset = header.terms_offset + term_offset;
+  }
+  Write(lexicon_.data(), sizeof(format::LexiconEntry) * lexicon_.size());
+  Write(sorted_terms.data(), sorted_terms.size());
+
+  Align();
+  header.doc_lengths_offset = offset_;
+  Write(doc_lengths.values().data(),
+        sizeof(uint32_t) * doc_lengths.values().size());
+  header.file_size = offset_;
+
+  file_.seekp(0, std::ios::beg);
+  file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file_.flush();
+  if (!file_) {
+    throw std::runtime_error("IndexWriter: can't write file");
+  }
+}
+
+void IndexWriter::Write(const void* data, size_t size) {
+  file_.write(reinterpret_cast<const char*>(data), size);
+  if (!file_) {
+    throw std::runtime_error("IndexWriter: can't write file");
+  }
+  offset_ += size;
+}
+
+void IndexWriter::Align() {
+  static constexpr char kPadding[format::kAlignment] = {};
+  const auto rest = offset_ % format::kAlignment;
+  if (rest != 0) {
+    Write(kPadding, format::kAlignment - rest);
+  }
+}
+
+}  // namespace storage
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "engine/indexing/codec.h"
+#include "engine/indexing/doc_lengths.h"
+#include "storage/index_format.h"
+
+namespace indexing {
+class CompressedPostingList;
+}
+
+namespace storage {
+
+// Streams posting lists into an index file. Lists are written as they come,
+// only the lexicon is kept in memory until Finish().
+class IndexWriter {
+ public:
+  explicit IndexWriter(const std::filesystem::path& filename);
+
+  void AddList(const std::string& term,
+               const indexing::CompressedPostingList& list);
+  // Writes the lexicon, the document lengths and the header
+  void Finish(const indexing::DocLengths& doc_lengths,
+              indexing::CodecType codec = indexing::CodecType::kVByte);
+
+ private:
+  void Write(const void* data, size_t size);
+  void Align();
+
+  std::ofstream file_;
+  uint64_t offset_ = 0;
+
+  std::vector<format::LexiconEntry> lexicon_;
+  std::string terms_;
+};
+
+}  // namespace storage
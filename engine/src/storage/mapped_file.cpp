@@ -0,0 +1,72 @@
+#include "storage/mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <stdexcept>
+
+namespace storage {
+
+std::shared_ptr<MappedFile> MappedFile::Map(
+    const std::filesystem::path& path) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("MappedFile: can't open " + path.string());
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    throw std::runtime_error("MappedFile: can't stat " + path.string());
+  }
+
+  std::shared_ptr<MappedFile> file(new MappedFile());
+  file->size_ = static_cast<size_t>(st.st_size);
+  if (file->size_ > 0) {
+    void* addr = mmap(nullptr, file->size_, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+      close(fd);
+      throw std::runtime_error("MappedFile: can't map " + path.string());
+    }
+    file->addr_ = addr;
+  }
+  // The mapping outlives the descriptor
+  close(fd);
+  return file;
+}
+
+std::shared_ptr<MappedFile> MappedFile::Read(
+    const std::filesystem::path& path) {
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in.is_open()) {
+    throw std::runtime_error("MappedFile: can't open " + path.string());
+  }
+
+  std::shared_ptr<MappedFile> file(new MappedFile());
+  file->buffer_.resize(static_cast<size_t>(in.tellg()));
+  in.seekg(0, std::ios::beg);
+  in.read(reinterpret_cast<char*>(file->buffer_.data()), file->buffer_.size());
+  if (!in) {
+    throw std::runtime_error("MappedFile: can't read " + path.string());
+  }
+  file->size_ = file->buffer_.size();
+  return file;
+}
+
+MappedFile::~MappedFile() {
+  if (addr_) {
+    munmap(addr_, size_);
+  }
+}
+
+std::span<const uint8_t> MappedFile::data() const {
+  if (addr_) {
+    return {static_cast<const uint8_t*>(addr_), size_};
+  }
+  return buffer_;
+}
+
+}  // namespace storage
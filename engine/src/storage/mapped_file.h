@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace storage {
+
+// Read-only contents of a file, either mapped into memory or read into an
+// owned buffer. Mapped pages are shared through the page cache across
+// processes.
+class MappedFile {
+ public:
+  static std::shared_ptr<MappedFile> Map(const std::filesystem::path& path);
+  static std::shared_ptr<MappedFile> Read(const std::filesystem::path& path);
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile();
+
+  std::span<const uint8_t> data() const;
+
+ private:
+  MappedFile() = default;
+
+  void* addr_ = nullptr;
+  size_t size_ = 0;
+  std::vector<uint8_t> buffer_;
+};
+
+}  // namespace storage
@@ -1,70 +1,146 @@
 #include "storage/mongo_doc_storage.h"
 
+#include <unordered_map>
+
+#include <bsoncxx/builder/basic/array.hpp>
 #include <bsoncxx/builder/basic/document.hpp>
 #include <bsoncxx/builder/basic/kvp.hpp>
 #include <bsoncxx/exception/exception.hpp>
 #include <bsoncxx/types.hpp>
 #include <mongocxx/exception/exception.hpp>
+#include <mongocxx/instance.hpp>
 #include <mongocxx/options/find.hpp>
 #include <mongocxx/uri.hpp>
 
 #include "storage/document.h"
 
+namespace {
+
+// The driver is initialized once per process, before the first pool
+mongocxx::uri InitDriver(const std::string& uri) {
+  static mongocxx::instance instance;
+  return mongocxx::uri{uri};
+}
+
+// The id is -1 if the document has none
+storage::Document ParseDocument(const bsoncxx::document::view& doc) {
+  storage::Document result;
+  result.id = -1;
+  if (auto el = doc["doc_id"]; el && el.type() == bsoncxx::type::k_int32) {
+    result.id = el.get_int32().value;
+  }
+  if (auto el = doc["url"]; el && el.type() == bsoncxx::type::k_string) {
+    result.url = el.get_string().value;
+  }
+  if (auto el = doc["text"]; el && el.type() == bsoncxx::type::k_string) {
+    result.text = el.get_string().value;
+  }
+  return result;
+}
+
+}  // namespace
+
 namespace storage {
 
 MongoDocStorage::MongoDocStorage(const std::string& uri,
                                  const std::string& db_name)
-    : client_(mongocxx::uri{uri}) {
+    : pool_(InitDriver(uri)), db_name_(db_name) {
   try {
-    auto database = client_[db_name];
-
-    database.run_command(bsoncxx::builder::basic::make_document(
+    auto client = pool_.acquire();
+    (*client)[db_name_].run_command(bsoncxx::builder::basic::make_document(
         bsoncxx::builder::basic::kvp("ping", 1)));
-
-    articles_ = database["articles"];
   } catch (const mongocxx::exception& e) {
     throw std::runtime_error(std::string("MongoDB connection failed: ") +
                              e.what());
   }
 }
 
-Document MongoDocStorage::GetDocByID(int32_t doc_id) {
+Document MongoDocStorage::GetDocByID(int32_t doc_id) const {
   bsoncxx::builder::basic::document filter_builder;
   filter_builder.append(bsoncxx::builder::basic::kvp("doc_id", doc_id));
 
-  auto maybe_doc = articles_.find_one(filter_builder.view());
+  auto client = pool_.acquire();
+  auto maybe_doc = GetArticles(client).find_one(filter_builder.view());
   if (!maybe_doc) {
     throw std::runtime_error("MongoDocStorage: document not found for id: " +
                              std::to_string(doc_id));
   }
 
-  auto doc_view = maybe_doc->view();
-
-  Document result;
+  auto result = ParseDocument(maybe_doc->view());
   result.id = doc_id;
+  return result;
+}
 
-  if (doc_view["url"] && doc_view["url"].type() == bsoncxx::type::k_string) {
-    result.url = doc_view["url"].get_string().value;
-  } else {
-    result.url = "";
-  }
+std::vector<Document> MongoDocStorage::GetDocsByIDs(
+    const std::vector<int32_t>& doc_ids) const {
+  using bsoncxx::builder::basic::kvp;
+  using bsoncxx::builder::basic::make_document;
 
-  if (doc_view["text"] && doc_view["text"].type() == bsoncxx::type::k_string) {
-    result.text = doc_view["text"].get_string().value;
-  } else {
-    result.text = "";
+  if (doc_ids.empty()) {
+    return {};
+  }
+  bsoncxx::builder::basic::array ids;
+  for (const auto doc_id : doc_ids) {
+    ids.append(doc_id);
+  }
+  mongocxx::options::find options;
+  options.projection(make_document(kvp("_id", 0), kvp("doc_id", 1),
+                                   kvp("url", 1), kvp("text", 1)));
+
+  auto client = pool_.acquire();
+  auto cursor = GetArticles(client).find(
+      make_document(kvp("doc_id", make_document(kvp("$in", ids.view())))),
+      options);
+  std::unordered_map<int32_t, Document> found;
+  found.reserve(doc_ids.size());
+  for (const auto& doc : cursor) {
+    auto result = ParseDocument(doc);
+    found.emplace(result.id, std::move(result));
   }
 
+  // Back to the requested order, copied as an id may repeat
+  std::vector<Document> result;
+  result.reserve(doc_ids.size());
+  for (const auto doc_id : doc_ids) {
+    if (const auto it = found.find(doc_id); it != found.end()) {
+      result.push_back(it->second);
+    }
+  }
   return result;
 }
 
 std::unique_ptr<DocStorage::Cursor> MongoDocStorage::GetCursor() const {
-  return std::make_unique<MongoDocumentCursor>(articles_);
+  auto client = pool_.acquire();
+  auto cursor = GetArticles(client).find(
+      bsoncxx::builder::basic::make_document(), mongocxx::options::find{});
+  return std::make_unique<MongoDocumentCursor>(std::move(client),
+                                               std::move(cursor));
 }
 
-MongoDocumentCursor::MongoDocumentCursor(mongocxx::collection col)
-    : cursor_(col.find(bsoncxx::builder::basic::make_document(),
-                       mongocxx::options::find{})),
+std::unique_ptr<DocStorage::Cursor> MongoDocStorage::GetCursorAfter(
+    int32_t doc_id) const {
+  using bsoncxx::builder::basic::kvp;
+  using bsoncxx::builder::basic::make_document;
+
+  mongocxx::options::find options;
+  options.sort(make_document(kvp("doc_id", 1)));
+  auto client = pool_.acquire();
+  auto cursor = GetArticles(client).find(
+      make_document(kvp("doc_id", make_document(kvp("$gt", doc_id)))),
+      options);
+  return std::make_unique<MongoDocumentCursor>(std::move(client),
+                                               std::move(cursor));
+}
+
+mongocxx::collection MongoDocStorage::GetArticles(
+    mongocxx::pool::entry& client) const {
+  return (*client)[db_name_]["articles"];
+}
+
+MongoDocumentCursor::MongoDocumentCursor(mongocxx::pool::entry client,
+                                         mongocxx::cursor cursor)
+    : client_(std::move(client)),
+      cursor_(std::move(cursor)),
       itr_opt_(std::nullopt) {}
 
 std::optional<Document> MongoDocumentCursor::Next() {
@@ -76,22 +152,10 @@ std::optional<Document> MongoDocumentCursor::Next() {
   auto& doc = *itr_opt_.value();
   ++itr_opt_.value();
 
-  Document result;
-  if (auto el = doc["doc_id"]; el && el.type() == bsoncxx::type::k_int32) {
-    result.id = el.get_int32().value;
-  }
-
+  auto result = ParseDocument(doc);
   if (result.id < 0) {
     return std::nullopt;
   }
-
-  if (auto el = doc["url"]; el && el.type() == bsoncxx::type::k_string) {
-    result.url = el.get_string().value;
-  }
-
-  if (auto el = doc["text"]; el && el.type() == bsoncxx::type::k_string) {
-    result.text = doc["text"].get_string().value;
-  }
   return result;
 }
 
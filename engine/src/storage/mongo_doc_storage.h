@@ -3,6 +3,7 @@
 #include <mongocxx/client.hpp>
 #include <mongocxx/collection.hpp>
 #include <mongocxx/cursor.hpp>
+#include <mongocxx/pool.hpp>
 
 #include "storage/doc_storage.h"
 
@@ -10,25 +11,36 @@ namespace storage {
 
 class MongoDocumentCursor : public DocStorage::Cursor {
  public:
-  MongoDocumentCursor(mongocxx::collection col);
+  // Holds the client of the cursor until it is destroyed
+  MongoDocumentCursor(mongocxx::pool::entry client, mongocxx::cursor cursor);
   std::optional<Document> Next() override;
 
  private:
+  mongocxx::pool::entry client_;
   mongocxx::cursor cursor_;
   std::optional<mongocxx::cursor::iterator> itr_opt_;
 };
 
+// Every call takes a client from a pool, so concurrent calls don't share
+// one
 class MongoDocStorage : public DocStorage {
  public:
   MongoDocStorage(const std::string& uri, const std::string& db_name);
 
   std::unique_ptr<DocStorage::Cursor> GetCursor() const override;
+  std::unique_ptr<DocStorage::Cursor> GetCursorAfter(
+      int32_t doc_id) const override;
 
-  Document GetDocByID(int32_t doc_id) override;
+  Document GetDocByID(int32_t doc_id) const override;
+  // A single query for the documents, fetching only the indexed fields
+  std::vector<Document> GetDocsByIDs(
+      const std::vector<int32_t>& doc_ids) const override;
 
  private:
-  mongocxx::client client_;
-  mongocxx::collection articles_;
+  mongocxx::collection GetArticles(mongocxx::pool::entry& client) const;
+
+  mutable mongocxx::pool pool_;
+  const std::string db_name_;
 };
 
 }  // namespace storage
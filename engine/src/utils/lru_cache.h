@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace utils {
+
+// Thread-safe cache of the most recently used values, as many as their
+// costs fit in `capacity`. A value costs 1 unless Put is given its size, a
+// zero capacity disables the cache. Values are shared, so a hit doesn't copy
+// them.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache {
+ public:
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    // Of the cached values
+    size_t cost = 0;
+  };
+
+  explicit LruCache(size_t capacity) : capacity_(capacity) {}
+
+  LruCache(const LruCache&) = delete;
+  LruCache& operator=(const LruCache&) = delete;
+
+  // Null on a miss
+  std::shared_ptr<const Value> Get(const Key& key) {
+    std::lock_guard lock(mutex_);
+    const auto itr = index_.find(key);
+    if (itr == index_.end()) {
+      ++stats_.misses;
+      return nullptr;
+    }
+    ++stats_.hits;
+    entries_.splice(entries_.begin(), entries_, itr->second);
+    return itr->second->value;
+  }
+
+  // A value computed before the last Clear is stale, Put drops it when
+  // `generation` was read before that Clear
+  uint64_t generation() const {
+    std::lock_guard lock(mutex_);
+    return generation_;
+  }
+
+  // Evicts the least recently used values until the cost fits. Returns
+  // false if the value wasn't cached, a value costing more than the whole
+  // capacity never is.
+  bool Put(const Key& key, std::shared_ptr<const Value> value,
+           uint64_t generation, size_t cost = 1) {
+    std::lock_guard lock(mutex_);
+    if (capacity_ == 0 || cost > capacity_ || generation != generation_) {
+      return false;
+    }
+    if (const auto itr = index_.find(key); itr != index_.end()) {
+      stats_.cost -= itr->second->cost;
+      entries_.erase(itr->second);
+      index_.erase(itr);
+    }
+    while (stats_.cost + cost > capacity_) {
+      stats_.cost -= entries_.back().cost;
+      index_.erase(entries_.back().key);
+      entries_.pop_back();
+      ++stats_.evictions;
+    }
+    entries_.push_front({key, std::move(value), cost});
+    index_.emplace(key, entries_.begin());
+    stats_.cost += cost;
+    return true;
+  }
+
+  void Clear() {
+    std::lock_guard lock(mutex_);
+    index_.clear();
+    entries_.clear();
+    stats_.cost = 0;
+    ++generation_;
+  }
+
+  size_t size() const {
+    std::lock_guard lock(mutex_);
+    return entries_.size();
+  }
+
+  Stats stats() const {
+    std::lock_guard lock(mutex_);
+    return stats_;
+  }
+
+ private:
+  struct Entry {
+    Key key;
+    std::shared_ptr<const Value> value;
+    size_t cost;
+  };
+
+  const size_t capacity_;
+  // From the most recently used
+  std::list<Entry> entries_;
+  std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> index_;
+  uint64_t generation_ = 0;
+  Stats stats_;
+
+  mutable std::mutex mutex_;
+};
+
+}  // namespace utils
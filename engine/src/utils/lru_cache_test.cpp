@@ -0,0 +1,102 @@
+#include "utils/lru_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace utils;
+
+namespace {
+
+std::shared_ptr<const int> Value(int value) {
+  return std::make_shared<const int>(value);
+}
+
+}  // namespace
+
+TEST(LruCacheTest, EvictsLeastRecentlyUsed) {
+  LruCache<std::string, int> cache(2);
+  cache.Put("a", Value(1), cache.generation());
+  cache.Put("b", Value(2), cache.generation());
+  ASSERT_NE(cache.Get("a"), nullptr);
+  cache.Put("c", Value(3), cache.generation());
+
+  EXPECT_EQ(cache.Get("b"), nullptr);
+  EXPECT_EQ(*cache.Get("a"), 1);
+  EXPECT_EQ(*cache.Get("c"), 3);
+
+  // Replacing a value doesn't evict
+  cache.Put("a", Value(4), cache.generation());
+  EXPECT_EQ(*cache.Get("a"), 4);
+  EXPECT_EQ(cache.size(), 2);
+
+  const auto stats = cache.stats();
+  EXPECT_EQ(stats.hits, 4);
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.evictions, 1);
+}
+
+TEST(LruCacheTest, ClearDropsStaleValues) {
+  LruCache<std::string, int> cache(4);
+  const auto before = cache.generation();
+  cache.Put("a", Value(1), before);
+  cache.Clear();
+  EXPECT_EQ(cache.Get("a"), nullptr);
+
+  // Computed before the Clear
+  cache.Put("b", Value(2), before);
+  EXPECT_EQ(cache.Get("b"), nullptr);
+  cache.Put("b", Value(3), cache.generation());
+  EXPECT_EQ(*cache.Get("b"), 3);
+}
+
+TEST(LruCacheTest, CostBudget) {
+  LruCache<std::string, int> cache(10);
+  EXPECT_TRUE(cache.Put("a", Value(1), cache.generation(), 4));
+  EXPECT_TRUE(cache.Put("b", Value(2), cache.generation(), 4));
+  ASSERT_NE(cache.Get("a"), nullptr);
+  // Evicts "b" only, "a" was used since
+  EXPECT_TRUE(cache.Put("c", Value(3), cache.generation(), 5));
+  EXPECT_EQ(cache.Get("b"), nullptr);
+  EXPECT_EQ(*cache.Get("a"), 1);
+  EXPECT_EQ(cache.stats().cost, 9);
+
+  EXPECT_FALSE(cache.Put("d", Value(4), cache.generation(), 11));
+  EXPECT_EQ(cache.size(), 2);
+  cache.Clear();
+  EXPECT_EQ(cache.stats().cost, 0);
+}
+
+TEST(LruCacheTest, ZeroCapacity) {
+  LruCache<int, int> cache(0);
+  cache.Put(1, Value(1), cache.generation());
+  EXPECT_EQ(cache.Get(1), nullptr);
+  EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(LruCacheTest, Concurrent) {
+  constexpr int kThreads = 4;
+  constexpr int kKeys = 64;
+  LruCache<int, int> cache(kKeys / 2);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&cache, t] {
+      for (int i = 0; i < 10000; ++i) {
+        const int key = (i * 7 + t) % kKeys;
+        if (const auto value = cache.Get(key)) {
+          EXPECT_EQ(*value, key);
+        } else {
+          cache.Put(key, Value(key), cache.generation());
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_LE(cache.size(), kKeys / 2);
+  const auto stats = cache.stats();
+  EXPECT_EQ(stats.hits + stats.misses, kThreads * 10000);
+}
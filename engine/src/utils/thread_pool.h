@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "utils/blocking_queue.h"
+
+namespace utils {
+
+// Fixed set of workers running tasks in submission order. A task must not
+// wait for a later task of the same pool, it may never start.
+class ThreadPool {
+ public:
+  explicit ThreadPool(size_t threads) : tasks_(SIZE_MAX) {
+    threads = std::max<size_t>(threads, 1);
+    for (size_t i = 0; i < threads; ++i) {
+      workers_.emplace_back([this] {
+        while (auto task = tasks_.Pop()) {
+          (*task)();
+        }
+      });
+    }
+  }
+
+  // Runs the queued tasks before returning
+  ~ThreadPool() {
+    tasks_.Close();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // The future rethrows an exception of the task
+  template <typename Task>
+  std::future<std::invoke_result_t<Task>> Submit(Task&& task) {
+    auto packaged =
+        std::make_shared<std::packaged_task<std::invoke_result_t<Task>()>>(
+            std::forward<Task>(task));
+    auto result = packaged->get_future();
+    tasks_.Push([packaged] { (*packaged)(); });
+    return result;
+  }
+
+  size_t size() const { return workers_.size(); }
+
+ private:
+  BlockingQueue<std::function<void()>> tasks_;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace utils
@@ -0,0 +1,57 @@
+#include "utils/thread_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+
+using utils::ThreadPool;
+
+TEST(ThreadPoolTest, ReturnsResultsInSubmissionOrder) {
+  ThreadPool pool(4);
+  std::vector<std::future<int>> results;
+  for (int i = 0; i < 100; ++i) {
+    results.push_back(pool.Submit([i] { return i * i; }));
+  }
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(results[i].get(), i * i);
+  }
+}
+
+TEST(ThreadPoolTest, RunsTasksConcurrently) {
+  ThreadPool pool(2);
+  std::atomic<int> started = 0;
+  // Each task waits for the other one to start
+  const auto task = [&started] {
+    ++started;
+    while (started < 2) {
+      std::this_thread::yield();
+    }
+  };
+  auto first = pool.Submit(task);
+  auto second = pool.Submit(task);
+  EXPECT_EQ(first.wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+  EXPECT_EQ(second.wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+}
+
+TEST(ThreadPoolTest, PropagatesExceptions) {
+  ThreadPool pool(1);
+  auto failed = pool.Submit([]() -> int { throw std::runtime_error("task"); });
+  auto next = pool.Submit([] { return 1; });
+  EXPECT_THROW(failed.get(), std::runtime_error);
+  EXPECT_EQ(next.get(), 1);
+}
+
+TEST(ThreadPoolTest, FinishesQueuedTasksOnDestruction) {
+  std::atomic<int> done = 0;
+  {
+    ThreadPool pool(1);
+    for (int i = 0; i < 10; ++i) {
+      pool.Submit([&done] { ++done; });
+    }
+  }
+  EXPECT_EQ(done, 10);
+}